@@ -0,0 +1,124 @@
+/**
+ * @file Scenes.cpp
+ * @brief Implementation of the benchmark scene generators.
+ */
+
+#include "Scenes.hpp"
+#include "Simulation.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    /// World area per particle (px²) for the spread-out scenes
+    const float AREA_PER_PARTICLE = 400.0f;
+    const float TWO_PI = 6.283185307f;
+
+    Color randomColor(Random& rng) {
+        return Color(rng.uniform(0.3f, 1.0f), rng.uniform(0.3f, 1.0f), rng.uniform(0.3f, 1.0f), 1.0f);
+    }
+
+    /// Square world holding count particles at the standard density
+    void sizeWorld(Simulation& sim, size_t count) {
+        float side = std::max(256.0f, std::sqrt(AREA_PER_PARTICLE * (float)count));
+        sim.worldW = side;
+        sim.worldH = side;
+    }
+
+    void gas(Simulation& sim, size_t count, Random& rng, float minR, float maxR) {
+        sizeWorld(sim, count);
+        const float logMin = std::log(minR), logMax = std::log(maxR);
+        for (size_t i = 0; i < count; ++i) {
+            float r = (minR == maxR) ? minR : std::exp(rng.uniform(logMin, logMax));
+            Vec2 pos(rng.uniform(r, sim.worldW - r), rng.uniform(r, sim.worldH - r));
+            Vec2 vel(rng.uniform(-150.0f, 150.0f), rng.uniform(-150.0f, 150.0f));
+            sim.particles.add(Particle(pos, vel, r, randomColor(rng)));
+        }
+    }
+
+    /// Gas of small particles with one in BOULDER_EVERY much larger
+    void boulders(Simulation& sim, size_t count, Random& rng) {
+        const size_t BOULDER_EVERY = 200;
+        sizeWorld(sim, count);
+        for (size_t i = 0; i < count; ++i) {
+            float r = (i % BOULDER_EVERY == 0) ? 48.0f : 2.0f;
+            Vec2 pos(rng.uniform(r, sim.worldW - r), rng.uniform(r, sim.worldH - r));
+            Vec2 vel(rng.uniform(-150.0f, 150.0f), rng.uniform(-150.0f, 150.0f));
+            sim.particles.add(Particle(pos, vel, r, randomColor(rng)));
+        }
+    }
+
+    void pile(Simulation& sim, size_t count, Random& rng) {
+        const float r = 3.5f;
+        sizeWorld(sim, count);
+        sim.drag = 0.5f;
+        // Hexagonal-ish rows from the floor up, slightly jittered and overlapping
+        const float spacing = 1.9f * r;
+        const int perRow = std::max(1, (int)((sim.worldW - 2.0f * r) / spacing));
+        for (size_t i = 0; i < count; ++i) {
+            int row = (int)(i / perRow), col = (int)(i % perRow);
+            float x = r + col * spacing + (row % 2 ? 0.5f * spacing : 0.0f) + rng.uniform(-0.3f, 0.3f);
+            float y = sim.worldH - r - row * spacing * 0.87f;
+            x = clamp(x, r, sim.worldW - r);
+            y = std::max(y, r);
+            Vec2 vel(rng.uniform(-5.0f, 5.0f), rng.uniform(-5.0f, 5.0f));
+            sim.particles.add(Particle(Vec2(x, y), vel, r, randomColor(rng)));
+        }
+    }
+
+    void ring(Simulation& sim, size_t count, Random& rng) {
+        sizeWorld(sim, count);
+        const Vec2 centre(sim.worldW * 0.5f, sim.worldH * 0.5f);
+        for (int w = 0; w < 4; ++w) {
+            float a = TWO_PI * (float)w / 4.0f;
+            sim.addGravityWell(centre.x + 20.0f * std::cos(a), centre.y + 20.0f * std::sin(a));
+        }
+        const float inner = 0.15f * sim.worldW, outer = 0.45f * sim.worldW;
+        for (size_t i = 0; i < count; ++i) {
+            float a = rng.uniform(0.0f, TWO_PI);
+            // Uniform over the annulus area
+            float rad = std::sqrt(rng.uniform(inner * inner, outer * outer));
+            Vec2 pos(centre.x + rad * std::cos(a), centre.y + rad * std::sin(a));
+            float speed = std::sqrt(4.0f * 400.0f * rad) * rng.uniform(0.8f, 1.0f);  // Roughly circular for the constant pull
+            Vec2 vel(-std::sin(a) * speed, std::cos(a) * speed);
+            sim.particles.add(Particle(pos, vel, 2.5f, randomColor(rng)));
+        }
+    }
+}
+
+const char* sceneName(Scene scene) {
+    switch (scene) {
+        case Scene::Gas:   return "gas";
+        case Scene::Pile:  return "pile";
+        case Scene::Ring:  return "ring";
+        case Scene::Mixed: return "mixed";
+        case Scene::Boulders: return "boulders";
+    }
+    return "?";
+}
+
+bool parseScene(const char* name, Scene& out) {
+    const Scene all[] = { Scene::Gas, Scene::Pile, Scene::Ring, Scene::Mixed, Scene::Boulders };
+    for (Scene s : all) {
+        if (std::strcmp(name, sceneName(s)) == 0) {
+            out = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+void generateScene(Simulation& sim, Scene scene, size_t count, uint64_t seed) {
+    sim.clear();
+    sim.drag = 0.0f;
+    sim.particles.reserve(count);
+    Random rng(seed);
+    switch (scene) {
+        case Scene::Gas:   gas(sim, count, rng, 3.5f, 3.5f); break;
+        case Scene::Pile:  pile(sim, count, rng); break;
+        case Scene::Ring:  ring(sim, count, rng); break;
+        case Scene::Mixed: gas(sim, count, rng, 1.5f, 12.0f); break;
+        case Scene::Boulders: boulders(sim, count, rng); break;
+    }
+}
@@ -0,0 +1,541 @@
+/**
+ * @file orb_bench.cpp
+ * @brief Headless benchmark of Simulation::update over seeded scenes.
+ *
+ * Needs no window, GL context or font, so it runs on CI and servers. Each
+ * run generates a scene from its seed, warms up, then times a fixed number
+ * of steps and reports per-step percentiles, ns per particle per step and
+ * narrow-phase pair tests per step. --trace also records the per-phase
+ * timers and writes them as Chrome trace JSON. --save writes each generated
+ * start state to a scene file; --load benchmarks a saved scene instead of
+ * generating one. --record streams the timed steps to a trajectory file,
+ * so the recorder's cost shows up in the step times. --no-sleep keeps
+ * every particle awake, to compare against the settled-scene shortcut,
+ * --ccd turns on the sweep of fast particles (swept column),
+ * --no-reorder keeps particles in spawn order instead of Z-order,
+ * --no-trails skips the trail history, as a headless run needs none, and
+ * --trail-length L sets the samples per trail. The bytes/p column is the
+ * particle store's memory (columns, slot map, trails) per particle, each
+ * run on a fresh Simulation so no earlier run's capacity is counted.
+ * --emit R adds R particles per second over the whole world through an
+ * area emitter and Simulation::spawnBatch(), timed with the step.
+ * --tiles XxY steps the scene as a TiledSimulation of X x Y tiles (tiles
+ * run on the --threads pool, each tile serially); the ghosts and migrated
+ * columns then show the halo and migration traffic per step.
+ * --csv FILE writes one row per timed step with every SimulationStats
+ * counter (pair tests, contacts, wall hits, sleepers, grid occupancy,
+ * kinetic energy and its change) next to the step time, for scaling plots.
+ * --check times nothing: it steps each scene --steps times (default 240,
+ * long enough for a pile to fall asleep) through every backend (grid,
+ * sweep and prune and brute force, on one thread and on --threads, with
+ * CCD, and tiled as --tiles or 2x2) and compares each with the serial
+ * brute-force run. Particle counts must match exactly; contacts per awake
+ * particle and step, the fraction asleep at the end, kinetic energy
+ * (relative to the first step's) and the mass-weighted centre (which
+ * collisions conserve in whatever order they are resolved; relative to the
+ * world's diagonal) within a tolerance, as is the penetration left after
+ * each step, which grows when a backend misses pairs (a ghost that never
+ * arrived, or a pair skipped as asleep, say). Contacts are counted per
+ * awake particle because the resolution order decides how fast a pile
+ * settles, and so how many steps it spends awake. The exit status is 1 if
+ * any backend is out of tolerance.
+ *
+ * Usage: orb_bench [--scene gas|pile|ring|mixed|boulders|all] [-n N[,N...]] [--steps S]
+ *                  [--warmup W] [--threads T] [--seed S] [--mode grid|sap|brute] [--nbody]
+ *                  [--no-sleep] [--ccd] [--no-reorder] [--no-trails] [--trail-length L]
+ *                  [--emit R] [--tiles XxY] [--csv steps.csv] [--check]
+ *                  [--trace out.json] [--save scene.bin | --load scene.bin] [--record out.traj]
+ */
+
+#include "Simulation.hpp"
+#include "TiledSimulation.hpp"
+#include "Scenes.hpp"
+#include "Profiler.hpp"
+#include "SceneFile.hpp"
+#include "Recorder.hpp"
+#include "Emitter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<Scene> scenes = { Scene::Gas, Scene::Pile, Scene::Ring, Scene::Mixed, Scene::Boulders };
+    std::vector<size_t> counts = { 10000 };
+    int steps = 0;      ///< 0 = DEFAULT_STEPS, or CHECK_STEPS with --check
+    int warmup = 20;
+    int threads = 1;
+    uint64_t seed = 1;
+    CollisionMode mode = CollisionMode::Grid;
+    bool nbody = false;
+    bool sleeping = true;
+    bool ccd = false;
+    bool reorder = true;
+    bool trails = true;
+    bool check = false;
+    int trailLength = TrailBuffer::DEFAULT_LENGTH;
+    float emitRate = 0.0f;
+    int tilesX = 1;
+    int tilesY = 1;
+    const char* tracePath = nullptr;
+    const char* savePath = nullptr;
+    const char* loadPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* csvPath = nullptr;
+};
+
+const float STEP_DT = 1.0f / 60.0f;
+/// Timed steps per run, and steps per --check run (several SLEEP_STEPS, so
+/// settling scenes are asleep by the end and the sleep path is compared too)
+const int DEFAULT_STEPS = 200;
+const int CHECK_STEPS = 4 * Simulation::SLEEP_STEPS;
+
+const char* modeName(CollisionMode mode) {
+    switch (mode) {
+        case CollisionMode::Grid:          return "grid";
+        case CollisionMode::BruteForce:    return "brute";
+        case CollisionMode::SweepAndPrune: return "sap";
+    }
+    return "?";
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: orb_bench [--scene gas|pile|ring|mixed|boulders|all] [-n N[,N...]] [--steps S]\n"
+        "                 [--warmup W] [--threads T] [--seed S] [--mode grid|sap|brute] [--nbody]\n"
+        "                 [--no-sleep] [--ccd] [--no-reorder] [--no-trails] [--trail-length L]\n"
+        "                 [--emit R] [--tiles XxY] [--csv steps.csv] [--check]\n"
+        "                 [--trace out.json] [--save scene.bin | --load scene.bin] [--record out.traj]\n");
+}
+
+bool parseArgs(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(a, "--scene") == 0 && hasValue) {
+            const char* name = argv[++i];
+            Scene s;
+            if (std::strcmp(name, "all") == 0)
+                opt.scenes = Options().scenes;
+            else if (parseScene(name, s))
+                opt.scenes = { s };
+            else
+                return false;
+        } else if (std::strcmp(a, "-n") == 0 && hasValue) {
+            opt.counts.clear();
+            for (char* p = argv[++i]; *p;) {
+                opt.counts.push_back((size_t)std::strtoull(p, &p, 10));
+                if (*p == ',') ++p;
+                else if (*p) return false;
+            }
+        } else if (std::strcmp(a, "--steps") == 0 && hasValue) {
+            opt.steps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(a, "--warmup") == 0 && hasValue) {
+            opt.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(a, "--threads") == 0 && hasValue) {
+            opt.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(a, "--seed") == 0 && hasValue) {
+            opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(a, "--mode") == 0 && hasValue) {
+            const char* m = argv[++i];
+            if (std::strcmp(m, "grid") == 0) opt.mode = CollisionMode::Grid;
+            else if (std::strcmp(m, "brute") == 0) opt.mode = CollisionMode::BruteForce;
+            else if (std::strcmp(m, "sap") == 0) opt.mode = CollisionMode::SweepAndPrune;
+            else return false;
+        } else if (std::strcmp(a, "--emit") == 0 && hasValue) {
+            opt.emitRate = (float)std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(a, "--tiles") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &opt.tilesX, &opt.tilesY) != 2
+                || opt.tilesX < 1 || opt.tilesY < 1)
+                return false;
+        } else if (std::strcmp(a, "--csv") == 0 && hasValue) {
+            opt.csvPath = argv[++i];
+        } else if (std::strcmp(a, "--trace") == 0 && hasValue) {
+            opt.tracePath = argv[++i];
+        } else if (std::strcmp(a, "--save") == 0 && hasValue) {
+            opt.savePath = argv[++i];
+        } else if (std::strcmp(a, "--load") == 0 && hasValue) {
+            opt.loadPath = argv[++i];
+        } else if (std::strcmp(a, "--record") == 0 && hasValue) {
+            opt.recordPath = argv[++i];
+        } else if (std::strcmp(a, "--nbody") == 0) {
+            opt.nbody = true;
+        } else if (std::strcmp(a, "--no-sleep") == 0) {
+            opt.sleeping = false;
+        } else if (std::strcmp(a, "--ccd") == 0) {
+            opt.ccd = true;
+        } else if (std::strcmp(a, "--no-reorder") == 0) {
+            opt.reorder = false;
+        } else if (std::strcmp(a, "--trail-length") == 0 && hasValue) {
+            opt.trailLength = std::atoi(argv[++i]);
+        } else if (std::strcmp(a, "--no-trails") == 0) {
+            opt.trails = false;
+        } else if (std::strcmp(a, "--check") == 0) {
+            opt.check = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Nearest-rank percentile of an ascending-sorted sample
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+/// Apply the command-line settings to a generated or loaded scene
+void configure(Simulation& sim, const Options& opt) {
+    sim.collisionMode = opt.mode;
+    sim.nbody = opt.nbody;
+    sim.sleeping = opt.sleeping;
+    sim.continuousCollisions = opt.ccd;
+    sim.spatialReorder = opt.reorder;
+    sim.trails = opt.trails;
+    sim.trailLength = opt.trailLength;
+}
+
+/// Column names of the --csv output, matching writeCsvRow()
+const char* const CSV_HEADER =
+    "scene,n,threads,step,ms,pair_tests,contacts,swept_contacts,wall_hits,sleeping,swept,"
+    "reordered,occupied_cells,particles_per_cell,kinetic,kinetic_change\n";
+
+void writeCsvRow(std::FILE* csv, const char* label, size_t count, int threads, int step, double ms,
+                 const SimulationStats& s) {
+    std::fprintf(csv, "%s,%zu,%d,%d,%.4f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%.10g,%.10g\n",
+                 label, count, threads, step, ms,
+                 (unsigned long long)s.pairTests, (unsigned long long)s.contacts,
+                 (unsigned long long)s.sweptContacts, (unsigned long long)s.wallHits,
+                 (unsigned long long)s.sleeping, (unsigned long long)s.sweptParticles,
+                 (unsigned long long)s.reordered, (unsigned long long)s.occupiedCells,
+                 s.particlesPerCell(), s.kineticEnergy, s.kineticChange);
+}
+
+/**
+ * @brief Warm up and time backend from its current state, then print one table row.
+ * @param recorded backend as a Simulation when it is one (recording needs the columns)
+ * @param csv Per-step counters go here when non-null
+ */
+void measure(SimulationBackend& backend, Vec2 world, const Options& opt, const char* label,
+             const Simulation* recorded, Recorder* recorder, const TiledSimulation* tiled,
+             std::FILE* csv) {
+    using Clock = std::chrono::steady_clock;
+
+    const size_t count = backend.particleCount();
+    Emitter emitter(EmitterShape::Area, Vec2(0.0f, 0.0f), world, opt.emitRate);
+    std::vector<Particle> batch;
+    auto step = [&]() {
+        if (opt.emitRate > 0.0f) {
+            batch.clear();
+            emitter.emit(STEP_DT, batch);
+            backend.spawnBatch(batch);
+        }
+        backend.step(STEP_DT);
+    };
+
+    for (int s = 0; s < opt.warmup; ++s)
+        step();
+
+    std::vector<double> stepMs(opt.steps);
+    double pairTests = 0.0;
+    double swept = 0.0;
+    double ghosts = 0.0;
+    double migrated = 0.0;
+    for (int s = 0; s < opt.steps; ++s) {
+        Clock::time_point t0 = Clock::now();
+        step();
+        if (recorder && recorded) recorder->push(*recorded, (uint64_t)s + 1, STEP_DT);
+        stepMs[s] = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        const SimulationStats stats = backend.stepStats();
+        if (csv) writeCsvRow(csv, label, backend.particleCount(), backend.threadCount(), s, stepMs[s], stats);
+        pairTests += (double)stats.pairTests;
+        swept += (double)stats.sweptParticles;
+        if (tiled) {
+            ghosts += (double)tiled->ghostCount();
+            migrated += (double)tiled->migratedCount();
+        }
+    }
+
+    double total = 0.0;
+    for (double ms : stepMs) total += ms;
+    const double mean = total / opt.steps;
+    std::sort(stepMs.begin(), stepMs.end());
+
+    const size_t live = std::max<size_t>(backend.particleCount(), 1);
+    std::printf("%-6s %9zu %7d %10.3f %10.2f %14.0f %9.3f %9.3f %9.3f %9.3f %7.1f%% %8.0f %8.0f",
+                label, count, backend.threadCount(), mean,
+                mean * 1.0e6 / (double)std::max<size_t>(count, 1),
+                pairTests / opt.steps,
+                percentile(stepMs, 50.0), percentile(stepMs, 90.0),
+                percentile(stepMs, 99.0), stepMs.back(),
+                100.0 * (double)backend.stepStats().sleeping / (double)std::max<size_t>(count, 1),
+                swept / opt.steps,
+                (double)backend.memoryBytes() / (double)live);
+    if (tiled)
+        std::printf(" %8.0f %8.1f", ghosts / opt.steps, migrated / opt.steps);
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+/// Configure sim and time it directly, or split into opt's tiles
+void run(Simulation& sim, const Options& opt, const char* label, Recorder* recorder, std::FILE* csv) {
+    configure(sim, opt);
+    const Vec2 world(sim.worldW, sim.worldH);
+    if (opt.tilesX * opt.tilesY == 1) {
+        measure(sim, world, opt, label, &sim, recorder, nullptr, csv);
+        return;
+    }
+    TiledSimulation tiled(sim.worldW, sim.worldH, opt.tilesX, opt.tilesY);
+    tiled.setThreadCount(opt.threads);
+    tiled.load(sim);
+    measure(tiled, world, opt, label, nullptr, nullptr, &tiled, csv);
+}
+
+/// A backend's state after the --check steps
+struct CheckResult {
+    size_t particles = 0;
+    double contacts = 0.0;      ///< Summed over the steps
+    double awake = 0.0;         ///< Awake particles, summed over the steps
+    double asleep = 0.0;        ///< Fraction asleep after the last step
+    double kinetic = 0.0;
+    double firstKinetic = 0.0;  ///< After the first step
+    double overlap = 0.0;       ///< Penetration left after each step, summed over pairs and steps (px)
+    Vec2 centre;                ///< Mass-weighted (r²) mean position
+};
+
+/// Relative difference, against a floor so values near zero compare absolutely
+double relativeError(double value, double reference, double floor) {
+    return std::fabs(value - reference) / std::max(std::fabs(reference), floor);
+}
+
+/// Largest relative error in contacts per awake particle and step and in kinetic
+/// energy, difference in the fraction asleep, and centre distance per world
+/// diagonal still accepted (wall bounces do not conserve the centre, so it
+/// drifts apart over a long run)
+const double CHECK_CONTACT_TOLERANCE = 0.05;
+const double CHECK_ASLEEP_TOLERANCE = 0.05;
+const double CHECK_KINETIC_TOLERANCE = 0.05;
+const float CHECK_CENTRE_TOLERANCE = 2.5e-3f;
+/// Largest relative error in the penetration left after the steps (a missed pair leaves its overlap)
+const double CHECK_OVERLAP_TOLERANCE = 0.5;
+
+/// Summed penetration of every overlapping pair in s, by a sweep along x
+double residualOverlap(const ParticleSample& s, std::vector<uint32_t>& order) {
+    const size_t n = s.x.size();
+    order.resize(n);
+    float maxR = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        order[i] = (uint32_t)i;
+        maxR = std::max(maxR, s.radius[i]);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return s.x[a] < s.x[b]; });
+    double depth = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t a = order[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            const uint32_t b = order[j];
+            if (s.x[b] - s.x[a] > s.radius[a] + maxR) break;
+            const float dx = s.x[b] - s.x[a], dy = s.y[b] - s.y[a];
+            const float sumR = s.radius[a] + s.radius[b];
+            const float distSq = dx * dx + dy * dy;
+            if (distSq < sumR * sumR) depth += sumR - std::sqrt(distSq);
+        }
+    }
+    return depth;
+}
+
+CheckResult checkSteps(SimulationBackend& backend, int steps) {
+    CheckResult r;
+    ParticleSample all;
+    std::vector<uint32_t> order;
+    for (int s = 0; s < steps; ++s) {
+        backend.step(STEP_DT);
+        r.contacts += (double)backend.stepStats().contacts;
+        r.awake += (double)(backend.particleCount() - backend.stepStats().sleeping);
+        if (s == 0) r.firstKinetic = backend.stepStats().kineticEnergy;
+        backend.sample(all, backend.particleCount());
+        r.overlap += residualOverlap(all, order);
+    }
+    r.particles = backend.particleCount();
+    r.kinetic = backend.stepStats().kineticEnergy;
+    if (r.particles > 0) r.asleep = (double)backend.stepStats().sleeping / (double)r.particles;
+
+    double mass = 0.0, mx = 0.0, my = 0.0;
+    for (size_t i = 0; i < all.x.size(); ++i) {
+        const double m = (double)all.radius[i] * all.radius[i];
+        mass += m;
+        mx += m * all.x[i];
+        my += m * all.y[i];
+    }
+    if (mass > 0.0) r.centre = Vec2((float)(mx / mass), (float)(my / mass));
+    return r;
+}
+
+/// One backend of the --check matrix: a plain Simulation, or tiled when tilesX * tilesY > 1
+struct CheckBackend {
+    const char* name;
+    CollisionMode mode;
+    int threads;
+    bool ccd;
+    int tilesX, tilesY;
+};
+
+/**
+ * @brief Step scene through every backend and compare each with the serial brute-force run.
+ * @return false if any backend is out of tolerance
+ */
+bool checkScene(Scene scene, size_t count, const Options& opt) {
+    const int threads = std::max(opt.threads, 2);
+    const int tilesX = opt.tilesX * opt.tilesY > 1 ? opt.tilesX : 2;
+    const int tilesY = opt.tilesX * opt.tilesY > 1 ? opt.tilesY : 2;
+    const CheckBackend backends[] = {
+        { "brute",    CollisionMode::BruteForce,    1,       false, 1, 1 },
+        { "brute",    CollisionMode::BruteForce,    threads, false, 1, 1 },
+        { "grid",     CollisionMode::Grid,          1,       false, 1, 1 },
+        { "grid",     CollisionMode::Grid,          threads, false, 1, 1 },
+        { "sap",      CollisionMode::SweepAndPrune, 1,       false, 1, 1 },
+        { "sap",      CollisionMode::SweepAndPrune, threads, false, 1, 1 },
+        { "grid+ccd", CollisionMode::Grid,          threads, true,  1, 1 },
+        { "tiled",    CollisionMode::Grid,          threads, false, tilesX, tilesY },
+    };
+
+    bool ok = true;
+    CheckResult ref;
+    for (const CheckBackend& b : backends) {
+        Simulation sim;
+        generateScene(sim, scene, count, opt.seed);
+        configure(sim, opt);
+        sim.collisionMode = b.mode;
+        sim.continuousCollisions = b.ccd;
+        sim.setThreadCount(b.tilesX * b.tilesY > 1 ? 1 : b.threads);
+
+        CheckResult r;
+        if (b.tilesX * b.tilesY > 1) {
+            TiledSimulation tiled(sim.worldW, sim.worldH, b.tilesX, b.tilesY);
+            tiled.setThreadCount(b.threads);
+            tiled.load(sim);
+            r = checkSteps(tiled, opt.steps);
+        } else {
+            r = checkSteps(sim, opt.steps);
+        }
+        const bool isRef = &b == &backends[0];
+        if (isRef) ref = r;
+
+        const double contactErr = relativeError(r.contacts / std::max(r.awake, 1.0),
+                                                ref.contacts / std::max(ref.awake, 1.0), 1.0e-3);
+        const double asleepErr = std::fabs(r.asleep - ref.asleep);
+        // Against the energy in play: a settled pile's last few moving particles
+        // are chaotic, and near zero any difference would be a large ratio
+        // (the floor stays positive for an empty world)
+        const double kineticErr = relativeError(r.kinetic, ref.kinetic, std::max(ref.firstKinetic, 1.0e-9));
+        const float centreErr = (r.centre - ref.centre).length() / Vec2(sim.worldW, sim.worldH).length();
+        const double overlapErr = relativeError(r.overlap, ref.overlap, 1.0);
+        const bool pass = r.particles == ref.particles && contactErr <= CHECK_CONTACT_TOLERANCE
+                       && asleepErr <= CHECK_ASLEEP_TOLERANCE
+                       && kineticErr <= CHECK_KINETIC_TOLERANCE && centreErr <= CHECK_CENTRE_TOLERANCE
+                       && overlapErr <= CHECK_OVERLAP_TOLERANCE;
+        ok = ok && pass;
+        char config[32];
+        if (b.tilesX * b.tilesY > 1)
+            std::snprintf(config, sizeof(config), "%s %dx%d", b.name, b.tilesX, b.tilesY);
+        else
+            std::snprintf(config, sizeof(config), "%s", b.name);
+        std::printf("%-8s %9zu %-10s %7d %9zu %12.0f %9.4f%% %7.1f%% %9.4f%% %9.4f%% %9.2f%% %s\n",
+                    sceneName(scene), count, config, b.threads, r.particles, r.contacts,
+                    100.0 * contactErr, 100.0 * r.asleep, 100.0 * kineticErr, 100.0 * centreErr, 100.0 * overlapErr,
+                    isRef ? "reference" : pass ? "ok" : "FAIL");
+    }
+    std::fflush(stdout);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    using Clock = std::chrono::steady_clock;
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+    if (opt.steps == 0) opt.steps = opt.check ? CHECK_STEPS : DEFAULT_STEPS;
+
+    Profiler::setEnabled(opt.tracePath != nullptr);
+    Recorder recorder;
+    if (opt.recordPath && !recorder.open(opt.recordPath)) return 1;
+    std::FILE* csv = nullptr;
+    if (opt.csvPath) {
+        csv = std::fopen(opt.csvPath, "w");
+        if (!csv) {
+            std::fprintf(stderr, "Cannot write %s\n", opt.csvPath);
+            return 1;
+        }
+        std::fputs(CSV_HEADER, csv);
+    }
+
+    if (opt.check) {
+        std::printf("# orb_bench --check seed=%llu steps=%d\n%-8s %9s %-10s %7s %9s %12s %10s %8s %10s %10s %10s\n",
+                    (unsigned long long)opt.seed, opt.steps, "scene", "N", "backend", "threads",
+                    "particles", "contacts", "d_contact", "asleep", "d_kinetic", "d_centre", "d_overlap");
+        bool ok = true;
+        for (Scene scene : opt.scenes)
+            for (size_t count : opt.counts)
+                ok = checkScene(scene, count, opt) && ok;
+        std::printf("# check %s\n", ok ? "passed" : "FAILED");
+        return ok ? 0 : 1;
+    }
+
+    const bool tiles = opt.tilesX * opt.tilesY > 1;
+    if (tiles && opt.recordPath) {
+        std::fprintf(stderr, "--record cannot be combined with --tiles\n");
+        return 1;
+    }
+
+    std::printf("# orb_bench seed=%llu steps=%d warmup=%d mode=%s%s%s%s%s%s",
+                (unsigned long long)opt.seed, opt.steps, opt.warmup,
+                modeName(opt.mode), opt.nbody ? " nbody" : "",
+                opt.sleeping ? "" : " no-sleep", opt.ccd ? " ccd" : "",
+                opt.reorder ? "" : " no-reorder", opt.trails ? "" : " no-trails");
+    if (tiles) std::printf(" tiles=%dx%d", opt.tilesX, opt.tilesY);
+    std::printf("\n%-6s %9s %7s %10s %10s %14s %9s %9s %9s %9s %8s %8s %8s",
+                "scene", "N", "threads", "mean_ms", "ns/p/step", "pairs/step",
+                "p50_ms", "p90_ms", "p99_ms", "max_ms", "asleep", "swept", "bytes/p");
+    if (tiles) std::printf(" %8s %8s", "ghosts", "migrated");
+    std::printf("\n");
+    if (opt.loadPath) {
+        Simulation sim;
+        sim.setThreadCount(opt.threads);
+        Clock::time_point t0 = Clock::now();
+        if (!loadScene(sim, opt.loadPath)) return 1;
+        std::printf("# loaded %zu particles in %.3f ms\n", sim.particles.size(),
+                    std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        run(sim, opt, "file", recorder.isOpen() ? &recorder : nullptr, csv);
+    } else {
+        for (Scene scene : opt.scenes) {
+            for (size_t count : opt.counts) {
+                // A fresh Simulation per run: bytes/p counts reserved capacity,
+                // which a larger earlier run would otherwise leave behind
+                Simulation sim;
+                sim.setThreadCount(opt.threads);
+                generateScene(sim, scene, count, opt.seed);
+                if (opt.savePath && !saveScene(sim, opt.savePath)) return 1;
+                run(sim, opt, sceneName(scene), recorder.isOpen() ? &recorder : nullptr, csv);
+            }
+        }
+    }
+
+    if (csv) std::fclose(csv);
+    if (recorder.isOpen()) {
+        recorder.close();
+        std::printf("# recorded %.1f MB to %s\n", (double)recorder.bytesWritten() / 1.0e6, opt.recordPath);
+    }
+    if (opt.tracePath && !Profiler::instance().writeChromeTrace(opt.tracePath))
+        return 1;
+    return 0;
+}
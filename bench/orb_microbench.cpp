@@ -0,0 +1,457 @@
+/**
+ * @file orb_microbench.cpp
+ * @brief Kernel-level micro-benchmarks with JSON output and a regression gate.
+ *
+ * orb_bench times whole steps; this times the pieces a step is made of, on
+ * synthetic columns of N particles, so a change to one kernel shows up on
+ * its own instead of inside the noise of a full step:
+ *
+ * - vec2.length, vec2.normalized: Math.hpp over an array of vectors
+ * - rsqrt.sqrt, rsqrt.fast (and rsqrt.sse where SSE is available): 1/sqrt(x) variants
+ * - narrow.resolve: resolveCollision() over neighbour pairs of a jittered lattice
+ *   where about half the pairs overlap (items are pairs)
+ * - gravity.scalar, gravity.<isa>: the well-gravity kernels against 4 wells
+ * - integrate, integrate.trails: integrateRange() without and with trail recording
+ * - settle: settleRange() with drag and sleeping
+ *
+ * Each case runs --reps timed repetitions, each long enough (about 2 ms) to
+ * swamp the clock; kernels that change their input have it restored
+ * before every call, outside the timed region. Both the median and the
+ * fastest repetition are reported, in ns per item.
+ *
+ * --json FILE writes the results; --compare FILE reads a file written that
+ * way (typically by the parent commit's build) and flags every case whose
+ * fastest repetition got slower by more than --threshold (default 0.10 =
+ * 10%). The fastest repetition is the one least disturbed by the rest of
+ * the machine, so it moves far less between identical runs than the
+ * median does. The exit status is 2 when anything regressed. Cases
+ * well under a nanosecond per item still jitter by tens of percent on a
+ * shared or frequency-scaling machine: gate those hosts with a looser
+ * threshold, or run the comparison on a quiet pinned core.
+ *
+ * Usage: orb_microbench [-n N[,N...]] [--reps R] [--filter SUBSTR] [--seed S]
+ *                       [--json out.json] [--compare base.json] [--threshold F]
+ */
+
+#include "Collision.hpp"
+#include "GravityKernel.hpp"
+#include "Math.hpp"
+#include "ParticleStore.hpp"
+#include "Random.hpp"
+#include "SimulationStep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ORB_MICRO_SSE 1
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<size_t> counts = { 1024, 16384, 262144 };
+    int reps = 11;
+    uint64_t seed = 1;
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    const char* comparePath = nullptr;
+    double threshold = 0.10;
+};
+
+/// Shortest timed repetition; kernels are repeated within one until it is reached
+const double MIN_REP_SECONDS = 0.002;
+const float STEP_DT = 1.0f / 60.0f;
+const float RADIUS = 4.0f;
+
+/** One kernel to time at one N. */
+struct Case {
+    std::string name;
+    size_t items = 0;             ///< Units of work per run() (particles or pairs)
+    std::function<void()> reset;  ///< Restore the input before each run(); empty if run() leaves it alone
+    std::function<void()> run;
+};
+
+struct Result {
+    std::string name;
+    size_t n = 0;
+    double nsPerItem = 0.0;      ///< Median over the repetitions
+    double minNsPerItem = 0.0;
+    int reps = 0;
+};
+
+/// Written from every kernel's output so none of them can be optimized away
+volatile float sink = 0.0f;
+
+/** Particle columns, with a saved copy to restore between runs. */
+struct Columns {
+    std::vector<float> x, y, vx, vy, r;
+    std::vector<uint8_t> rest;
+    std::vector<float> x0, y0, vx0, vy0;
+    std::vector<uint8_t> rest0;
+
+    ParticleColumns view(bool sleep = false) {
+        return ParticleColumns{ x.data(), y.data(), vx.data(), vy.data(), r.data(), sleep ? rest.data() : nullptr };
+    }
+    void save() {
+        x0 = x; y0 = y; vx0 = vx; vy0 = vy; rest0 = rest;
+    }
+    void restore() {
+        std::copy(x0.begin(), x0.end(), x.begin());
+        std::copy(y0.begin(), y0.end(), y.begin());
+        std::copy(vx0.begin(), vx0.end(), vx.begin());
+        std::copy(vy0.begin(), vy0.end(), vy.begin());
+        std::copy(rest0.begin(), rest0.end(), rest.begin());
+    }
+};
+
+/// Side of the square world holding n particles of RADIUS at gas density
+float worldSide(size_t n) {
+    return std::max(256.0f, std::sqrt(400.0f * (float)n));
+}
+
+/// n particles spread over the world with random velocities; a few near-rest ones exercise sleep counting
+void fillGas(Columns& c, size_t n, Random& rng) {
+    const float side = worldSide(n);
+    c.x.resize(n); c.y.resize(n); c.vx.resize(n); c.vy.resize(n);
+    c.r.assign(n, RADIUS);
+    c.rest.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        c.x[i] = rng.uniform(0.0f, side);
+        c.y[i] = rng.uniform(0.0f, side);
+        const float speed = (i % 8 == 0) ? 0.1f : 150.0f;
+        c.vx[i] = rng.uniform(-speed, speed);
+        c.vy[i] = rng.uniform(-speed, speed);
+        c.rest[i] = (uint8_t)(i % 64);
+    }
+    c.save();
+}
+
+/**
+ * @brief Square lattice at exactly touching spacing, jittered so about half the neighbour pairs overlap.
+ * @param pairs Each particle with its east, south and south-east neighbours
+ */
+void fillLattice(Columns& c, size_t n, Random& rng, std::vector<std::pair<int, int>>& pairs) {
+    const size_t side = std::max<size_t>(1, (size_t)std::ceil(std::sqrt((double)n)));
+    const float spacing = 2.0f * RADIUS;
+    const float jitter = 0.25f * RADIUS;
+    c.x.resize(n); c.y.resize(n); c.vx.resize(n); c.vy.resize(n);
+    c.r.assign(n, RADIUS);
+    c.rest.assign(n, 0);
+    pairs.clear();
+    for (size_t i = 0; i < n; ++i) {
+        const size_t col = i % side, row = i / side;
+        c.x[i] = (float)col * spacing + rng.uniform(-jitter, jitter);
+        c.y[i] = (float)row * spacing + rng.uniform(-jitter, jitter);
+        c.vx[i] = rng.uniform(-150.0f, 150.0f);
+        c.vy[i] = rng.uniform(-150.0f, 150.0f);
+        if (col + 1 < side && i + 1 < n) pairs.emplace_back((int)i, (int)(i + 1));
+        if (i + side < n) pairs.emplace_back((int)i, (int)(i + side));
+        if (col + 1 < side && i + side + 1 < n) pairs.emplace_back((int)i, (int)(i + side + 1));
+    }
+    c.save();
+}
+
+/** Everything the cases of one N work on; kept alive while they run. */
+struct Fixture {
+    std::vector<Vec2> vecs;
+    std::vector<Vec2> vecOut;
+    std::vector<float> values;
+    std::vector<float> out;
+    Columns gas;
+    Columns lattice;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<GravityWell> wells;
+    GravityParams gravity{};
+    StepParams step;
+    TrailBuffer noTrails;
+    ParticleStore trailed;
+
+    Fixture(size_t n, uint64_t seed) {
+        Random rng(seed);
+        vecs.resize(n);
+        vecOut.resize(n);
+        values.resize(n);
+        out.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            vecs[i] = Vec2(rng.uniform(-100.0f, 100.0f), rng.uniform(-100.0f, 100.0f));
+            values[i] = rng.uniform(1.0e-3f, 1.0e4f);
+        }
+        fillGas(gas, n, rng);
+        fillLattice(lattice, n, rng, pairs);
+
+        const float side = worldSide(n);
+        for (int k = 0; k < 4; ++k)
+            wells.emplace_back(Vec2(rng.uniform(0.0f, side), rng.uniform(0.0f, side)));
+        gravity.pull = 1500.0f;
+        gravity.range = side * 0.5f;
+        gravity.minDistSq = 64.0f;
+
+        step.dt = STEP_DT;
+        step.drag = 0.5f;
+        step.worldW = side;
+        step.worldH = side;
+        step.sleepSteps = Simulation::SLEEP_STEPS;
+        step.sleepSpeed = Simulation::SLEEP_SPEED;
+
+        trailed.trails.spacing = 0.0f;  // Keep every sample, as each run starts from the same positions
+        trailed.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            trailed.add(Particle(Vec2(gas.x0[i], gas.y0[i]), Vec2(gas.vx0[i], gas.vy0[i]), RADIUS, Color()));
+    }
+};
+
+std::vector<Case> makeCases(Fixture& f, size_t n) {
+    std::vector<Case> cases;
+    cases.push_back({ "vec2.length", n, nullptr, [&f, n] {
+        for (size_t i = 0; i < n; ++i) f.out[i] = f.vecs[i].length();
+        sink = f.out[n / 2];
+    } });
+    cases.push_back({ "vec2.normalized", n, nullptr, [&f, n] {
+        for (size_t i = 0; i < n; ++i) f.vecOut[i] = f.vecs[i].normalized();
+        sink = f.vecOut[n / 2].x;
+    } });
+    cases.push_back({ "rsqrt.sqrt", n, nullptr, [&f, n] {
+        for (size_t i = 0; i < n; ++i) f.out[i] = rsqrt(f.values[i]);
+        sink = f.out[n / 2];
+    } });
+    cases.push_back({ "rsqrt.fast", n, nullptr, [&f, n] {
+        for (size_t i = 0; i < n; ++i) f.out[i] = fastRsqrt(f.values[i]);
+        sink = f.out[n / 2];
+    } });
+#if defined(ORB_MICRO_SSE)
+    // Hardware estimate (12 bits) refined by one Newton step, four lanes at a time
+    cases.push_back({ "rsqrt.sse", n, nullptr, [&f, n] {
+        const __m128 half = _mm_set1_ps(0.5f), threeHalves = _mm_set1_ps(1.5f);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m128 v = _mm_loadu_ps(&f.values[i]);
+            const __m128 e = _mm_rsqrt_ps(v);
+            const __m128 r = _mm_mul_ps(e, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, v), _mm_mul_ps(e, e))));
+            _mm_storeu_ps(&f.out[i], r);
+        }
+        for (; i < n; ++i) f.out[i] = rsqrt(f.values[i]);
+        sink = f.out[n / 2];
+    } });
+#endif
+    cases.push_back({ "narrow.resolve", f.pairs.size(), [&f] { f.lattice.restore(); }, [&f] {
+        const ParticleColumns c = f.lattice.view();
+        int contacts = 0;
+        for (const auto& p : f.pairs) contacts += collision::resolveCollision(c, p.first, p.second, 0.9f);
+        sink = (float)contacts;
+    } });
+    cases.push_back({ "gravity.scalar", n, [&f] { f.gas.restore(); }, [&f, n] {
+        applyWellGravityScalar(f.gas.x.data(), f.gas.y.data(), f.gas.vx.data(), f.gas.vy.data(), 0, n,
+                               f.wells.data(), f.wells.size(), f.gravity, STEP_DT);
+        sink = f.gas.vx[n / 2];
+    } });
+    if (std::strcmp(gravityKernelName(), "scalar") != 0) {
+        cases.push_back({ std::string("gravity.") + gravityKernelName(), n, [&f] { f.gas.restore(); }, [&f, n] {
+            applyWellGravity(f.gas.x.data(), f.gas.y.data(), f.gas.vx.data(), f.gas.vy.data(), 0, n,
+                             f.wells.data(), f.wells.size(), f.gravity, STEP_DT);
+            sink = f.gas.vx[n / 2];
+        } });
+    }
+    cases.push_back({ "integrate", n, [&f] { f.gas.restore(); }, [&f, n] {
+        integrateRange<StepPolicy<false, false, false, false>>(f.gas.view(), f.noTrails, f.step, 0, n);
+        sink = f.gas.x[n / 2];
+    } });
+    cases.push_back({ "integrate.trails", n, [&f] {
+        std::copy(f.gas.x0.begin(), f.gas.x0.end(), f.trailed.x.begin());
+        std::copy(f.gas.y0.begin(), f.gas.y0.end(), f.trailed.y.begin());
+    }, [&f, n] {
+        ParticleStore& ps = f.trailed;
+        const ParticleColumns c{ ps.x.data(), ps.y.data(), ps.vx.data(), ps.vy.data(), ps.radius.data(), nullptr };
+        integrateRange<StepPolicy<true, false, false, false>>(c, ps.trails, f.step, 0, n);
+        sink = ps.x[n / 2];
+    } });
+    cases.push_back({ "settle", n, [&f] { f.gas.restore(); }, [&f, n] {
+        const SettleTotals t = settleRange<StepPolicy<false, true, false, true>>(f.gas.view(true), f.step, 0, n);
+        sink = (float)t.kinetic;
+    } });
+    return cases;
+}
+
+double secondsSince(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+/// Wall time of calls runs of c (reset before each one, untimed)
+double timeRuns(const Case& c, int calls) {
+    if (!c.reset) {
+        const Clock::time_point t0 = Clock::now();
+        for (int k = 0; k < calls; ++k) c.run();
+        return secondsSince(t0);
+    }
+    double total = 0.0;
+    for (int k = 0; k < calls; ++k) {
+        c.reset();
+        const Clock::time_point t0 = Clock::now();
+        c.run();
+        total += secondsSince(t0);
+    }
+    return total;
+}
+
+Result measure(const Case& c, size_t n, int reps) {
+    // Calibrate: enough calls per repetition to reach MIN_REP_SECONDS
+    const double once = std::max(timeRuns(c, 1), 1.0e-9);
+    const int calls = (int)std::min(1.0e6, std::max(1.0, std::ceil(MIN_REP_SECONDS / once)));
+    timeRuns(c, calls);  // Warm caches and branch predictors at the measured length
+
+    std::vector<double> nsPerItem((size_t)reps);
+    const double items = (double)std::max<size_t>(c.items, 1) * calls;
+    for (int r = 0; r < reps; ++r)
+        nsPerItem[(size_t)r] = timeRuns(c, calls) * 1.0e9 / items;
+    std::sort(nsPerItem.begin(), nsPerItem.end());
+
+    Result res;
+    res.name = c.name;
+    res.n = n;
+    res.nsPerItem = nsPerItem[nsPerItem.size() / 2];
+    res.minNsPerItem = nsPerItem.front();
+    res.reps = reps;
+    return res;
+}
+
+bool writeJson(const char* path, const std::vector<Result>& results) {
+    std::FILE* f = std::fopen(path, "w");
+    if (!f) {
+        std::fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    // One result per line, so readJson() (and a diff) can take the file line by line
+    std::fprintf(f, "{\n  \"tool\": \"orb_microbench\",\n  \"gravity_kernel\": \"%s\",\n  \"results\": [\n",
+                 gravityKernelName());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(f, "    {\"name\": \"%s\", \"n\": %zu, \"ns_per_item\": %.4f, \"min_ns_per_item\": %.4f, \"reps\": %d}%s\n",
+                     r.name.c_str(), r.n, r.nsPerItem, r.minNsPerItem, r.reps, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+/** @brief Read the results of a file written by writeJson() (not a general JSON parser). */
+bool readJson(const char* path, std::vector<Result>& out) {
+    std::FILE* f = std::fopen(path, "r");
+    if (!f) {
+        std::fprintf(stderr, "Cannot read %s\n", path);
+        return false;
+    }
+    char line[512];
+    while (std::fgets(line, sizeof line, f)) {
+        char name[128];
+        Result r;
+        if (std::sscanf(line, " {\"name\": \"%127[^\"]\", \"n\": %zu, \"ns_per_item\": %lf, \"min_ns_per_item\": %lf, \"reps\": %d",
+                        name, &r.n, &r.nsPerItem, &r.minNsPerItem, &r.reps) == 5) {
+            r.name = name;
+            out.push_back(r);
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+/**
+ * @brief Print each result against its baseline.
+ * @return Number of cases slower than the baseline by more than threshold
+ */
+int compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold) {
+    std::printf("\n# fastest repetition against the baseline (threshold %.0f%%)\n%-20s %9s %12s %12s %9s\n",
+                threshold * 100.0, "case", "N", "base_min_ns", "min_ns", "change");
+    int regressions = 0;
+    for (const Result& r : results) {
+        const auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) {
+            return b.name == r.name && b.n == r.n;
+        });
+        if (base == baseline.end()) {
+            std::printf("%-20s %9zu %12s %12.3f %9s\n", r.name.c_str(), r.n, "-", r.minNsPerItem, "new");
+            continue;
+        }
+        const double change = base->minNsPerItem > 0.0 ? r.minNsPerItem / base->minNsPerItem - 1.0 : 0.0;
+        const bool regressed = change > threshold;
+        regressions += regressed;
+        std::printf("%-20s %9zu %12.3f %12.3f %+8.1f%%%s\n", r.name.c_str(), r.n, base->minNsPerItem,
+                    r.minNsPerItem, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: orb_microbench [-n N[,N...]] [--reps R] [--filter SUBSTR] [--seed S]\n"
+        "                      [--json out.json] [--compare base.json] [--threshold F]\n");
+}
+
+bool parseArgs(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(a, "-n") == 0 && hasValue) {
+            opt.counts.clear();
+            for (char* p = argv[++i]; *p;) {
+                const size_t n = (size_t)std::strtoull(p, &p, 10);
+                if (n == 0) return false;
+                opt.counts.push_back(n);
+                if (*p == ',') ++p;
+                else if (*p) return false;
+            }
+        } else if (std::strcmp(a, "--reps") == 0 && hasValue) {
+            opt.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(a, "--seed") == 0 && hasValue) {
+            opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(a, "--filter") == 0 && hasValue) {
+            opt.filter = argv[++i];
+        } else if (std::strcmp(a, "--json") == 0 && hasValue) {
+            opt.jsonPath = argv[++i];
+        } else if (std::strcmp(a, "--compare") == 0 && hasValue) {
+            opt.comparePath = argv[++i];
+        } else if (std::strcmp(a, "--threshold") == 0 && hasValue) {
+            opt.threshold = std::max(0.0, std::atof(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+    std::vector<Result> baseline;
+    if (opt.comparePath && !readJson(opt.comparePath, baseline)) return 1;
+
+    std::printf("# orb_microbench reps=%d seed=%llu gravity=%s\n%-20s %9s %12s %12s\n",
+                opt.reps, (unsigned long long)opt.seed, gravityKernelName(),
+                "case", "N", "ns/item", "min_ns");
+    std::vector<Result> results;
+    for (size_t n : opt.counts) {
+        Fixture fixture(n, opt.seed);
+        for (const Case& c : makeCases(fixture, n)) {
+            if (opt.filter && c.name.find(opt.filter) == std::string::npos) continue;
+            results.push_back(measure(c, n, opt.reps));
+            const Result& r = results.back();
+            std::printf("%-20s %9zu %12.3f %12.3f\n", r.name.c_str(), r.n, r.nsPerItem, r.minNsPerItem);
+            std::fflush(stdout);
+        }
+    }
+
+    if (opt.jsonPath && !writeJson(opt.jsonPath, results)) return 1;
+    if (opt.comparePath && compare(results, baseline, opt.threshold) > 0) return 2;
+    return 0;
+}
@@ -6,36 +6,47 @@
 #include "App.hpp"
 #include "Renderer.hpp"
 #include "Simulation.hpp"
+#include "SimulationThread.hpp"
 #include "Math.hpp"
 #include "Particle.hpp"
+#include "Profiler.hpp"
+#include "SceneFile.hpp"
+#include "Recorder.hpp"
+#include "Player.hpp"
+#include "GpuSimulation.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
-#include <cstdlib>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
 namespace {
 
-/**
- * @brief Generate a random float in range [0.0, 1.0].
- */
-float randFloat() {
-    return (float)std::rand() / (float)RAND_MAX;
-}
+/** Quick-save slot used by F5 / F9 */
+const char* const SCENE_PATH = "orb_scene.bin";
+/** Fixed steps per frame at most; FrameScheduler lowers this as steps get slower */
+const int MAX_STEPS_PER_FRAME = 8;
+/** Frame-rate cap when the display does not report its refresh rate */
+const float FALLBACK_FRAME_RATE = 60.0f;
+/** Replay seek distance for Left / Right (recorded seconds) */
+const double REPLAY_SEEK_SECONDS = 5.0;
+const int EMITTER_PALETTE = 32;  ///< Colours precomputed per emitter
+const float WHEEL_ZOOM = 1.15f;  ///< Zoom factor per mouse wheel notch
+const float TRAIL_REGION_MARGIN = 0.25f;  ///< Trails are kept this far (in view sizes) past the view edges
 
 /**
  * @brief Generate a random bright color using HSV color space.
  * @return Color with high saturation and value for visibility
  * 
  * Converts HSV to RGB:
- * - Hue: random (0-1)
+ * - Hue: random (0-1), drawn from rng so spawns are reproducible
  * - Saturation: 0.2-1.0 (ensures colorfulness)
  * - Value: 0.85-1.0 (ensures brightness)
  */
-Color randomBrightColor() {
-    float h = randFloat();
-    float s = 0.7f + 0.3f * randFloat();  // Very high saturation for vibrant colors
-    float v = 0.95f + 0.05f * randFloat();   // Very bright for intense glow
+Color randomBrightColor(Random& rng) {
+    float h = rng.uniform();
+    float s = rng.uniform(0.7f, 1.0f);    // Very high saturation for vibrant colors
+    float v = rng.uniform(0.95f, 1.0f);   // Very bright for intense glow
     float r, g, b;
     float c = v * s;
     float x = c * (1.0f - std::fabs(std::fmod(h * 6.0f, 2.0f) - 1.0f));
@@ -49,6 +60,36 @@ Color randomBrightColor() {
     return Color(r + m, g + m, b + m, 1.0f);
 }
 
+/**
+ * @brief Render text once into a white texture for the menu.
+ * @return Empty label if the font is missing or rendering fails
+ */
+MenuLabel makeLabel(SDL_Renderer* renderer, TTF_Font* font, const char* text) {
+    MenuLabel label;
+    if (!font) return label;
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface* surf = TTF_RenderText_Solid(font, text, white);
+    if (!surf) return label;
+    label.texture = SDL_CreateTextureFromSurface(renderer, surf);
+    label.w = surf->w;
+    label.h = surf->h;
+    SDL_FreeSurface(surf);
+    return label;
+}
+
+void destroyLabel(MenuLabel& label) {
+    if (label.texture) SDL_DestroyTexture(label.texture);
+    label = MenuLabel();
+}
+
+/** @brief Draw a cached label at (x, y) tinted to color. */
+void drawLabel(SDL_Renderer* renderer, const MenuLabel& label, int x, int y, SDL_Color color) {
+    if (!label.texture) return;
+    SDL_SetTextureColorMod(label.texture, color.r, color.g, color.b);
+    SDL_Rect r = { x, y, label.w, label.h };
+    SDL_RenderCopy(renderer, label.texture, nullptr, &r);
+}
+
 } // namespace
 
 bool App::init() {
@@ -61,7 +102,6 @@ bool App::init() {
         std::fprintf(stderr, "TTF_Init failed: %s\n", TTF_GetError());
         return false;
     }
-    std::srand(12345);  // Fixed seed for deterministic random colors
 
     // Create main window with OpenGL support
     window = SDL_CreateWindow("Particle Sandbox",
@@ -86,7 +126,8 @@ bool App::init() {
         std::fprintf(stderr, "SDL_CreateWindow (menu) failed: %s\n", SDL_GetError());
         return false;
     }
-    menuRenderer = SDL_CreateRenderer(menuWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    // No vsync: the menu only presents when it changes, and must never block the main loop
+    menuRenderer = SDL_CreateRenderer(menuWindow, -1, SDL_RENDERER_ACCELERATED);
     if (!menuRenderer) {
         std::fprintf(stderr, "SDL_CreateRenderer (menu) failed: %s\n", SDL_GetError());
         return false;
@@ -107,10 +148,19 @@ bool App::init() {
     if (!menuFont) {
         std::fprintf(stderr, "Warning: Could not load font, labels will not render: %s\n", TTF_GetError());
     }
+    titleLabel = makeLabel(menuRenderer, menuFont, "Place");
+    particleLabel = makeLabel(menuRenderer, menuFont, "Particle");
+    wellLabel = makeLabel(menuRenderer, menuFont, "Gravity Well");
+    menuDirty = true;
 
     // Initialize OpenGL renderer for main window
+    // Compute stepping needs the GL context on this thread, so not with the pipelined or recorder paths
+    if (useGpu && (pipelined || recordPath || replayPath)) {
+        std::fprintf(stderr, "--gpu cannot be combined with --pipelined, --record or --replay; using the CPU\n");
+        useGpu = false;
+    }
     renderer = new Renderer();
-    if (!renderer->init(window, width, height)) {
+    if (!renderer->init(window, width, height, useGpu)) {
         delete renderer;
         renderer = nullptr;
         return false;
@@ -118,17 +168,87 @@ bool App::init() {
 
     // Initialize physics simulation
     simulation = new Simulation();
-    simulation->worldW = (float)width;
-    simulation->worldH = (float)height;
+    if (worldWidth <= 0.0f || worldHeight <= 0.0f) {
+        worldWidth = (float)width;
+        worldHeight = (float)height;
+    }
+    simulation->worldW = worldWidth;
+    simulation->worldH = worldHeight;
+    camera.fit(worldWidth, worldHeight, width, height);
+    simulation->setThreadCount(threadCount);
+    simulation->continuousCollisions = continuousCollisions;
+    simulation->particles.reserve(particleCapacity);
+
+    if (useGpu && !renderer->hasCompute()) {
+        std::fprintf(stderr, "--gpu needs an OpenGL 4.3 context (compute shaders); using the CPU\n");
+        useGpu = false;
+    }
+    if (useGpu) {
+        gpuSim = new GpuSimulation();
+        if (!gpuSim->init()) {
+            std::fprintf(stderr, "GPU simulation unavailable, using the CPU\n");
+            delete gpuSim;
+            gpuSim = nullptr;
+        }
+    }
+
+    if (replayPath) {
+        // Playback replaces the simulation: no recorder, no stepping thread
+        player = new Player();
+        if (!player->open(replayPath)) {
+            delete player;
+            player = nullptr;
+            return false;
+        }
+        std::printf("Replaying %s: %zu frames, %.1f s\n", replayPath, player->frameCount(),
+                    player->timeOf(player->frameCount() - 1));
+        return true;
+    }
+
+    if (recordPath) {
+        recorder = new Recorder();
+        if (!recorder->open(recordPath)) {
+            delete recorder;
+            recorder = nullptr;
+            return false;
+        }
+    }
+
+    // Pace frames to the display unless a rate was given (0 = uncapped)
+    if (frameRate < 0.0f) {
+        SDL_DisplayMode mode;
+        const int display = SDL_GetWindowDisplayIndex(window);
+        frameRate = (display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 && mode.refresh_rate > 0)
+            ? (float)mode.refresh_rate : FALLBACK_FRAME_RATE;
+    }
+    scheduler = FrameScheduler(fixedStep, MAX_STEPS_PER_FRAME);
+    scheduler.setFrameRate(frameRate);
+
+    if (pipelined) {
+        simThread = new SimulationThread(*simulation, fixedStep);
+        simThread->setRecorder(recorder);
+        simThread->start();
+    }
 
     return true;
 }
 
 void App::shutdown() {
+    delete player;
+    player = nullptr;
+    delete simThread;
+    simThread = nullptr;
+    delete recorder;  // After the stepping thread: closing flushes and writes the index
+    recorder = nullptr;
+    delete gpuSim;  // Before the renderer: needs the GL context
+    gpuSim = nullptr;
     delete simulation;
     simulation = nullptr;
     delete renderer;
     renderer = nullptr;
+    destroyLabel(titleLabel);
+    destroyLabel(particleLabel);
+    destroyLabel(wellLabel);
     if (menuFont) {
         TTF_CloseFont(menuFont);
         menuFont = nullptr;
@@ -149,10 +269,28 @@ void App::shutdown() {
     SDL_Quit();
 }
 
+void App::modifySimulation(const std::function<void(Simulation&)>& cmd) {
+    if (player)
+        return;  // Replay is read-only
+    if (simThread) {
+        simThread->post(cmd);
+    } else {
+        syncFromGpu();  // The next update uploads the edited state again
+        cmd(*simulation);
+    }
+}
+
+void App::syncFromGpu() {
+    if (!gpuResident) return;
+    gpuSim->download(*simulation);
+    simulation->wakeAll();  // Sleep state is CPU-only and the GPU moved everything
+    gpuResident = false;
+}
+
 void App::spawnParticle(float x, float y, float vx, float vy) {
     float r = particleRadius;
-    float W = simulation->worldW;
-    float H = simulation->worldH;
+    float W = worldWidth;
+    float H = worldHeight;
     
     // Clamp spawn position to ensure particle starts within bounds
     // Account for radius so particle doesn't spawn partially off-screen
@@ -161,12 +299,77 @@ void App::spawnParticle(float x, float y, float vx, float vy) {
     
     Vec2 pos(x, y);
     Vec2 vel(vx, vy);
-    Color color = randomBrightColor();
-    simulation->particles.emplace_back(pos, vel, r, color);
+    Color color = randomBrightColor(rng);
+    Particle p(pos, vel, r, color);
+    modifySimulation([p](Simulation& sim) { sim.particles.add(p); });
+}
+
+void App::addEmitter(float x, float y) {
+    // Fountain aimed straight up (y grows downward)
+    Emitter emitter(EmitterShape::Point, Vec2(x, y), Vec2(x, y), emitterRate);
+    emitter.direction = -1.5707963f;
+    emitter.spread = 0.25f;
+    emitter.minSpeed = 250.0f;
+    emitter.maxSpeed = 400.0f;
+    emitter.minRadius = 0.5f * particleRadius;
+    emitter.maxRadius = particleRadius;
+    emitter.seed = rng.next();
+    for (int c = 0; c < EMITTER_PALETTE; ++c)  // HSV conversion once per emitter, not per particle
+        emitter.palette.push_back(randomBrightColor(rng));
+    emitters.push_back(std::move(emitter));
+}
+
+void App::emitParticles(float dt) {
+    emitBatch.clear();
+    for (Emitter& emitter : emitters)
+        emitter.emit(dt, emitBatch);
+    if (emitBatch.empty()) return;
+    if (simThread) {
+        simThread->post([batch = emitBatch](Simulation& sim) { sim.spawnBatch(batch); });
+    } else {
+        simulation->spawnBatch(emitBatch);
+    }
+}
+
+void App::updateTrailRegion() {
+    // The whole world is normally in view; only zooming in shrinks the region
+    const Vec2 viewMin = camera.origin(width, height);
+    const Vec2 viewSize = Vec2((float)width, (float)height) * (1.0f / camera.zoom);
+    const Vec2 lo = viewMin - viewSize * TRAIL_REGION_MARGIN;
+    const Vec2 hi = viewMin + viewSize * (1.0f + TRAIL_REGION_MARGIN);
+    if (lo.x == trailRegionMin.x && lo.y == trailRegionMin.y && hi.x == trailRegionMax.x && hi.y == trailRegionMax.y)
+        return;
+    trailRegionMin = lo;
+    trailRegionMax = hi;
+    auto apply = [lo, hi](Simulation& sim) {
+        sim.trailMin = lo;
+        sim.trailMax = hi;
+    };
+    if (simThread)
+        simThread->post(apply);
+    else
+        apply(*simulation);  // Not through modifySimulation(): no need to pull GPU state back
 }
 
 void App::spawnGravityWell(float x, float y) {
-    simulation->addGravityWell(x, y);
+    modifySimulation([x, y](Simulation& sim) { sim.addGravityWell(x, y); });
+}
+
+void App::despawnParticleAt(float x, float y) {
+    modifySimulation([x, y](Simulation& sim) {
+        size_t i = sim.particleAt(x, y);
+        if (i == ParticleStore::NPOS) return;
+        // Through removeParticles() so the rest stay asleep; only what touched it wakes
+        const Vec2 pos(sim.particles.x[i], sim.particles.y[i]);
+        const float reach = 2.0f * sim.particles.radius[i];
+        const ParticleHandle handle = sim.particles.handleAt(i);
+        sim.removeParticles(Span<const ParticleHandle>(&handle, 1));
+        sim.wakeNear(pos, reach);
+    });
+}
+
+Vec2 App::screenToWorld(int x, int y) const {
+    return camera.toWorld(Vec2((float)x, (float)y), width, height);
 }
 
 void App::handleEvent(void* eventPtr) {
@@ -179,31 +382,95 @@ void App::handleEvent(void* eventPtr) {
             running = false;
             break;
         case SDL_KEYDOWN:
+            if (player && handleReplayKey(e.key.keysym.sym))
+                break;
             if (e.key.keysym.sym == SDLK_ESCAPE)
                 running = false;
-            else if (e.key.keysym.sym == SDLK_r)
-                simulation->clear();
-            else if (e.key.keysym.sym == SDLK_SPACE)
+            else if (e.key.keysym.sym == SDLK_r) {
+                emitters.clear();
+                modifySimulation([](Simulation& sim) { sim.clear(); });
+            }
+            else if (e.key.keysym.sym == SDLK_e) {
+                if (SDL_GetModState() & KMOD_SHIFT) {
+                    emitters.clear();
+                } else {
+                    int mx, my;
+                    SDL_GetMouseState(&mx, &my);
+                    const Vec2 at = screenToWorld(mx, my);
+                    addEmitter(at.x, at.y);
+                }
+            }
+            else if (e.key.keysym.sym == SDLK_f)
+                camera.fit(worldWidth, worldHeight, width, height);
+            else if (e.key.keysym.sym == SDLK_t) {
+                showTrails = !showTrails;
+                const bool on = showTrails;
+                modifySimulation([on](Simulation& sim) { sim.trails = on; });
+            }
+            else if (e.key.keysym.sym == SDLK_SPACE) {
                 paused = !paused;
+                if (simThread) simThread->setPaused(paused);
+            }
+            else if (e.key.keysym.sym == SDLK_b)
+                modifySimulation([](Simulation& sim) {
+                    // Cycle grid -> sweep-and-prune -> brute force
+                    sim.collisionMode = sim.collisionMode == CollisionMode::Grid ? CollisionMode::SweepAndPrune
+                        : sim.collisionMode == CollisionMode::SweepAndPrune ? CollisionMode::BruteForce
+                        : CollisionMode::Grid;
+                });
+            else if (e.key.keysym.sym == SDLK_g)
+                modifySimulation([](Simulation& sim) { sim.nbody = !sim.nbody; });
+            else if (e.key.keysym.sym == SDLK_p) {
+                showProfiler = !showProfiler;
+                if (showProfiler) Profiler::instance().reset();
+                Profiler::setEnabled(showProfiler);
+            }
+            else if (e.key.keysym.sym == SDLK_F5)
+                modifySimulation([](Simulation& sim) {
+                    if (saveScene(sim, SCENE_PATH)) std::printf("Saved %s\n", SCENE_PATH);
+                });
+            else if (e.key.keysym.sym == SDLK_F9)
+                modifySimulation([](Simulation& sim) {
+                    if (loadScene(sim, SCENE_PATH)) std::printf("Loaded %s\n", SCENE_PATH);
+                });
+            else if (e.key.keysym.sym == SDLK_F12) {
+                if (Profiler::instance().writeChromeTrace("orb_trace.json"))
+                    std::printf("Wrote orb_trace.json\n");
+            }
             break;
         case SDL_MOUSEBUTTONDOWN:
+            if (e.button.button == SDL_BUTTON_RIGHT && e.button.windowID == mainID) {
+                const Vec2 at = screenToWorld(e.button.x, e.button.y);
+                despawnParticleAt(at.x, at.y);
+                break;
+            }
+            if (e.button.button == SDL_BUTTON_MIDDLE && e.button.windowID == mainID) {
+                panActive = true;
+                break;
+            }
             if (e.button.button != SDL_BUTTON_LEFT) break;
             if (e.button.windowID == menuID) {
                 int mx = e.button.x, my = e.button.y;
+                PlaceableType previous = selectedPlaceable;
                 if (mx >= 12 && mx < 188 && my >= 36 && my < 96)
                     selectedPlaceable = PlaceableType::Particle;
                 else if (mx >= 12 && mx < 188 && my >= 104 && my < 164)
                     selectedPlaceable = PlaceableType::GravityWell;
+                if (selectedPlaceable != previous) menuDirty = true;
             } else if (e.button.windowID == mainID) {
+                const Vec2 at = screenToWorld(e.button.x, e.button.y);
                 dragActive = true;
-                dragStartX = (float)e.button.x;
-                dragStartY = (float)e.button.y;
+                dragStartX = at.x;
+                dragStartY = at.y;
             }
             break;
         case SDL_MOUSEBUTTONUP:
-            if (e.button.button == SDL_BUTTON_LEFT && dragActive && e.button.windowID == mainID) {
-                float endX = (float)e.button.x;
-                float endY = (float)e.button.y;
+            if (e.button.button == SDL_BUTTON_MIDDLE) {
+                panActive = false;
+            } else if (e.button.button == SDL_BUTTON_LEFT && dragActive && e.button.windowID == mainID) {
+                const Vec2 end = screenToWorld(e.button.x, e.button.y);
+                float endX = end.x;
+                float endY = end.y;
                 float vx = (endX - dragStartX) * velocityStrength;
                 float vy = (endY - dragStartY) * velocityStrength;
                 if (selectedPlaceable == PlaceableType::Particle)
@@ -215,13 +482,36 @@ void App::handleEvent(void* eventPtr) {
                 dragActive = false;
             }
             break;
+        case SDL_MOUSEMOTION:
+            if (panActive && e.motion.windowID == mainID)
+                camera.pan(Vec2((float)e.motion.xrel, (float)e.motion.yrel));
+            break;
+        case SDL_MOUSEWHEEL:
+            if (e.wheel.windowID == mainID && e.wheel.y != 0) {
+                int mx, my;
+                SDL_GetMouseState(&mx, &my);
+                camera.zoomAt(Vec2((float)mx, (float)my), std::pow(WHEEL_ZOOM, (float)e.wheel.y), width, height);
+            }
+            break;
         case SDL_WINDOWEVENT:
             if (e.window.windowID == mainID && e.window.event == SDL_WINDOWEVENT_RESIZED) {
+                // Only the visible area changes: the world, and every structure
+                // built over it, stays as it is
                 width = e.window.data1;
                 height = e.window.data2;
-                simulation->worldW = (float)width;
-                simulation->worldH = (float)height;
                 renderer->resize(width, height);
+            } else if (e.window.windowID == menuID) {
+                // Contents may have been lost (exposed, restored, resized): redraw once
+                switch (e.window.event) {
+                    case SDL_WINDOWEVENT_SHOWN:
+                    case SDL_WINDOWEVENT_EXPOSED:
+                    case SDL_WINDOWEVENT_RESTORED:
+                    case SDL_WINDOWEVENT_SIZE_CHANGED:
+                        menuDirty = true;
+                        break;
+                    default:
+                        break;
+                }
             }
             break;
         default:
@@ -229,28 +519,134 @@ void App::handleEvent(void* eventPtr) {
     }
 }
 
+bool App::handleReplayKey(int key) {
+    const size_t current = player->frameAtTime(replayTime);
+    switch (key) {
+        case SDLK_SPACE:
+            paused = !paused;
+            return true;
+        case SDLK_HOME:
+            seekReplay(0);
+            return true;
+        case SDLK_LEFT:
+            // Land on a keyframe so the frame is ready without any delta catch-up
+            seekReplay(player->keyframeOf(player->frameAtTime(replayTime - REPLAY_SEEK_SECONDS)));
+            return true;
+        case SDLK_RIGHT:
+            seekReplay(player->keyframeOf(player->frameAtTime(replayTime + REPLAY_SEEK_SECONDS)));
+            return true;
+        case SDLK_COMMA:
+            paused = true;
+            seekReplay(current > 0 ? current - 1 : 0);
+            return true;
+        case SDLK_PERIOD:
+            paused = true;
+            seekReplay(current + 1);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void App::seekReplay(size_t frame) {
+    frame = std::min(frame, player->frameCount() - 1);
+    replayTime = player->timeOf(frame);
+    player->request(frame);
+}
+
 void App::update(float dt) {
-    if (!paused)
-        simulation->update(dt);
+    if (player || simThread || paused)
+        scheduler.discard();  // Nothing here consumes fixed steps
+    if (player) {
+        if (!paused) {
+            // Hold the last frame once the recording runs out
+            const double end = player->timeOf(player->frameCount() - 1);
+            replayTime = std::min(replayTime + dt, end);
+        }
+        player->request(player->frameAtTime(replayTime));
+        return;
+    }
+    updateTrailRegion();
+    if (simThread) {  // Pipelined: the simulation thread steps on its own clock
+        if (!paused) emitParticles(dt);
+        return;
+    }
+    if (paused) return;
+
+    // The GPU path has no N-body gravity and no spawning: hand the state
+    // back to the CPU while either is in use
+    const bool onGpu = gpuSim && !simulation->nbody && emitters.empty();
+    if (onGpu && !gpuResident) {
+        gpuSim->upload(*simulation);
+        gpuResident = true;
+    } else if (!onGpu) {
+        syncFromGpu();
+    }
+
+    // Frame time only decides how many fixed steps to take, so a run (and
+    // its recording) does not depend on the display's frame rate
+    // The scheduler caps the count so a frame's steps fit its budget
+    const int steps = scheduler.stepsDue();
+    const FrameScheduler::Clock::time_point start = FrameScheduler::Clock::now();
+    for (int s = 0; s < steps; ++s) {
+        if (onGpu) {
+            gpuSim->step(*simulation, fixedStep);
+        } else {
+            emitParticles(fixedStep);
+            simulation->update(fixedStep);
+            if (recorder) recorder->push(*simulation, ++recordStep, fixedStep);
+        }
+    }
+    scheduler.stepsDone(steps, std::chrono::duration<double>(FrameScheduler::Clock::now() - start).count());
 }
 
 void App::render() {
+    ORB_PROFILE_SCOPE("render.frame");
+    renderer->beginFrame();
+    renderer->setView(camera.origin(width, height), camera.zoom);
     renderer->clear();
-    renderer->drawParticleTrails(simulation->particles);
-    renderer->drawGravityWells(simulation->gravityWells);
-    renderer->drawParticles(simulation->particles);
+    if (player) {
+        // Trails are not recorded; wells and particles come from the decoded frame
+        if (const PlaybackFrame* frame = player->current()) {
+            renderer->drawGravityWells(frame->wells);
+            renderer->drawParticles(frame->view());
+        }
+    } else if (simThread) {
+        ParticleView particles = simThread->interpolatedParticles();
+        if (showTrails) renderer->drawParticleTrails(particles, simThread->trails());
+        renderer->drawGravityWells(simThread->wells());
+        renderer->drawParticles(particles);
+    } else if (gpuResident) {
+        // Drawn straight from the simulation buffers; trails are not tracked on the GPU
+        renderer->drawGravityWells(simulation->gravityWells);
+        renderer->drawParticles(gpuSim->buffers());
+    } else {
+        ParticleView particles = simulation->particles.view();
+        if (showTrails) renderer->drawParticleTrails(particles, simulation->particles.trails.view());
+        renderer->drawGravityWells(simulation->gravityWells);
+        renderer->drawParticles(particles);
+    }
     if (dragActive) {
         int mx, my;
         SDL_GetMouseState(&mx, &my);
-        renderer->drawDragPreview(Vec2(dragStartX, dragStartY), Vec2((float)mx, (float)my));
+        renderer->drawDragPreview(Vec2(dragStartX, dragStartY), screenToWorld(mx, my));
+    }
+    if (showProfiler) {
+        Profiler::instance().frames(frameTimes);
+        renderer->drawProfilerOverlay(frameTimes);
+    }
+    {
+        ORB_PROFILE_SCOPE("render.swap");
+        SDL_GL_SwapWindow(window);
     }
-    SDL_GL_SwapWindow(window);
 
     renderMenu();
 }
 
 void App::renderMenu() {
-    if (!menuRenderer) return;
+    if (!menuRenderer || !menuDirty) return;
+    ORB_PROFILE_SCOPE("render.menu");
+    menuDirty = false;
     const int menuW = 200;
 
     SDL_SetRenderDrawColor(menuRenderer, 28, 28, 36, 255);
@@ -261,20 +657,9 @@ void App::renderMenu() {
     SDL_SetRenderDrawColor(menuRenderer, 45, 45, 58, 255);
     SDL_RenderFillRect(menuRenderer, &titleRect);
 
-    // Render "Place" title text
-    if (menuFont) {
-        SDL_Color white = { 255, 255, 255, 255 };
-        SDL_Surface* textSurf = TTF_RenderText_Solid(menuFont, "Place", white);
-        if (textSurf) {
-            SDL_Texture* textTex = SDL_CreateTextureFromSurface(menuRenderer, textSurf);
-            if (textTex) {
-                SDL_Rect textRect = { 8, 6, textSurf->w, textSurf->h };
-                SDL_RenderCopy(menuRenderer, textTex, nullptr, &textRect);
-                SDL_DestroyTexture(textTex);
-            }
-            SDL_FreeSurface(textSurf);
-        }
-    }
+    // "Place" title text
+    SDL_Color white = { 255, 255, 255, 255 };
+    drawLabel(menuRenderer, titleLabel, 8, 6, white);
 
     // Particle slot
     SDL_Rect slotRect = { 12, 36, 176, 60 };
@@ -286,15 +671,8 @@ void App::renderMenu() {
     SDL_Rect iconRect = { 12 + 20, 36 + 12, 12, 12 };
     SDL_SetRenderDrawColor(menuRenderer, 180, 180, 255, 255);
     SDL_RenderFillRect(menuRenderer, &iconRect);
-    if (menuFont) {
-        SDL_Color c = { static_cast<Uint8>(particleSelected ? 255 : 200), static_cast<Uint8>(particleSelected ? 255 : 200), static_cast<Uint8>(particleSelected ? 255 : 220), 255 };
-        SDL_Surface* surf = TTF_RenderText_Solid(menuFont, "Particle", c);
-        if (surf) {
-            SDL_Texture* tex = SDL_CreateTextureFromSurface(menuRenderer, surf);
-            if (tex) { SDL_Rect r = { 12 + 40, 36 + 20, surf->w, surf->h }; SDL_RenderCopy(menuRenderer, tex, nullptr, &r); SDL_DestroyTexture(tex); }
-            SDL_FreeSurface(surf);
-        }
-    }
+    SDL_Color particleText = { static_cast<Uint8>(particleSelected ? 255 : 200), static_cast<Uint8>(particleSelected ? 255 : 200), static_cast<Uint8>(particleSelected ? 255 : 220), 255 };
+    drawLabel(menuRenderer, particleLabel, 12 + 40, 36 + 20, particleText);
 
     // Gravity Well slot
     SDL_Rect wellSlotRect = { 12, 104, 176, 60 };
@@ -306,36 +684,32 @@ void App::renderMenu() {
     SDL_Rect wellIconRect = { 12 + 20, 104 + 12, 12, 12 };
     SDL_SetRenderDrawColor(menuRenderer, 140, 80, 200, 255);
     SDL_RenderFillRect(menuRenderer, &wellIconRect);
-    if (menuFont) {
-        SDL_Color c = { static_cast<Uint8>(wellSelected ? 255 : 200), static_cast<Uint8>(wellSelected ? 200 : 180), static_cast<Uint8>(wellSelected ? 255 : 220), 255 };
-        SDL_Surface* surf = TTF_RenderText_Solid(menuFont, "Gravity Well", c);
-        if (surf) {
-            SDL_Texture* tex = SDL_CreateTextureFromSurface(menuRenderer, surf);
-            if (tex) { SDL_Rect r = { 12 + 40, 104 + 20, surf->w, surf->h }; SDL_RenderCopy(menuRenderer, tex, nullptr, &r); SDL_DestroyTexture(tex); }
-            SDL_FreeSurface(surf);
-        }
-    }
+    SDL_Color wellText = { static_cast<Uint8>(wellSelected ? 255 : 200), static_cast<Uint8>(wellSelected ? 200 : 180), static_cast<Uint8>(wellSelected ? 255 : 220), 255 };
+    drawLabel(menuRenderer, wellLabel, 12 + 40, 104 + 20, wellText);
 
     SDL_RenderPresent(menuRenderer);
 }
 
 void App::run() {
-    // High-resolution timer for accurate delta-time calculation
-    Uint64 lastTicks = SDL_GetPerformanceCounter();
-    
+    scheduler.tick();
+    scheduler.discard();  // Start timing from the first frame, not from init()
+
     while (running) {
         // Process all pending events
         SDL_Event e;
-        while (SDL_PollEvent(&e))
-            handleEvent(&e);
-
-        // Calculate delta time in seconds using high-resolution counter
-        Uint64 now = SDL_GetPerformanceCounter();
-        float dt = (float)(now - lastTicks) / (float)SDL_GetPerformanceFrequency();
-        lastTicks = now;
+        {
+            ORB_PROFILE_SCOPE("app.events");
+            while (SDL_PollEvent(&e))
+                handleEvent(&e);
+        }
 
-        // Update simulation and render frame
-        update(dt);
+        // Update simulation and render frame, then wait for the next frame's slot
+        update(scheduler.tick());
         render();
+        if (showProfiler) Profiler::instance().endFrame();
+        {
+            ORB_PROFILE_SCOPE("app.pace");
+            scheduler.pace();
+        }
     }
 }
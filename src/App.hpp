@@ -8,15 +8,37 @@
 
 #pragma once
 
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include "Emitter.hpp"
+#include "Camera.hpp"
+#include "FrameScheduler.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 struct SDL_Window;
 struct SDL_Renderer;
+struct SDL_Texture;
 struct TTF_Font;
 class Renderer;
 struct Simulation;
+class SimulationThread;
+class Recorder;
+class Player;
+class GpuSimulation;
 
 /** Placeable item types (selected from the menu) */
 enum class PlaceableType { Particle, GravityWell };
 
+/** Menu label rendered once at init (white; tinted per draw with a color mod) */
+struct MenuLabel {
+    SDL_Texture* texture = nullptr;
+    int w = 0;
+    int h = 0;
+};
+
 /**
  * @struct App
  * @brief Main application controller.
@@ -32,11 +54,23 @@ struct App {
     SDL_Window* menuWindow = nullptr;    ///< Place/tools menu window
     SDL_Renderer* menuRenderer = nullptr;///< 2D renderer for menu (no OpenGL)
     TTF_Font* menuFont = nullptr;        ///< Font for menu labels
+    MenuLabel titleLabel;                ///< Cached "Place" texture
+    MenuLabel particleLabel;             ///< Cached "Particle" texture
+    MenuLabel wellLabel;                 ///< Cached "Gravity Well" texture
+    bool menuDirty = true;               ///< Menu needs redrawing (selection or window state changed)
     Renderer* renderer = nullptr;       ///< OpenGL renderer instance
     Simulation* simulation = nullptr;   ///< Physics simulation instance
+    SimulationThread* simThread = nullptr; ///< Background stepping thread (pipelined mode only)
+    Recorder* recorder = nullptr;       ///< Trajectory recorder (only with recordPath)
+    Player* player = nullptr;           ///< Trajectory playback (only with replayPath; replaces the simulation)
+    GpuSimulation* gpuSim = nullptr;    ///< Compute-shader stepping (only with useGpu and a GL 4.3 context)
 
     int width = 1280;                   ///< Main window width in pixels
     int height = 720;                   ///< Main window height in pixels
+    float worldWidth = 0.0f;            ///< Simulation bounds (0 = the initial window size); fixed after init
+    float worldHeight = 0.0f;
+    Camera camera;                      ///< Which part of the world the window shows
+    bool panActive = false;             ///< Middle button held: mouse motion pans the camera
 
     PlaceableType selectedPlaceable = PlaceableType::Particle;  ///< Current tool from menu
 
@@ -45,10 +79,32 @@ struct App {
 
     // Click-drag spawn state
     bool dragActive = false;            ///< True while user is dragging to spawn
-    float dragStartX = 0.0f;            ///< Mouse X position when drag started
-    float dragStartY = 0.0f;           ///< Mouse Y position when drag started
+    float dragStartX = 0.0f;            ///< World X under the mouse when drag started
+    float dragStartY = 0.0f;           ///< World Y under the mouse when drag started
     float velocityStrength = 6.0f;     ///< Multiplier for drag-to-velocity conversion
     float particleRadius = 3.5f;        ///< Default radius for spawned particles (smaller, modern look)
+    int threadCount = 0;                ///< Simulation threads (0 = one per hardware thread)
+    bool pipelined = false;             ///< Step the simulation on its own thread at a fixed rate
+    bool useGpu = false;                ///< Step on the GPU with compute shaders when available
+    bool continuousCollisions = false;  ///< Sweep fast particles (Simulation::continuousCollisions)
+    bool gpuResident = false;           ///< GPU buffers hold the latest particle state (simulation's columns are stale)
+    float fixedStep = 1.0f / 120.0f;    ///< Simulation timestep in both loops (seconds); recorded with every step
+    FrameScheduler scheduler;           ///< Fixed-step accumulator with adaptive substeps, and frame pacing
+    float frameRate = -1.0f;            ///< Frame-rate cap (negative = the display refresh rate, 0 = uncapped)
+    size_t particleCapacity = 16384;    ///< Particles preallocated at init (spawning past this reallocates)
+    const char* recordPath = nullptr;   ///< Stream every step to this trajectory file
+    uint64_t recordStep = 0;            ///< Steps recorded so far (non-pipelined mode)
+    const char* replayPath = nullptr;   ///< Play this trajectory file instead of simulating
+    double replayTime = 0.0;            ///< Playhead in recorded seconds
+    Random rng{12345};                  ///< Fixed seed so spawned colors repeat run to run
+    std::vector<Emitter> emitters;      ///< Particle sources fed to the simulation every step
+    std::vector<Particle> emitBatch;    ///< Scratch batch for one step's emission
+    float emitterRate = 10000.0f;       ///< Particles per second for emitters placed with E
+    bool showProfiler = false;          ///< Profiler enabled and its frame graph drawn
+    bool showTrails = true;             ///< Trails recorded by the simulation and drawn
+    Vec2 trailRegionMin = Vec2(0.0f, 0.0f); ///< Trail region last sent to the simulation
+    Vec2 trailRegionMax = Vec2(0.0f, 0.0f);
+    std::vector<FrameTiming> frameTimes;///< Scratch copy of the profiler history for the overlay
 
     /**
      * @brief Initialize SDL, create window, set up renderer and simulation.
@@ -64,7 +120,9 @@ struct App {
     /**
      * @brief Run the main game loop until exit.
      * 
-     * Processes events, updates simulation, renders frame, calculates delta time.
+     * Processes events, updates simulation, renders frame, then sleeps until
+     * the next frameRate slot. The simulation itself always advances in
+     * fixedStep increments, as many per frame as scheduler allows.
      */
     void run();
 
@@ -72,13 +130,22 @@ struct App {
      * @brief Process a single SDL event.
      * @param eventPtr Pointer to SDL_Event structure
      * 
-     * Handles: quit, keyboard (Esc, R, Space), mouse (click-drag spawn), window resize.
+     * Handles: quit, keyboard (Esc, R, Space, B = cycle grid / sweep-and-prune / brute-force collisions, G = toggle N-body gravity,
+     * E / Shift+E = add a fountain emitter at the cursor / remove all emitters,
+     * P = profiler overlay, F5 / F9 = save / load orb_scene.bin, F12 = write orb_trace.json, F = fit the world in the window, T = toggle trails),
+     * mouse (click-drag spawn, right-click removes a particle, middle-drag pans, wheel zooms about the cursor),
+     * window resize (changes only the visible area, never the world). In replay: Space pauses, Left / Right seek 5 s to a keyframe,
+     * comma / period step one frame, Home restarts.
      */
     void handleEvent(void* event);
+    /** @brief Replay transport keys; returns false if key is not one of them. */
+    bool handleReplayKey(int key);
+    /** @brief Move the replay playhead to frame. */
+    void seekReplay(size_t frame);
     
     /**
-     * @brief Update simulation by one frame.
-     * @param dt Time delta in seconds
+     * @brief Update simulation (or advance the replay) by one frame.
+     * @param dt Frame time in seconds (already added to scheduler's accumulator)
      */
     void update(float dt);
     
@@ -86,19 +153,41 @@ struct App {
      * @brief Render one frame: main window (particles, drag preview) and menu window.
      */
     void render();
-    /** @brief Draw the place/tools menu in the menu window */
+    /** @brief Draw the place/tools menu in the menu window (only when menuDirty) */
     void renderMenu();
     
     /**
-     * @brief Spawn a new particle at the given position with given velocity.
+     * @brief Apply a change to the simulation.
+     * @param cmd Mutation to run
+     *
+     * Runs immediately (after pulling GPU-resident state back), or is queued
+     * for the simulation thread in pipelined mode.
+     * Ignored during replay.
+     */
+    void modifySimulation(const std::function<void(Simulation&)>& cmd);
+    /** @brief Copy GPU-resident particle state back into simulation (no-op when already current). */
+    void syncFromGpu();
+
+    /**
+     * @brief Spawn a new particle at the given world position with given velocity.
      * @param x Spawn X position (will be clamped to bounds)
      * @param y Spawn Y position (will be clamped to bounds)
      * @param vx Initial X velocity
      * @param vy Initial Y velocity
      * 
-     * Position is clamped to ensure particle starts within screen bounds.
+     * Position is clamped to ensure particle starts within world bounds.
      * Particle gets a random bright color.
      */
     void spawnParticle(float x, float y, float vx, float vy);
     void spawnGravityWell(float x, float y);
+    /** @brief Place a point emitter at (x, y) spraying emitterRate particles per second upward. */
+    void addEmitter(float x, float y);
+    /** @brief Run every emitter for dt and hand the batch to the simulation in one call. */
+    void emitParticles(float dt);
+    /** @brief Limit trails to the view (plus a margin) when the camera has moved. */
+    void updateTrailRegion();
+    /** @brief Remove the particle under (x, y), if any. */
+    void despawnParticleAt(float x, float y);
+    /** @brief World point under window pixel (x, y) for the current camera. */
+    Vec2 screenToWorld(int x, int y) const;
 };
@@ -0,0 +1,138 @@
+/**
+ * @file BarnesHut.cpp
+ * @brief Implementation of the Barnes–Hut quadtree.
+ */
+
+#include "BarnesHut.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /// Stop subdividing past this depth; coincident bodies share a leaf
+    const int MAX_DEPTH = 32;
+    /// Traversal stack size (3 siblings pushed per level plus slack)
+    const int STACK_SIZE = 4 * MAX_DEPTH + 8;
+}
+
+int BarnesHutTree::makeLeaf(float cx, float cy, float half) {
+    Node node;
+    node.cx = cx;
+    node.cy = cy;
+    node.half = half;
+    node.mass = 0.0f;
+    node.comX = 0.0f;
+    node.comY = 0.0f;
+    node.firstChild = -1;
+    node.body = -1;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+void BarnesHutTree::subdivide(int index) {
+    const float cx = nodes[index].cx, cy = nodes[index].cy;
+    const float h = nodes[index].half * 0.5f;
+    // Children are contiguous: NW, NE, SW, SE (y grows downward)
+    int first = makeLeaf(cx - h, cy - h, h);
+    makeLeaf(cx + h, cy - h, h);
+    makeLeaf(cx - h, cy + h, h);
+    makeLeaf(cx + h, cy + h, h);
+    nodes[index].firstChild = first;  // nodes may have reallocated: index, not reference
+}
+
+int BarnesHutTree::childFor(const Node& node, float px, float py) const {
+    return node.firstChild + (px >= node.cx ? 1 : 0) + (py >= node.cy ? 2 : 0);
+}
+
+void BarnesHutTree::build(const float* x, const float* y, const float* mass, size_t n) {
+    x_ = x;
+    y_ = y;
+    mass_ = mass;
+    nodes.clear();
+    if (n == 0) return;
+
+    float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+    for (size_t i = 1; i < n; ++i) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+    const float half = 0.5f * std::max(std::max(maxX - minX, maxY - minY), 1.0f) * 1.001f;
+    nodes.reserve(n * 2);
+    makeLeaf(0.5f * (minX + maxX), 0.5f * (minY + maxY), half);
+
+    for (size_t i = 0; i < n; ++i) {
+        const float px = x[i], py = y[i], m = mass[i];
+        int node = 0;
+        for (int depth = 0;; ++depth) {
+            // Every node on the path accumulates the body (as x·m, y·m for now)
+            nodes[node].mass += m;
+            nodes[node].comX += px * m;
+            nodes[node].comY += py * m;
+
+            if (nodes[node].firstChild >= 0) {
+                node = childFor(nodes[node], px, py);
+                continue;
+            }
+            if (nodes[node].body == -1) {
+                nodes[node].body = (int)i;
+                break;
+            }
+            if (depth >= MAX_DEPTH) {
+                nodes[node].body = -2;  // Shared leaf: keep only the aggregate
+                break;
+            }
+            // Occupied leaf: push the resident body one level down, then keep descending
+            const int resident = nodes[node].body;
+            nodes[node].body = -1;
+            subdivide(node);
+            Node& child = nodes[childFor(nodes[node], x[resident], y[resident])];
+            child.mass = mass[resident];
+            child.comX = x[resident] * mass[resident];
+            child.comY = y[resident] * mass[resident];
+            child.body = resident;
+            node = childFor(nodes[node], px, py);
+        }
+    }
+
+    for (Node& node : nodes) {
+        if (node.mass > 0.0f) {
+            node.comX /= node.mass;
+            node.comY /= node.mass;
+        }
+    }
+}
+
+void BarnesHutTree::acceleration(int self, float px, float py, float theta, float G, float softeningSq,
+                                 float& ax, float& ay) const {
+    ax = 0.0f;
+    ay = 0.0f;
+    if (nodes.empty()) return;
+
+    const float thetaSq = theta * theta;
+    int stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.mass <= 0.0f) continue;
+
+        const float dx = node.comX - px;
+        const float dy = node.comY - py;
+        const float distSq = dx * dx + dy * dy;
+        const float size = 2.0f * node.half;
+        const bool leaf = node.firstChild < 0;
+
+        if (leaf || size * size < thetaSq * distSq) {
+            if (leaf && node.body == self) continue;  // No self-attraction
+            const float r2 = distSq + softeningSq;
+            const float invR = 1.0f / std::sqrt(r2);
+            const float f = G * node.mass * invR * invR * invR;
+            ax += dx * f;
+            ay += dy * f;
+        } else {
+            for (int c = 0; c < 4; ++c)
+                stack[top++] = node.firstChild + c;
+        }
+    }
+}
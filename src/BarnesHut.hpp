@@ -0,0 +1,66 @@
+/**
+ * @file BarnesHut.hpp
+ * @brief Barnes–Hut quadtree for O(n log n) mutual gravity.
+ *
+ * Bodies are inserted into a quadtree whose nodes carry total mass and
+ * centre of mass. A node far enough away (size / distance < θ) is treated
+ * as a single point mass, so each force query visits O(log n) nodes
+ * instead of every body. θ = 0 degenerates to the exact direct sum.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct BarnesHutTree
+ * @brief Quadtree over point masses, rebuilt from scratch each step.
+ *
+ * Node storage is kept between builds so steady-state rebuilds do not allocate.
+ */
+struct BarnesHutTree {
+    /// One square cell of the tree
+    struct Node {
+        float cx, cy;      ///< Cell centre
+        float half;        ///< Half the cell edge length
+        float mass;        ///< Total mass below this node
+        float comX, comY;  ///< Centre of mass (x·m, y·m sums until finalized)
+        int firstChild;    ///< Index of the 4 children (NW, NE, SW, SE), -1 for a leaf
+        int body;          ///< Body index for a single-body leaf, -1 empty, -2 several (depth limit)
+    };
+
+    std::vector<Node> nodes;
+
+    /**
+     * @brief Build the tree.
+     * @param x Body X positions
+     * @param y Body Y positions
+     * @param mass Body masses (must be > 0)
+     * @param n Number of bodies
+     */
+    void build(const float* x, const float* y, const float* mass, size_t n);
+
+    /**
+     * @brief Gravitational acceleration at a body's position.
+     * @param self Index of the body being queried (excluded from its own leaf), or -1
+     * @param px Query X
+     * @param py Query Y
+     * @param theta Opening angle; smaller is more accurate and slower
+     * @param G Gravitational constant
+     * @param softeningSq Plummer softening length squared (avoids the r → 0 singularity)
+     * @param ax Output acceleration X
+     * @param ay Output acceleration Y
+     */
+    void acceleration(int self, float px, float py, float theta, float G, float softeningSq,
+                      float& ax, float& ay) const;
+
+private:
+    int makeLeaf(float cx, float cy, float half);
+    void subdivide(int node);
+    int childFor(const Node& node, float px, float py) const;
+
+    const float* x_ = nullptr;
+    const float* y_ = nullptr;
+    const float* mass_ = nullptr;
+};
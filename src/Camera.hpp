@@ -0,0 +1,54 @@
+/**
+ * @file Camera.hpp
+ * @brief Pan/zoom camera mapping the simulated world onto the window.
+ *
+ * The world (Simulation::worldW x worldH) is independent of the window: the
+ * camera says which world point is at the centre of the window and how many
+ * pixels one world unit covers. The window size is passed in rather than
+ * stored, so resizing the window only changes how much of the world is
+ * visible and never the simulation bounds.
+ */
+
+#pragma once
+
+#include "Math.hpp"
+#include <algorithm>
+
+/**
+ * @struct Camera
+ * @brief View centre and zoom, with the screen/world conversions input needs.
+ */
+struct Camera {
+    Vec2 center = Vec2(0.0f, 0.0f);  ///< World point at the middle of the window
+    float zoom = 1.0f;               ///< Pixels per world unit
+    float minZoom = 0.01f;
+    float maxZoom = 32.0f;
+
+    /** @brief World point at the top-left corner of a width x height window. */
+    Vec2 origin(int width, int height) const {
+        return center - Vec2((float)width, (float)height) * (0.5f / zoom);
+    }
+
+    /** @brief World point under window pixel screen. */
+    Vec2 toWorld(Vec2 screen, int width, int height) const {
+        return origin(width, height) + screen * (1.0f / zoom);
+    }
+
+    /** @brief Move the view by a mouse drag of delta pixels (the world follows the cursor). */
+    void pan(Vec2 delta) {
+        center -= delta * (1.0f / zoom);
+    }
+
+    /** @brief Multiply the zoom by factor, keeping the world point under screen fixed. */
+    void zoomAt(Vec2 screen, float factor, int width, int height) {
+        const Vec2 before = toWorld(screen, width, height);
+        zoom = clamp(zoom * factor, minZoom, maxZoom);
+        center += before - toWorld(screen, width, height);
+    }
+
+    /** @brief Centre a worldW x worldH world and zoom so all of it fits the window. */
+    void fit(float worldW, float worldH, int width, int height) {
+        center = Vec2(worldW * 0.5f, worldH * 0.5f);
+        zoom = clamp(std::min((float)width / worldW, (float)height / worldH), minZoom, maxZoom);
+    }
+};
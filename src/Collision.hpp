@@ -0,0 +1,93 @@
+/**
+ * @file Collision.hpp
+ * @brief Narrow-phase contact test and response between two particles.
+ *
+ * Every broadphase (grid, sweep and prune, brute force) ends in
+ * resolveCollision() for each candidate pair, so this is the innermost
+ * loop of a step. It lives in a header so the broadphases inline it and
+ * orb_microbench can time it on its own. The helpers are in namespace
+ * collision, since short names like asleep() would be a poor fit for the
+ * global scope of every file that includes this.
+ */
+
+#pragma once
+
+#include <cmath>
+#include "Math.hpp"
+#include "Simulation.hpp"
+#include "SimulationStep.hpp"
+
+namespace collision {
+
+/// Closer centres than this get an arbitrary normal (the direction is undefined)
+constexpr float MIN_SEPARATION = 1.0e-6f;
+
+/// True if particle i is asleep (never with sleeping off)
+inline bool asleep(const ParticleColumns& c, int i) {
+    return c.rest && c.rest[i] >= Simulation::SLEEP_STEPS;
+}
+
+/**
+ * @brief Elastic response along n (from a toward b) with restitution.
+ * @param m1, m2 Masses of a and b (r²)
+ */
+inline void applyImpulse(const ParticleColumns& c, int a, int b, Vec2 n, float m1, float m2, float restitution) {
+    // 1D collision along the normal, then apply to velocity
+    float v1n = c.vx[a] * n.x + c.vy[a] * n.y;
+    float v2n = c.vx[b] * n.x + c.vy[b] * n.y;
+    float impulse = (1.0f + restitution) * (v1n - v2n) / (m1 + m2);
+    c.vx[a] -= impulse * m2 * n.x;
+    c.vy[a] -= impulse * m2 * n.y;
+    c.vx[b] += impulse * m1 * n.x;
+    c.vy[b] += impulse * m1 * n.y;
+}
+
+/**
+ * @brief Narrow-phase test and response for one pair.
+ *
+ * Rejects on squared distance first so the sqrt is only paid on contact,
+ * and then only once: the normal reuses it rather than normalizing delta.
+ * Two sleepers are left alone. A sleeper is only woken by a partner
+ * moving faster than SLEEP_SPEED; a resting partner skips the pair, so
+ * the two settle together instead of waking each other in turn.
+ *
+ * @return true if the pair overlapped and was resolved
+ */
+inline bool resolveCollision(const ParticleColumns& c, int a, int b, float restitution) {
+    const bool aAsleep = asleep(c, a), bAsleep = asleep(c, b);
+    if (aAsleep && bAsleep) return false;
+
+    Vec2 delta(c.x[b] - c.x[a], c.y[b] - c.y[a]);
+    float sumR = c.r[a] + c.r[b];
+    float distSq = delta.lengthSq();
+    if (distSq >= sumR * sumR) return false;  // No overlap
+
+    if (aAsleep || bAsleep) {
+        const int mover = aAsleep ? b : a;
+        const float speedSq = c.vx[mover] * c.vx[mover] + c.vy[mover] * c.vy[mover];
+        if (speedSq < Simulation::SLEEP_SPEED * Simulation::SLEEP_SPEED) return false;
+        c.rest[aAsleep ? a : b] = 0;  // Woken by a moving neighbour
+    }
+
+    float dist = std::sqrt(distSq);
+
+    // Collision normal from a toward b (undefined if dist==0)
+    Vec2 n = (dist > MIN_SEPARATION) ? delta * (1.0f / dist) : Vec2(1.0f, 0.0f);
+
+    // Mass proportional to area (r²) so different sizes behave correctly
+    float m1 = c.r[a] * c.r[a];
+    float m2 = c.r[b] * c.r[b];
+    float totalMass = m1 + m2;
+
+    // Position correction: push apart so they are exactly touching
+    float overlap = sumR - dist;
+    c.x[a] -= n.x * (overlap * (m2 / totalMass));
+    c.y[a] -= n.y * (overlap * (m2 / totalMass));
+    c.x[b] += n.x * (overlap * (m1 / totalMass));
+    c.y[b] += n.y * (overlap * (m1 / totalMass));
+
+    applyImpulse(c, a, b, n, m1, m2, restitution);
+    return true;
+}
+
+} // namespace collision
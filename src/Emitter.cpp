@@ -0,0 +1,53 @@
+/**
+ * @file Emitter.cpp
+ * @brief Implementation of rate-based particle emission.
+ */
+
+#include "Emitter.hpp"
+#include "Random.hpp"
+#include <cmath>
+
+namespace {
+    /// Independent streams per attribute: key = seed ^ salt
+    const uint64_t SALT_PLACE_U = 0x51ED2705A3F1C9B3ull;
+    const uint64_t SALT_PLACE_V = 0xA24BAED4963EE407ull;
+    const uint64_t SALT_ANGLE   = 0x9FB21C651E98DF25ull;
+    const uint64_t SALT_SPEED   = 0xC13FA9A902A6328Full;
+    const uint64_t SALT_RADIUS  = 0x91E10DA5C79E7B1Dull;
+    const uint64_t SALT_COLOR   = 0xD1B54A32D192ED03ull;
+}
+
+size_t Emitter::emit(float dt, std::vector<Particle>& out) {
+    carry += rate * dt;
+    if (carry < 1.0f) return 0;
+    const size_t count = (size_t)carry;
+    carry -= (float)count;
+
+    const size_t first = out.size();
+    out.resize(first + count);
+    Particle* p = out.data() + first;
+    const uint64_t base = emitted;
+    const Vec2 span = end - pos;
+    const size_t colors = palette.size();
+
+    // Each attribute is a pure function of (seed, particle number): no
+    // generator state is carried from one iteration to the next
+    for (size_t k = 0; k < count; ++k) {
+        const uint64_t n = base + k;
+        const float u = counterUniform(seed ^ SALT_PLACE_U, n);
+        const float v = counterUniform(seed ^ SALT_PLACE_V, n);
+        Vec2 at = pos;
+        if (shape == EmitterShape::Line)
+            at = pos + span * u;
+        else if (shape == EmitterShape::Area)
+            at = Vec2(pos.x + span.x * u, pos.y + span.y * v);
+
+        const float angle = direction + spread * (2.0f * counterUniform(seed ^ SALT_ANGLE, n) - 1.0f);
+        const float speed = minSpeed + (maxSpeed - minSpeed) * counterUniform(seed ^ SALT_SPEED, n);
+        const float radius = minRadius + (maxRadius - minRadius) * counterUniform(seed ^ SALT_RADIUS, n);
+        const Color color = colors ? palette[counterRandom(seed ^ SALT_COLOR, n) % colors] : Color();
+        p[k] = Particle(at, Vec2(std::cos(angle) * speed, std::sin(angle) * speed), radius, color);
+    }
+    emitted += count;
+    return count;
+}
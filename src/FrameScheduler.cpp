@@ -0,0 +1,107 @@
+/**
+ * @file FrameScheduler.cpp
+ * @brief Implementation of the adaptive fixed-step scheduler and frame pacing.
+ */
+
+#include "FrameScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+    /// Step budget per frame when no frame rate is set (seconds)
+    const float DEFAULT_STEP_BUDGET = 1.0f / 30.0f;
+    /// Share of a paced frame the steps may take at most, and at least, whatever the rest costs
+    const double MAX_PACED_STEP_SHARE = 0.75;
+    const double MIN_PACED_STEP_SHARE = 0.25;
+    /// Share used until the rest of a frame has been measured
+    const double INITIAL_PACED_STEP_SHARE = 0.5;
+    /// Weight of the newest measurement in the smoothed costs
+    const double COST_SMOOTHING = 0.1;
+    /// Bounds on the yield window before a frame deadline (adapted to how late sleeps wake)
+    const std::chrono::microseconds MIN_SPIN(200);
+    const std::chrono::microseconds MAX_SPIN(2000);
+}
+
+FrameScheduler::FrameScheduler(float stepSeconds, int maxSubsteps)
+    : step_(stepSeconds), maxSubsteps_(std::max(maxSubsteps, 1)), substepLimit_(maxSubsteps_),
+      last_(Clock::now()), frameStart_(last_), deadline_(last_), spin_(MIN_SPIN) {}
+
+void FrameScheduler::setFrameRate(float fps) {
+    interval_ = fps > 0.0f
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps))
+        : Clock::duration(0);
+    deadline_ = Clock::now() + interval_;
+}
+
+float FrameScheduler::tick() {
+    const Clock::time_point now = Clock::now();
+    const float elapsed = std::min(std::chrono::duration<float>(now - last_).count(), MAX_FRAME_SECONDS);
+    last_ = now;
+    frameStart_ = now;
+    frameSteps_ = 0.0;
+    accumulator_ += elapsed;
+    return elapsed;
+}
+
+int FrameScheduler::stepsDue() {
+    int steps = (int)std::min(std::floor(accumulator_ / step_), (double)substepLimit_);
+    accumulator_ -= steps * (double)step_;
+    if (accumulator_ >= step_) {
+        // Fell behind: keep only the phase within a step instead of spiralling
+        const double kept = std::fmod(accumulator_, (double)step_);
+        dropped_ += accumulator_ - kept;
+        accumulator_ = kept;
+    }
+    return steps;
+}
+
+void FrameScheduler::stepsDone(int steps, double seconds) {
+    if (steps <= 0) return;
+    frameSteps_ += seconds;
+    const double cost = seconds / steps;
+    stepCost_ = stepCost_ > 0.0 ? stepCost_ + (cost - stepCost_) * COST_SMOOTHING : cost;
+
+    // As many steps as fit the budget, but always at least one so the run advances
+    double budget = DEFAULT_STEP_BUDGET;
+    if (stepBudget_ > 0.0f) {
+        budget = stepBudget_;
+    } else if (interval_.count() > 0) {
+        // Leave the rest of the frame its measured time, within fixed shares
+        const double interval = std::chrono::duration<double>(interval_).count();
+        budget = otherCost_ < 0.0 ? interval * INITIAL_PACED_STEP_SHARE
+            : std::min(std::max(interval - otherCost_, interval * MIN_PACED_STEP_SHARE),
+                       interval * MAX_PACED_STEP_SHARE);
+    }
+    const double fit = stepCost_ > 0.0 ? budget / stepCost_ : (double)maxSubsteps_;
+    substepLimit_ = (int)std::max(1.0, std::min(fit, (double)maxSubsteps_));
+}
+
+void FrameScheduler::pace() {
+    if (interval_.count() <= 0) return;
+    Clock::time_point now = Clock::now();
+    const double other = std::max(std::chrono::duration<double>(now - frameStart_).count() - frameSteps_, 0.0);
+    otherCost_ = otherCost_ >= 0.0 ? otherCost_ + (other - otherCost_) * COST_SMOOTHING : other;
+
+    if (now >= deadline_) {
+        // Late: start the schedule again from now rather than rushing to catch up
+        deadline_ = now + interval_;
+        return;
+    }
+
+    // Sleep through most of the wait; the OS may wake us late, so the last
+    // stretch is yielded away and the window widens when sleeps overshoot
+    const Clock::time_point wake = deadline_ - spin_;
+    if (now < wake) {
+        std::this_thread::sleep_until(wake);
+        now = Clock::now();
+        const Clock::duration late = now - wake;
+        if (late > spin_)
+            spin_ = std::min<Clock::duration>(late + late / 2, MAX_SPIN);
+        else
+            spin_ = std::max<Clock::duration>(spin_ - spin_ / 16, MIN_SPIN);
+    }
+    while (Clock::now() < deadline_)
+        std::this_thread::yield();
+    deadline_ += interval_;
+}
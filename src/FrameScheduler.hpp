@@ -0,0 +1,97 @@
+/**
+ * @file FrameScheduler.hpp
+ * @brief Fixed-step accumulator with an adaptive substep limit, plus frame pacing.
+ *
+ * Each frame adds the measured wall time to an accumulator and runs as many
+ * fixed steps as it covers. How many steps one frame may run is not a
+ * constant: it follows the measured cost of a step, so the steps of one
+ * frame stay within a time budget. When steps get more expensive than the
+ * time they simulate, the backlog beyond that limit is dropped (the run
+ * slows down) instead of each frame taking longer and owing even more
+ * steps the next time (the "spiral of death"). With a frame rate set, the
+ * budget is what the paced frame leaves after the rest of the frame's work
+ * (rendering, measured between stepsDone() and pace()), so a frame of steps
+ * cannot crowd out its own draw and miss the deadline.
+ *
+ * pace() then sleeps until the next frame deadline, finishing the last
+ * stretch with yields so frames start on time without spinning the CPU
+ * for the whole wait.
+ */
+
+#pragma once
+
+#include <chrono>
+
+/**
+ * @class FrameScheduler
+ * @brief Decides how many fixed steps each frame runs and when the next frame starts.
+ */
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param stepSeconds Fixed simulation timestep
+     * @param maxSubsteps Hard upper bound on steps per frame
+     */
+    explicit FrameScheduler(float stepSeconds = 1.0f / 120.0f, int maxSubsteps = 8);
+
+    /** @brief Frame-rate cap for pace() (0 = no pacing). */
+    void setFrameRate(float fps);
+    /** @brief Longest time the steps of one frame should take (default: the paced frame less its other work, else 1/30 s). */
+    void setStepBudget(float seconds) { stepBudget_ = seconds; }
+
+    /**
+     * @brief Start a frame: add the wall time since the previous tick() to the accumulator.
+     * @return Elapsed seconds (at most MAX_FRAME_SECONDS, so a stall is not replayed)
+     */
+    float tick();
+
+    /**
+     * @brief Steps to run for this frame under the current substep limit.
+     *
+     * Removes them from the accumulator; backlog the limit does not allow is
+     * dropped and counted in droppedSeconds().
+     */
+    int stepsDue();
+
+    /** @brief Report that steps took seconds of wall time, so the limit tracks their cost. */
+    void stepsDone(int steps, double seconds);
+
+    /** @brief Forget unsimulated time (pause, or stepping elsewhere). */
+    void discard() { accumulator_ = 0.0; }
+
+    /** @brief Sleep, then yield, until the next frame deadline (returns at once when unpaced). */
+    void pace();
+
+    float step() const { return step_; }
+    /** @brief Unsimulated time as a fraction of a step, in [0, 1). */
+    float alpha() const { return (float)(accumulator_ / step_); }
+    /** @brief Steps the next frame may run at most. */
+    int substepLimit() const { return substepLimit_; }
+    /** @brief Smoothed wall time of one step (seconds). */
+    double stepCost() const { return stepCost_; }
+    /** @brief Smoothed wall time of a frame's other work, from tick() to pace() less the steps (seconds). */
+    double otherCost() const { return otherCost_; }
+    /** @brief Simulated time skipped because the steps could not keep up. */
+    double droppedSeconds() const { return dropped_; }
+
+    /** Longest frame tick() passes on (a breakpoint or window drag is not caught up) */
+    static constexpr float MAX_FRAME_SECONDS = 0.25f;
+
+private:
+    float step_;
+    int maxSubsteps_;
+    int substepLimit_;
+    float stepBudget_ = 0.0f;     ///< 0 = derive from the frame rate
+    double accumulator_ = 0.0;    ///< Wall time not yet simulated (seconds)
+    double stepCost_ = 0.0;       ///< Smoothed seconds per step (0 until measured)
+    double otherCost_ = -1.0;     ///< Smoothed seconds of non-step work per frame (negative until measured)
+    double frameSteps_ = 0.0;     ///< Seconds the steps of the current frame took
+    double dropped_ = 0.0;
+    Clock::time_point last_;      ///< Previous tick()
+    Clock::time_point frameStart_;///< tick() of the current frame, for otherCost_
+    Clock::duration interval_{0}; ///< Target frame interval (0 = unpaced)
+    Clock::time_point deadline_;  ///< When the next frame should start
+    Clock::duration spin_;        ///< Yield instead of sleeping for this long before the deadline
+};
@@ -0,0 +1,548 @@
+/**
+ * @file GpuSimulation.cpp
+ * @brief Compute shaders and dispatch for the GPU simulation backend.
+ */
+
+#include "GpuSimulation.hpp"
+#include "Simulation.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__APPLE__)
+
+// macOS OpenGL stops at 4.1: no compute shaders, so the CPU path is always used
+GpuSimulation::~GpuSimulation() {}
+
+bool GpuSimulation::init() {
+    std::fprintf(stderr, "GPU simulation needs OpenGL 4.3 compute shaders (not available on macOS)\n");
+    return false;
+}
+
+void GpuSimulation::upload(const Simulation&) {}
+void GpuSimulation::step(const Simulation&, float) {}
+void GpuSimulation::download(Simulation&) {}
+void GpuSimulation::reserveParticles(size_t) {}
+void GpuSimulation::reserveCells(size_t) {}
+GpuParticleBuffers GpuSimulation::buffers() const { return GpuParticleBuffers(); }
+
+#else
+
+#define GL_GLEXT_PROTOTYPES 1  // Declare GL 4.3 entry points (exported by libGL on Linux)
+#include <GL/gl.h>
+
+namespace {
+
+/** Same step limit as the CPU path (Simulation.cpp; COLLIDE_SRC repeats its other constants) */
+const float MAX_DT = 1.0f / 30.0f;
+
+/** Same cell budget as UniformGrid: at most this many cells per particle */
+const float MAX_CELLS_PER_PARTICLE = 4.0f;
+const int MIN_CELL_BUDGET = 64;
+
+/** Invocations per workgroup in the per-particle kernels */
+const GLuint GROUP_SIZE = 256;
+/** Cells scanned by one workgroup of the block scan (SCAN_BLOCKS_SRC's local size) */
+const GLuint SCAN_BLOCK = 1024;
+
+/** Storage buffer binding points, shared by every kernel */
+enum Binding {
+    BindPosIn, BindVelIn, BindPosOut, BindVelOut, BindRadius, BindCellOf,
+    BindRank, BindSorted, BindCellCount, BindCellStart, BindWells, BindBlockSums
+};
+
+/** Explicit uniform locations (layout(location = N) in the shaders) */
+enum Uniform {
+    UCount, UDt, UWorld, UGrid, UCellSize, UWellCount, UPull, URange,
+    URestitution, UDrag, UClampSlow, UCellTotal, UBlockTotal
+};
+
+/** Buffer declarations shared by the kernels; inactive blocks cost nothing */
+const char* COMMON_SRC = R"(
+#version 430
+layout(std430, binding = 0) buffer PosIn { vec2 posIn[]; };
+layout(std430, binding = 1) buffer VelIn { vec2 velIn[]; };
+layout(std430, binding = 2) buffer PosOut { vec2 posOut[]; };
+layout(std430, binding = 3) buffer VelOut { vec2 velOut[]; };
+layout(std430, binding = 4) buffer Radius { float radius[]; };
+layout(std430, binding = 5) buffer CellOf { uint cellOf[]; };
+layout(std430, binding = 6) buffer Rank { uint rank[]; };
+layout(std430, binding = 7) buffer Sorted { uint sorted[]; };
+layout(std430, binding = 8) buffer CellCount { uint cellCount[]; };
+layout(std430, binding = 9) buffer CellStart { uint cellStart[]; };
+layout(std430, binding = 10) buffer Wells { vec4 wells[]; };
+layout(std430, binding = 11) buffer BlockSums { uint blockSums[]; };
+
+ivec2 cellCoord(vec2 p, float cellSize, ivec2 grid) {
+    return clamp(ivec2(p / cellSize), ivec2(0), grid - 1);
+}
+)";
+
+/**
+ * Well gravity, integration and grid binning (positions and velocities in place).
+ * Matches applyWellGravityScalar() followed by the integrate pass.
+ */
+const char* INTEGRATE_SRC = R"(
+layout(local_size_x = 256) in;
+layout(location = 0) uniform uint uCount;
+layout(location = 1) uniform float uDt;
+layout(location = 3) uniform ivec2 uGrid;
+layout(location = 4) uniform float uCellSize;
+layout(location = 5) uniform int uWellCount;
+layout(location = 6) uniform float uPull;
+layout(location = 7) uniform float uRange;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uCount) return;
+    vec2 p = posIn[i];
+    vec2 v = velIn[i];
+    for (int w = 0; w < uWellCount; ++w) {
+        vec2 d = wells[w].xy - p;
+        float distSq = dot(d, d);
+        if (distSq < 1.0e-6) continue;
+        float dist = sqrt(distSq);
+        if (dist > uRange) continue;
+        v += (d / dist) * uPull * uDt;
+    }
+    p += v * uDt;
+    posIn[i] = p;
+    velIn[i] = v;
+
+    ivec2 c = cellCoord(p, uCellSize, uGrid);
+    uint cell = uint(c.y * uGrid.x + c.x);
+    cellOf[i] = cell;
+    rank[i] = atomicAdd(cellCount[cell], 1u);
+}
+)";
+
+/**
+ * Prefix sum, pass 1: one workgroup per 1024 cells. Each writes the
+ * exclusive sum of its block's counts into cellStart and the block's
+ * total into blockSums.
+ */
+const char* SCAN_BLOCKS_SRC = R"(
+layout(local_size_x = 1024) in;
+layout(location = 11) uniform uint uCellTotal;
+shared uint sums[1024];
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint idx = gl_WorkGroupID.x * 1024u + t;
+    uint v = idx < uCellTotal ? cellCount[idx] : 0u;
+    sums[t] = v;
+    barrier();
+    for (uint off = 1u; off < 1024u; off <<= 1) {
+        uint add = t >= off ? sums[t - off] : 0u;
+        barrier();
+        sums[t] += add;
+        barrier();
+    }
+    if (idx < uCellTotal) cellStart[idx] = sums[t] - v;
+    if (t == 1023u) blockSums[gl_WorkGroupID.x] = sums[1023];
+}
+)";
+
+/**
+ * Prefix sum, pass 2: exclusive sum of the block totals in place, in one
+ * workgroup. There are 1024 times fewer blocks than cells, so a million
+ * particles (four million cells) take four rounds.
+ */
+const char* SCAN_SUMS_SRC = R"(
+layout(local_size_x = 1024) in;
+layout(location = 12) uniform uint uBlockTotal;
+shared uint sums[1024];
+void main() {
+    uint t = gl_LocalInvocationID.x;
+    uint carry = 0u;
+    for (uint base = 0u; base < uBlockTotal; base += 1024u) {
+        uint idx = base + t;
+        uint v = idx < uBlockTotal ? blockSums[idx] : 0u;
+        sums[t] = v;
+        barrier();
+        for (uint off = 1u; off < 1024u; off <<= 1) {
+            uint add = t >= off ? sums[t - off] : 0u;
+            barrier();
+            sums[t] += add;
+            barrier();
+        }
+        if (idx < uBlockTotal) blockSums[idx] = carry + sums[t] - v;
+        carry += sums[1023];
+        barrier();
+    }
+}
+)";
+
+/** Prefix sum, pass 3: add each block's offset to its cells' starts */
+const char* SCAN_ADD_SRC = R"(
+layout(local_size_x = 256) in;
+layout(location = 11) uniform uint uCellTotal;
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    if (idx >= uCellTotal) return;
+    cellStart[idx] += blockSums[idx / 1024u];
+}
+)";
+
+/** Place each particle at its cell's start plus its rank */
+const char* SCATTER_SRC = R"(
+layout(local_size_x = 256) in;
+layout(location = 0) uniform uint uCount;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uCount) return;
+    sorted[cellStart[cellOf[i]] + rank[i]] = i;
+}
+)";
+
+/**
+ * Collisions against the 3x3 neighbourhood, then drag, walls and the
+ * tiny-speed clamp. Same per-contact response as resolveCollision() in
+ * Simulation.cpp, applied to this particle only (see GpuSimulation.hpp).
+ */
+const char* COLLIDE_SRC = R"(
+layout(local_size_x = 256) in;
+layout(location = 0) uniform uint uCount;
+layout(location = 1) uniform float uDt;
+layout(location = 2) uniform vec2 uWorld;
+layout(location = 3) uniform ivec2 uGrid;
+layout(location = 4) uniform float uCellSize;
+layout(location = 8) uniform float uRestitution;
+layout(location = 9) uniform float uDrag;
+layout(location = 10) uniform int uClampSlow;
+const float MIN_SEPARATION = 1.0e-6;
+const float TINY_SPEED = 0.5;
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uCount) return;
+    vec2 p = posIn[i];
+    vec2 v = velIn[i];
+    float r = radius[i];
+    float m1 = r * r;
+    vec2 dp = vec2(0.0);
+    vec2 dv = vec2(0.0);
+    int contacts = 0;
+
+    ivec2 c = cellCoord(p, uCellSize, uGrid);
+    for (int oy = -1; oy <= 1; ++oy) {
+        int cy = c.y + oy;
+        if (cy < 0 || cy >= uGrid.y) continue;
+        for (int ox = -1; ox <= 1; ++ox) {
+            int cx = c.x + ox;
+            if (cx < 0 || cx >= uGrid.x) continue;
+            uint cell = uint(cy * uGrid.x + cx);
+            uint begin = cellStart[cell];
+            uint end = begin + cellCount[cell];
+            for (uint k = begin; k < end; ++k) {
+                uint j = sorted[k];
+                if (j == i) continue;
+                vec2 delta = posIn[j] - p;
+                float sumR = r + radius[j];
+                float distSq = dot(delta, delta);
+                if (distSq >= sumR * sumR) continue;
+                float dist = sqrt(distSq);
+                ++contacts;
+                // Coincident pair: push the lower index toward -x, as the CPU does
+                vec2 n = dist > MIN_SEPARATION ? delta / dist : vec2(i < j ? 1.0 : -1.0, 0.0);
+                float m2 = radius[j] * radius[j];
+                float totalMass = m1 + m2;
+                dp -= n * ((sumR - dist) * (m2 / totalMass));
+                float approach = dot(v, n) - dot(velIn[j], n);
+                if (approach > 0.0) dv -= ((1.0 + uRestitution) * approach / totalMass) * m2 * n;
+            }
+        }
+    }
+    // Contacts are solved simultaneously rather than one after another, so
+    // average them: summing k corrections overshoots in dense piles
+    if (contacts > 1) {
+        dp /= float(contacts);
+        dv /= float(contacts);
+    }
+    p += dp;
+    v += dv;
+
+    if (uDrag > 0.0) v *= 1.0 - uDrag * uDt;
+    if (p.x - r < 0.0)      { p.x = r;            v.x = abs(v.x) * uRestitution; }
+    if (p.x + r > uWorld.x) { p.x = uWorld.x - r; v.x = -abs(v.x) * uRestitution; }
+    if (p.y - r < 0.0)      { p.y = r;            v.y = abs(v.y) * uRestitution; }
+    if (p.y + r > uWorld.y) { p.y = uWorld.y - r; v.y = -abs(v.y) * uRestitution; }
+    if (uClampSlow != 0 && dot(v, v) < TINY_SPEED * TINY_SPEED) v = vec2(0.0);
+
+    posOut[i] = p;
+    velOut[i] = v;
+}
+)";
+
+/**
+ * @brief Compile and link one compute program (COMMON_SRC + body).
+ * @return Program ID on success, 0 on failure (prints error to stderr)
+ */
+GLuint createComputeProgram(const char* body) {
+    const char* sources[2] = { COMMON_SRC, body };
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 2, sources, nullptr);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char buf[512];
+        glGetShaderInfoLog(shader, sizeof(buf), nullptr, buf);
+        std::fprintf(stderr, "Compute shader compile error: %s\n", buf);
+        glDeleteShader(shader);
+        return 0;
+    }
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, shader);
+    glLinkProgram(prog);
+    glDeleteShader(shader);
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char buf[512];
+        glGetProgramInfoLog(prog, sizeof(buf), nullptr, buf);
+        std::fprintf(stderr, "Compute program link error: %s\n", buf);
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+/** @brief (Re)allocate buffer with room for bytes, contents undefined. */
+void allocate(GLuint buffer, size_t bytes) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)std::max<size_t>(bytes, 16), nullptr, GL_DYNAMIC_COPY);
+}
+
+GLuint groupsFor(size_t n) {
+    return (GLuint)((n + GROUP_SIZE - 1) / GROUP_SIZE);
+}
+
+} // namespace
+
+GpuSimulation::~GpuSimulation() {
+    for (GLuint prog : programs_)
+        if (prog) glDeleteProgram(prog);
+    if (radius_) {
+        glDeleteBuffers(2, position_);
+        glDeleteBuffers(2, velocity_);
+        const GLuint others[] = { radius_, color_, cellOf_, rank_, sorted_, cellCount_, cellStart_, blockSums_, wells_ };
+        glDeleteBuffers((GLsizei)(sizeof(others) / sizeof(others[0])), others);
+    }
+}
+
+bool GpuSimulation::init() {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major * 10 + minor < 43) {
+        std::fprintf(stderr, "GPU simulation needs OpenGL 4.3 compute shaders (context is %d.%d)\n", major, minor);
+        return false;
+    }
+
+    const char* const bodies[ProgramCount] = {
+        INTEGRATE_SRC, SCAN_BLOCKS_SRC, SCAN_SUMS_SRC, SCAN_ADD_SRC, SCATTER_SRC, COLLIDE_SRC
+    };
+    for (int p = 0; p < ProgramCount; ++p) {
+        programs_[p] = createComputeProgram(bodies[p]);
+        if (!programs_[p]) return false;
+    }
+
+    glGenBuffers(2, position_);
+    glGenBuffers(2, velocity_);
+    GLuint* others[] = { &radius_, &color_, &cellOf_, &rank_, &sorted_, &cellCount_, &cellStart_, &blockSums_, &wells_ };
+    for (GLuint* b : others)
+        glGenBuffers(1, b);
+    reserveParticles(1024);
+    reserveCells(1024);
+    allocate(wells_, 0);
+    return true;
+}
+
+void GpuSimulation::reserveParticles(size_t n) {
+    if (n <= particleCapacity_) return;
+    particleCapacity_ = std::max(n, particleCapacity_ * 2);
+    const size_t cap = particleCapacity_;
+    for (int k = 0; k < 2; ++k) {
+        allocate(position_[k], cap * 2 * sizeof(float));
+        allocate(velocity_[k], cap * 2 * sizeof(float));
+    }
+    allocate(radius_, cap * sizeof(float));
+    allocate(color_, cap * 4 * sizeof(float));
+    allocate(cellOf_, cap * sizeof(GLuint));
+    allocate(rank_, cap * sizeof(GLuint));
+    allocate(sorted_, cap * sizeof(GLuint));
+}
+
+void GpuSimulation::reserveCells(size_t n) {
+    if (n <= cellCapacity_) return;
+    cellCapacity_ = std::max(n, cellCapacity_ * 2);
+    allocate(cellCount_, cellCapacity_ * sizeof(GLuint));
+    allocate(cellStart_, cellCapacity_ * sizeof(GLuint));
+    allocate(blockSums_, (cellCapacity_ + SCAN_BLOCK - 1) / SCAN_BLOCK * sizeof(GLuint));
+}
+
+void GpuSimulation::upload(const Simulation& sim) {
+    ORB_PROFILE_SCOPE("gpu.upload");
+    const ParticleStore& ps = sim.particles;
+    const size_t n = ps.size();
+    reserveParticles(n);
+    count_ = n;
+    current_ = 0;
+    maxRadius_ = 0.0f;
+    for (float r : ps.radius)
+        maxRadius_ = std::max(maxRadius_, r);
+    if (n == 0) return;
+
+    auto interleave = [&](const std::vector<float>& a, const std::vector<float>& b, GLuint buffer) {
+        staging_.resize(n * 2);
+        for (size_t i = 0; i < n; ++i) {
+            staging_[2 * i] = a[i];
+            staging_[2 * i + 1] = b[i];
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(n * 2 * sizeof(float)), staging_.data());
+    };
+    interleave(ps.x, ps.y, position_[0]);
+    interleave(ps.vx, ps.vy, velocity_[0]);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, radius_);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(n * sizeof(float)), ps.radius.data());
+    static_assert(sizeof(Color) == 4 * sizeof(float), "Color must match the vec4 color buffer");
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, color_);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(n * sizeof(Color)), ps.color.data());
+}
+
+void GpuSimulation::step(const Simulation& sim, float dt) {
+    ORB_PROFILE_SCOPE("gpu.step");
+    const size_t n = count_;
+    if (n == 0) return;
+    dt = std::min(dt, MAX_DT);
+
+    // Grid over the world (walls keep particles inside), cells at least one
+    // diameter across, grown until the cell count fits the same budget as UniformGrid
+    float cellSize = std::max(2.0f * maxRadius_, 1.0f);
+    const float budget = std::max((float)MIN_CELL_BUDGET, MAX_CELLS_PER_PARTICLE * (float)n);
+    const float cells = (sim.worldW / cellSize + 1.0f) * (sim.worldH / cellSize + 1.0f);
+    if (cells > budget)
+        cellSize *= std::sqrt(cells / budget);
+    const GLint cols = (GLint)(sim.worldW / cellSize) + 1;
+    const GLint rows = (GLint)(sim.worldH / cellSize) + 1;
+    const size_t cellTotal = (size_t)cols * (size_t)rows;
+    reserveCells(cellTotal);
+
+    // Wells as vec4 (x, y, unused, unused)
+    const size_t wellCount = sim.gravityWells.size();
+    if (wellCount > 0) {
+        staging_.resize(wellCount * 4);
+        for (size_t w = 0; w < wellCount; ++w) {
+            staging_[4 * w] = sim.gravityWells[w].pos.x;
+            staging_[4 * w + 1] = sim.gravityWells[w].pos.y;
+            staging_[4 * w + 2] = 0.0f;
+            staging_[4 * w + 3] = 0.0f;
+        }
+        if (wellCount > wellCapacity_) {
+            wellCapacity_ = wellCount;
+            allocate(wells_, wellCapacity_ * 4 * sizeof(float));
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, wells_);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(wellCount * 4 * sizeof(float)), staging_.data());
+    }
+
+    const int cur = current_, next = 1 - current_;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindPosIn, position_[cur]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindVelIn, velocity_[cur]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindPosOut, position_[next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindVelOut, velocity_[next]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindRadius, radius_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindCellOf, cellOf_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindRank, rank_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindSorted, sorted_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindCellCount, cellCount_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindCellStart, cellStart_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindWells, wells_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BindBlockSums, blockSums_);
+
+    const GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellCount_);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, (GLsizeiptr)(cellTotal * sizeof(GLuint)),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    // 1. Gravity, integrate, count particles per cell
+    glUseProgram(programs_[ProgIntegrate]);
+    glUniform1ui(UCount, (GLuint)n);
+    glUniform1f(UDt, dt);
+    glUniform2i(UGrid, cols, rows);
+    glUniform1f(UCellSize, cellSize);
+    glUniform1i(UWellCount, (GLint)wellCount);
+    glUniform1f(UPull, sim.wellPull);
+    glUniform1f(URange, sim.wellRange);
+    glDispatchCompute(groupsFor(n), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // 2. Cell starts: scan each block, scan the block totals, add them back
+    const GLuint blocks = (GLuint)((cellTotal + SCAN_BLOCK - 1) / SCAN_BLOCK);
+    glUseProgram(programs_[ProgScanBlocks]);
+    glUniform1ui(UCellTotal, (GLuint)cellTotal);
+    glDispatchCompute(blocks, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    if (blocks > 1) {
+        glUseProgram(programs_[ProgScanSums]);
+        glUniform1ui(UBlockTotal, blocks);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUseProgram(programs_[ProgScanAdd]);
+        glUniform1ui(UCellTotal, (GLuint)cellTotal);
+        glDispatchCompute(groupsFor(cellTotal), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // 3. Particles sorted by cell
+    glUseProgram(programs_[ProgScatter]);
+    glUniform1ui(UCount, (GLuint)n);
+    glDispatchCompute(groupsFor(n), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // 4. Collisions, drag, walls into the other buffer set
+    glUseProgram(programs_[ProgCollide]);
+    glUniform1ui(UCount, (GLuint)n);
+    glUniform1f(UDt, dt);
+    glUniform2f(UWorld, sim.worldW, sim.worldH);
+    glUniform2i(UGrid, cols, rows);
+    glUniform1f(UCellSize, cellSize);
+    glUniform1f(URestitution, sim.restitution);
+    glUniform1f(UDrag, sim.drag);
+    glUniform1i(UClampSlow, sim.gravityWells.empty() ? 1 : 0);
+    glDispatchCompute(groupsFor(n), 1, 1);
+
+    // Next step, the renderer's attribute fetch and download() all read what was just written
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    current_ = next;
+}
+
+void GpuSimulation::download(Simulation& sim) {
+    ORB_PROFILE_SCOPE("gpu.download");
+    ParticleStore& ps = sim.particles;
+    const size_t n = count_;
+    if (n == 0 || ps.size() != n) return;
+
+    auto deinterleave = [&](GLuint buffer, std::vector<float>& a, std::vector<float>& b) {
+        staging_.resize(n * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(n * 2 * sizeof(float)), staging_.data());
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = staging_[2 * i];
+            b[i] = staging_[2 * i + 1];
+        }
+    };
+    deinterleave(position_[current_], ps.x, ps.y);
+    deinterleave(velocity_[current_], ps.vx, ps.vy);
+}
+
+GpuParticleBuffers GpuSimulation::buffers() const {
+    GpuParticleBuffers b;
+    b.position = position_[current_];
+    b.radius = radius_;
+    b.color = color_;
+    b.count = count_;
+    return b;
+}
+
+#endif
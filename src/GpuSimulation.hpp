@@ -0,0 +1,104 @@
+/**
+ * @file GpuSimulation.hpp
+ * @brief Optional GPU backend: steps the particles with OpenGL 4.3 compute shaders.
+ *
+ * Particle state stays resident in shader storage buffers between steps.
+ * A step is three dispatches plus a scan:
+ * - well gravity and integration, which also bins each particle into a
+ *   uniform grid cell (atomic count per cell, rank within the cell);
+ * - a prefix sum of the cell counts, then a scatter, so each cell's
+ *   particles are contiguous (the GPU form of UniformGrid's counting
+ *   sort). The sum is three passes so it spreads over the GPU however
+ *   many cells there are: every 1024-cell block in its own workgroup, then
+ *   the block totals, then each block's offset added back;
+ * - collisions, drag and walls, one invocation per particle. Each particle
+ *   reads the previous positions and velocities of its 3x3 neighbourhood
+ *   and writes only itself into a second set of buffers, so no particle is
+ *   written twice. This is a Jacobi-style solve, where the CPU resolves
+ *   pairs one after another: each contact gets the CPU's response, but a
+ *   particle's contacts are averaged and separating pairs get no impulse,
+ *   so dense piles stay stable and take a few more steps to settle.
+ *
+ * The renderer draws straight from buffers(), so stepping on the GPU needs
+ * no per-frame upload. The CPU Simulation stays the owner of everything
+ * else. upload() copies its columns in, and download() copies positions and
+ * velocities back whenever the CPU needs them (edits, saving, N-body mode).
+ * Needs a GL 4.3 context. macOS stops at GL 4.1, so there init() always
+ * fails and the caller keeps the CPU path.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct Simulation;
+
+/** GL buffer names the renderer binds as instance attributes. */
+struct GpuParticleBuffers {
+    unsigned int position = 0;  ///< vec2 per particle
+    unsigned int radius = 0;    ///< float per particle
+    unsigned int color = 0;     ///< vec4 (RGBA) per particle
+    size_t count = 0;
+};
+
+/**
+ * @class GpuSimulation
+ * @brief Compute-shader copy of Simulation::update for the well-gravity (non N-body) path.
+ */
+class GpuSimulation {
+public:
+    GpuSimulation() = default;
+    ~GpuSimulation();
+
+    GpuSimulation(const GpuSimulation&) = delete;
+    GpuSimulation& operator=(const GpuSimulation&) = delete;
+
+    /**
+     * @brief Compile the compute programs.
+     * @return false without a current GL 4.3 context (prints why to stderr)
+     */
+    bool init();
+
+    /** @brief Replace the GPU state with sim's particles (full copy). */
+    void upload(const Simulation& sim);
+    /**
+     * @brief Advance the resident particles by dt using sim's parameters and wells.
+     *
+     * Ignores sim.nbody and sim.collisionMode, and does not record trails.
+     */
+    void step(const Simulation& sim, float dt);
+    /** @brief Copy positions and velocities back into sim (must still hold the uploaded particles). */
+    void download(Simulation& sim);
+
+    size_t size() const { return count_; }
+    GpuParticleBuffers buffers() const;
+
+private:
+    enum Program { ProgIntegrate, ProgScanBlocks, ProgScanSums, ProgScanAdd, ProgScatter, ProgCollide, ProgramCount };
+
+    /** @brief Grow the per-particle buffers to hold n particles (contents are lost). */
+    void reserveParticles(size_t n);
+    /** @brief Grow the cell buffers to hold n cells. */
+    void reserveCells(size_t n);
+
+    unsigned int programs_[ProgramCount] = {};
+    unsigned int position_[2] = {};   ///< Ping-pong: current_ is the latest state
+    unsigned int velocity_[2] = {};
+    unsigned int radius_ = 0;
+    unsigned int color_ = 0;
+    unsigned int cellOf_ = 0;         ///< Cell of each particle
+    unsigned int rank_ = 0;           ///< Index of each particle within its cell
+    unsigned int sorted_ = 0;         ///< Particle indices ordered by cell
+    unsigned int cellCount_ = 0;
+    unsigned int cellStart_ = 0;      ///< Exclusive prefix sum of cellCount_
+    unsigned int blockSums_ = 0;      ///< Scan scratch: one total (then offset) per 1024 cells
+    unsigned int wells_ = 0;          ///< vec4 per well (x, y, unused, unused)
+    int current_ = 0;
+    size_t count_ = 0;
+    size_t particleCapacity_ = 0;
+    size_t cellCapacity_ = 0;
+    size_t wellCapacity_ = 0;
+    float maxRadius_ = 0.0f;          ///< Sets the grid cell size
+    std::vector<float> staging_;      ///< Interleaving scratch for upload() / download()
+};
@@ -0,0 +1,165 @@
+/**
+ * @file GravityKernel.cpp
+ * @brief Scalar and SIMD implementations of the well-gravity kernel.
+ */
+
+#include "GravityKernel.hpp"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ORB_GRAVITY_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ORB_GRAVITY_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ORB_GRAVITY_NEON 1
+#endif
+
+void applyWellGravityScalar(const float* x, const float* y, float* vx, float* vy,
+                            size_t begin, size_t end,
+                            const GravityWell* wells, size_t wellCount,
+                            const GravityParams& params, float dt) {
+    for (size_t i = begin; i < end; ++i) {
+        for (size_t w = 0; w < wellCount; ++w) {
+            float dx = wells[w].pos.x - x[i];
+            float dy = wells[w].pos.y - y[i];
+            float distSq = dx * dx + dy * dy;
+            if (distSq < params.minDistSq) continue;
+            float dist = std::sqrt(distSq);
+            if (dist > params.range) continue;
+            float invDist = 1.0f / dist;
+            vx[i] += (dx * invDist) * params.pull * dt;
+            vy[i] += (dy * invDist) * params.pull * dt;
+        }
+    }
+}
+
+#if defined(ORB_GRAVITY_AVX2)
+
+void applyWellGravity(const float* x, const float* y, float* vx, float* vy,
+                      size_t begin, size_t end,
+                      const GravityWell* wells, size_t wellCount,
+                      const GravityParams& params, float dt) {
+    const __m256 pull = _mm256_set1_ps(params.pull);
+    const __m256 range = _mm256_set1_ps(params.range);
+    const __m256 minDistSq = _mm256_set1_ps(params.minDistSq);
+    const __m256 step = _mm256_set1_ps(dt);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i);
+        const __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pvx = _mm256_loadu_ps(vx + i);
+        __m256 pvy = _mm256_loadu_ps(vy + i);
+        for (size_t w = 0; w < wellCount; ++w) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(wells[w].pos.x), px);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(wells[w].pos.y), py);
+            __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 dist = _mm256_sqrt_ps(distSq);
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(distSq, minDistSq, _CMP_GE_OQ),
+                                        _mm256_cmp_ps(dist, range, _CMP_LE_OQ));
+            __m256 invDist = _mm256_div_ps(one, dist);
+            __m256 ax = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(dx, invDist), pull), step);
+            __m256 ay = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(dy, invDist), pull), step);
+            pvx = _mm256_add_ps(pvx, _mm256_and_ps(mask, ax));
+            pvy = _mm256_add_ps(pvy, _mm256_and_ps(mask, ay));
+        }
+        _mm256_storeu_ps(vx + i, pvx);
+        _mm256_storeu_ps(vy + i, pvy);
+    }
+    applyWellGravityScalar(x, y, vx, vy, i, end, wells, wellCount, params, dt);
+}
+
+const char* gravityKernelName() { return "avx2"; }
+
+#elif defined(ORB_GRAVITY_SSE2)
+
+void applyWellGravity(const float* x, const float* y, float* vx, float* vy,
+                      size_t begin, size_t end,
+                      const GravityWell* wells, size_t wellCount,
+                      const GravityParams& params, float dt) {
+    const __m128 pull = _mm_set1_ps(params.pull);
+    const __m128 range = _mm_set1_ps(params.range);
+    const __m128 minDistSq = _mm_set1_ps(params.minDistSq);
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i);
+        const __m128 py = _mm_loadu_ps(y + i);
+        __m128 pvx = _mm_loadu_ps(vx + i);
+        __m128 pvy = _mm_loadu_ps(vy + i);
+        for (size_t w = 0; w < wellCount; ++w) {
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(wells[w].pos.x), px);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(wells[w].pos.y), py);
+            __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            __m128 dist = _mm_sqrt_ps(distSq);
+            __m128 mask = _mm_and_ps(_mm_cmpge_ps(distSq, minDistSq), _mm_cmple_ps(dist, range));
+            __m128 invDist = _mm_div_ps(one, dist);
+            __m128 ax = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(dx, invDist), pull), step);
+            __m128 ay = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(dy, invDist), pull), step);
+            pvx = _mm_add_ps(pvx, _mm_and_ps(mask, ax));
+            pvy = _mm_add_ps(pvy, _mm_and_ps(mask, ay));
+        }
+        _mm_storeu_ps(vx + i, pvx);
+        _mm_storeu_ps(vy + i, pvy);
+    }
+    applyWellGravityScalar(x, y, vx, vy, i, end, wells, wellCount, params, dt);
+}
+
+const char* gravityKernelName() { return "sse2"; }
+
+#elif defined(ORB_GRAVITY_NEON)
+
+void applyWellGravity(const float* x, const float* y, float* vx, float* vy,
+                      size_t begin, size_t end,
+                      const GravityWell* wells, size_t wellCount,
+                      const GravityParams& params, float dt) {
+    const float32x4_t pull = vdupq_n_f32(params.pull);
+    const float32x4_t range = vdupq_n_f32(params.range);
+    const float32x4_t minDistSq = vdupq_n_f32(params.minDistSq);
+    const float32x4_t step = vdupq_n_f32(dt);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const float32x4_t px = vld1q_f32(x + i);
+        const float32x4_t py = vld1q_f32(y + i);
+        float32x4_t pvx = vld1q_f32(vx + i);
+        float32x4_t pvy = vld1q_f32(vy + i);
+        for (size_t w = 0; w < wellCount; ++w) {
+            float32x4_t dx = vsubq_f32(vdupq_n_f32(wells[w].pos.x), px);
+            float32x4_t dy = vsubq_f32(vdupq_n_f32(wells[w].pos.y), py);
+            float32x4_t distSq = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+            float32x4_t dist = vsqrtq_f32(distSq);
+            uint32x4_t mask = vandq_u32(vcgeq_f32(distSq, minDistSq), vcleq_f32(dist, range));
+            float32x4_t invDist = vdivq_f32(one, dist);
+            float32x4_t ax = vmulq_f32(vmulq_f32(vmulq_f32(dx, invDist), pull), step);
+            float32x4_t ay = vmulq_f32(vmulq_f32(vmulq_f32(dy, invDist), pull), step);
+            pvx = vaddq_f32(pvx, vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(ax))));
+            pvy = vaddq_f32(pvy, vreinterpretq_f32_u32(vandq_u32(mask, vreinterpretq_u32_f32(ay))));
+        }
+        vst1q_f32(vx + i, pvx);
+        vst1q_f32(vy + i, pvy);
+    }
+    applyWellGravityScalar(x, y, vx, vy, i, end, wells, wellCount, params, dt);
+}
+
+const char* gravityKernelName() { return "neon"; }
+
+#else
+
+void applyWellGravity(const float* x, const float* y, float* vx, float* vy,
+                      size_t begin, size_t end,
+                      const GravityWell* wells, size_t wellCount,
+                      const GravityParams& params, float dt) {
+    applyWellGravityScalar(x, y, vx, vy, begin, end, wells, wellCount, params, dt);
+}
+
+const char* gravityKernelName() { return "scalar"; }
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ * @file GravityKernel.hpp
+ * @brief Well-gravity force kernels over the SoA particle columns.
+ *
+ * Each well pulls every particle within range with a constant acceleration
+ * toward it. The vector kernel handles 4 (SSE2 / NEON) or 8 (AVX2) particles
+ * per iteration against each well, doing the range and singularity checks
+ * as lane masks rather than branches. The instruction set is picked at
+ * build time from the compiler's target flags.
+ *
+ * Tolerance: the vector kernel performs the same IEEE operations in the same
+ * order as the scalar one (sqrt, divide, multiplies, add), so results are
+ * bit-identical unless the compiler contracts the scalar path into FMAs;
+ * then they differ by at most 1 ulp per well per step.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include "GravityWell.hpp"
+
+/** Constants of the well pull, shared by every kernel variant. */
+struct GravityParams {
+    float pull;        ///< Acceleration toward the well (px/s²)
+    float range;       ///< Wells further away than this have no effect
+    float minDistSq;   ///< Particles closer than sqrt(minDistSq) are skipped (singularity)
+};
+
+/**
+ * @brief Reference kernel: add well gravity to vx/vy for particles [begin, end).
+ */
+void applyWellGravityScalar(const float* x, const float* y, float* vx, float* vy,
+                            size_t begin, size_t end,
+                            const GravityWell* wells, size_t wellCount,
+                            const GravityParams& params, float dt);
+
+/**
+ * @brief Vectorized kernel with the same contract as applyWellGravityScalar().
+ *
+ * Falls back to the scalar kernel when no vector instruction set is available.
+ */
+void applyWellGravity(const float* x, const float* y, float* vx, float* vy,
+                      size_t begin, size_t end,
+                      const GravityWell* wells, size_t wellCount,
+                      const GravityParams& params, float dt);
+
+/** @brief Name of the instruction set applyWellGravity() was built for ("avx2", "sse2", "neon", "scalar"). */
+const char* gravityKernelName();
@@ -0,0 +1,145 @@
+/**
+ * @file JobSystem.cpp
+ * @brief Implementation of the work-stealing thread pool.
+ */
+
+#include "JobSystem.hpp"
+#include <algorithm>
+
+namespace {
+    /// Pool the calling thread is working for, and its index there
+    thread_local const JobSystem* tlsPool = nullptr;
+    thread_local int tlsWorkerIndex = 0;
+}
+
+JobSystem::JobSystem(int threadCount) {
+    int n = threadCount > 0 ? threadCount : (int)std::thread::hardware_concurrency();
+    n = std::max(n, 1);
+    for (int i = 0; i < n; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+    // Worker 0 is whichever thread calls parallelFor()
+    for (int i = 1; i < n; ++i)
+        threads_.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_)
+        t.join();
+}
+
+int JobSystem::workerIndex() const {
+    return tlsPool == this ? tlsWorkerIndex : 0;
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const RangeFn& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    // An outside thread is worker 0 for the batch, even when it runs the
+    // range inline; a second one would share that index (and its deque),
+    // so it waits its turn
+    const bool outside = tlsPool != this;
+    std::unique_lock<std::mutex> caller(callerMutex_, std::defer_lock);
+    if (outside) caller.lock();
+    const int workers = threadCount();
+    if (workers == 1 || count <= grain) {
+        fn(0, count);
+        return;
+    }
+    const JobSystem* outerPool = tlsPool;
+    const int outerIndex = tlsWorkerIndex;
+    if (outside) {
+        tlsPool = this;
+        tlsWorkerIndex = 0;
+    }
+
+    // Deal chunks round-robin so every worker starts with local work
+    const size_t chunks = (count + grain - 1) / grain;
+    std::atomic<size_t> remaining{chunks};
+    for (size_t c = 0; c < chunks; ++c) {
+        Task t;
+        t.fn = &fn;
+        t.begin = c * grain;
+        t.end = std::min(count, t.begin + grain);
+        t.remaining = &remaining;
+        Queue& q = *queues_[c % workers];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(t);
+        queued_.fetch_add(1, std::memory_order_relaxed);  // Counted once it can be found
+    }
+    {
+        // A worker that saw queued_ == 0 holds sleepMutex_ until it waits,
+        // so once this lock is taken it is waiting and gets the notify
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wake_.notify_all();
+
+    // Help until this batch is done (may also run chunks of other batches)
+    const int self = tlsWorkerIndex;
+    Task t;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (findTask(self, t))
+            run(t);
+        else
+            std::this_thread::yield();
+    }
+
+    if (outside) {
+        tlsPool = outerPool;  // Back to the pool (if any) this thread came from
+        tlsWorkerIndex = outerIndex;
+    }
+}
+
+void JobSystem::workerLoop(int index) {
+    tlsPool = this;
+    tlsWorkerIndex = index;
+    Task t;
+    for (;;) {
+        if (findTask(index, t)) {
+            run(t);
+            continue;
+        }
+        // A task went to a deque this scan had already passed, or another
+        // thread took it first: back off rather than spin on the deques
+        if (queued_.load(std::memory_order_relaxed) > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_relaxed) > 0; });
+        if (stopping_) return;
+    }
+}
+
+bool JobSystem::popOwn(int index, Task& out) {
+    Queue& q = *queues_[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    out = q.tasks.back();
+    q.tasks.pop_back();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::steal(int thief, Task& out) {
+    const int n = threadCount();
+    for (int k = 1; k < n; ++k) {
+        Queue& q = *queues_[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        out = q.tasks.front();
+        q.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::run(const Task& task) {
+    (*task.fn)(task.begin, task.end);
+    task.remaining->fetch_sub(1, std::memory_order_acq_rel);
+}
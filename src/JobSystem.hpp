@@ -0,0 +1,96 @@
+/**
+ * @file JobSystem.hpp
+ * @brief Fixed thread pool with per-worker work-stealing deques.
+ *
+ * The only entry point is parallelFor(): a range is cut into chunks, the
+ * chunks are dealt round-robin onto the workers' deques, and idle workers
+ * steal from the other end of their neighbours' deques. The calling thread
+ * takes part as worker 0 and returns once every chunk has run.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobSystem
+ * @brief Work-stealing pool used by the simulation's parallel passes.
+ */
+class JobSystem {
+public:
+    /// Chunk body: processes [begin, end)
+    using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+    /**
+     * @brief Start the pool.
+     * @param threadCount Total threads including the caller; 0 = hardware concurrency
+     */
+    explicit JobSystem(int threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /** @brief Number of threads that run chunks (workers + calling thread). */
+    int threadCount() const { return (int)queues_.size(); }
+
+    /**
+     * @brief Run fn over [0, count) in chunks of about grain items and wait.
+     * @param count Number of items
+     * @param grain Items per chunk; ranges no larger than this run inline
+     * @param fn Chunk body (must be safe to call concurrently on disjoint ranges)
+     *
+     * Chunks may issue nested batches. Only one thread outside the pool
+     * takes part as worker 0 at a time; an outside thread that calls while
+     * another one is in a batch waits for it to finish first.
+     */
+    void parallelFor(size_t count, size_t grain, const RangeFn& fn);
+
+    /**
+     * @brief Index of the calling thread in [0, threadCount()) while inside a chunk.
+     *
+     * The thread that calls parallelFor() is 0, and so is any thread that is
+     * not one of this pool's workers (a worker of another pool included).
+     * Outside callers take turns, so at most one of them is 0 at a time and
+     * pass-local accumulators can be indexed with this to stay free of
+     * atomics.
+     */
+    int workerIndex() const;
+
+private:
+    /// One chunk of a parallelFor batch
+    struct Task {
+        const RangeFn* fn = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<size_t>* remaining = nullptr;
+    };
+
+    /// A worker's deque; the owner pops the back, thieves take the front
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popOwn(int index, Task& out);
+    bool steal(int thief, Task& out);
+    bool findTask(int index, Task& out) { return popOwn(index, out) || steal(index, out); }
+    void run(const Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{0};   ///< Tasks sitting in any deque (changed under the deque's mutex)
+    std::mutex callerMutex_;          ///< Held by the outside thread in parallelFor() as worker 0
+    bool stopping_ = false;           ///< Guarded by sleepMutex_
+};
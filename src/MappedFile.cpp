@@ -0,0 +1,67 @@
+/**
+ * @file MappedFile.cpp
+ * @brief mmap-based implementation, with a plain read fallback on Windows.
+ */
+
+#include "MappedFile.hpp"
+#include <cstdio>
+
+#if defined(_WIN32)
+#define ORB_MMAP 0
+#else
+#define ORB_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const char* path) {
+    close();
+#if ORB_MMAP
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) return false;
+    mapping_ = mapping;
+    size_ = (size_t)st.st_size;
+    data_ = static_cast<const unsigned char*>(mapping);
+    return true;
+#else
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    long len = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    if (len <= 0) {
+        std::fclose(f);
+        return false;
+    }
+    buffer_.resize((size_t)len);
+    const size_t got = std::fread(buffer_.data(), 1, buffer_.size(), f);
+    std::fclose(f);
+    if (got != buffer_.size()) {
+        buffer_.clear();
+        return false;
+    }
+    size_ = buffer_.size();
+    data_ = buffer_.data();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#if ORB_MMAP
+    if (mapping_) munmap(mapping_, size_);
+#endif
+    mapping_ = nullptr;
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file MappedFile.hpp
+ * @brief Read-only view of a whole file: memory-mapped on POSIX, read into memory elsewhere.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class MappedFile
+ * @brief Owns a read-only mapping of one file for its lifetime.
+ *
+ * The mapping is page-aligned, so any offset that is a multiple of the
+ * element alignment can be reinterpreted in place.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map path; replaces any previous mapping.
+     * @return false if the file is missing, empty or cannot be mapped
+     */
+    bool open(const char* path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    void* mapping_ = nullptr;             ///< mmap base (POSIX)
+    std::vector<unsigned char> buffer_;   ///< File contents (no mmap)
+};
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 /**
  * @struct Vec2
@@ -45,13 +47,34 @@ struct Vec2 {
     Vec2 normalized() const {
         float len = length();
         if (len <= 0.0f) return Vec2(0.0f, 0.0f);
-        return Vec2(x / len, y / len);
+        const float inv = 1.0f / len;  // One divide, not one per component
+        return Vec2(x * inv, y * inv);
     }
 };
 
 /// Dot product of two vectors
 inline float dot(const Vec2& a, const Vec2& b) { return a.dot(b); }
 
+/// Reciprocal square root, correctly rounded sqrt then divide (v > 0)
+inline float rsqrt(float v) { return 1.0f / std::sqrt(v); }
+
+/**
+ * @brief Approximate reciprocal square root: bit-level estimate plus one Newton step.
+ * @param v Value (> 0)
+ * @return 1/sqrt(v) within a relative error of about 1.8e-3
+ *
+ * Only worth it where that error is acceptable and the target has no fast
+ * sqrt; orb_microbench measures it against rsqrt() on the build machine.
+ */
+inline float fastRsqrt(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    std::memcpy(&y, &bits, sizeof y);
+    return y * (1.5f - 0.5f * v * y * y);
+}
+
 /**
  * @struct Color
  * @brief RGBA color with components in range [0.0, 1.0].
@@ -0,0 +1,84 @@
+/**
+ * @file MortonOrder.cpp
+ * @brief Implementation of the Morton code radix sort.
+ */
+
+#include "MortonOrder.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /// Spread the low 16 bits of v to the even bit positions
+    inline uint32_t spreadBits(uint32_t v) {
+        v &= 0x0000FFFFu;
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    }
+
+    const float QUANT_MAX = 65535.0f;
+}
+
+uint32_t mortonCode(uint16_t x, uint16_t y) {
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+float meanNeighbourGap(const float* x, const float* y, size_t n) {
+    if (n < 2) return 0.0f;
+    double total = 0.0;
+    for (size_t i = 1; i < n; ++i)
+        total += std::abs(x[i] - x[i - 1]) + std::abs(y[i] - y[i - 1]);  // Manhattan: no sqrt
+    return (float)(total / (double)(n - 1));
+}
+
+void MortonOrder::sort(const float* x, const float* y, size_t n) {
+    order.resize(n);
+    codes.resize(n);
+    if (n == 0) return;
+
+    // Quantize over the bounding box, with one scale for both axes so the
+    // curve's cells stay square
+    float minX = x[0], maxX = minX, minY = y[0], maxY = minY;
+    for (size_t i = 1; i < n; ++i) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+    const float span = std::max(std::max(maxX - minX, maxY - minY), 1.0e-6f);
+    const float scale = QUANT_MAX / span;
+    for (size_t i = 0; i < n; ++i) {
+        const float qx = std::min((x[i] - minX) * scale, QUANT_MAX);
+        const float qy = std::min((y[i] - minY) * scale, QUANT_MAX);
+        codes[i] = mortonCode((uint16_t)qx, (uint16_t)qy);
+        order[i] = (uint32_t)i;
+    }
+
+    // LSD radix sort on the codes, carrying the indices along
+    codeScratch_.resize(n);
+    orderScratch_.resize(n);
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t count[257] = {};
+        for (size_t i = 0; i < n; ++i)
+            ++count[((codes[i] >> shift) & 0xFFu) + 1];
+        if (std::find(count + 1, count + 257, n) != count + 257) continue;  // Byte is the same everywhere
+        for (int b = 1; b <= 256; ++b)
+            count[b] += count[b - 1];
+        for (size_t i = 0; i < n; ++i) {
+            const size_t dst = count[(codes[i] >> shift) & 0xFFu]++;
+            codeScratch_[dst] = codes[i];
+            orderScratch_[dst] = order[i];
+        }
+        codes.swap(codeScratch_);
+        order.swap(orderScratch_);
+    }
+}
+
+void MortonOrder::release() {
+    std::vector<uint32_t>().swap(order);
+    std::vector<uint32_t>().swap(codes);
+    std::vector<uint32_t>().swap(codeScratch_);
+    std::vector<uint32_t>().swap(orderScratch_);
+}
@@ -0,0 +1,44 @@
+/**
+ * @file MortonOrder.hpp
+ * @brief Z-order (Morton) sort of particle positions for a cache-friendly layout.
+ *
+ * Positions are quantized to 16 bits per axis over their bounding box and
+ * the bits interleaved into a 32-bit code, so particles that are close in
+ * space get close codes. An LSD radix sort (four 8-bit passes, skipping
+ * passes where every key has the same byte) orders the indices by code in
+ * O(n).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** @brief Interleave the bits of x (even positions) and y (odd positions). */
+uint32_t mortonCode(uint16_t x, uint16_t y);
+
+/**
+ * @brief Mean distance between particles that are next to each other in memory.
+ *
+ * Low right after a Morton sort and growing as particles drift apart; used
+ * as the disorder metric that decides when to sort again.
+ */
+float meanNeighbourGap(const float* x, const float* y, size_t n);
+
+/**
+ * @struct MortonOrder
+ * @brief Radix-sorted Z-order permutation; buffers are kept until release().
+ */
+struct MortonOrder {
+    std::vector<uint32_t> order;  ///< order[i] = index of the particle that goes to slot i
+    std::vector<uint32_t> codes;  ///< Morton code of order[i] after sort()
+
+    /** @brief Fill order with 0..n-1 sorted by the Morton code of (x, y). */
+    void sort(const float* x, const float* y, size_t n);
+    /** @brief Free order, codes and the radix buffers until the next sort(). */
+    void release();
+
+private:
+    std::vector<uint32_t> codeScratch_, orderScratch_;  ///< Radix ping-pong buffers
+};
@@ -1,9 +1,11 @@
 /**
  * @file Particle.hpp
- * @brief Particle data structure definition.
- * 
+ * @brief Particle value type.
+ *
  * A particle represents a single moving circle in the simulation.
  * Contains position, velocity, size (radius), and visual color.
+ * The simulation itself stores particles column-wise in ParticleStore;
+ * this struct is what goes in and comes out of it.
  */
 
 #pragma once
@@ -13,7 +15,7 @@
 /**
  * @struct Particle
  * @brief Represents a single particle in the simulation.
- * 
+ *
  * Each particle has:
  * - Position (Vec2): current x,y location in world space
  * - Velocity (Vec2): current x,y velocity in pixels per second
@@ -23,25 +25,10 @@
 struct Particle {
     Vec2 pos;
     Vec2 vel;
-    float radius;
+    float radius = 1.0f;
     Color color;
-    
-    // Trail history for rendering glowing trails
-    static constexpr int MAX_TRAIL_LENGTH = 60;
-    Vec2 trail[MAX_TRAIL_LENGTH];
-    int trailLength = 0;
-    int trailIndex = 0;
 
+    Particle() = default;
     Particle(Vec2 pos_, Vec2 vel_, float radius_, Color color_)
-        : pos(pos_), vel(vel_), radius(radius_), color(color_) {
-        // Initialize trail with current position
-        for (int i = 0; i < MAX_TRAIL_LENGTH; ++i) trail[i] = pos_;
-        trailLength = 1;
-    }
-    
-    void updateTrail() {
-        trail[trailIndex] = pos;
-        trailIndex = (trailIndex + 1) % MAX_TRAIL_LENGTH;
-        if (trailLength < MAX_TRAIL_LENGTH) trailLength++;
-    }
+        : pos(pos_), vel(vel_), radius(radius_), color(color_) {}
 };
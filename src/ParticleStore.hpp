@@ -0,0 +1,564 @@
+/**
+ * @file ParticleStore.hpp
+ * @brief Structure-of-arrays particle storage and read-only views over it.
+ *
+ * Physics passes only touch position, velocity and radius, so those live in
+ * their own contiguous columns. Trail history is kept in a separate ring
+ * arena that the physics passes never stream through, and only for the
+ * particles that have a trail.
+ *
+ * Columns stay dense (no holes for the hot loops to skip): removal moves the
+ * last particle into the gap, and permute() may reorder everything for
+ * locality. Code that must keep referring to one particle across frames
+ * holds a ParticleHandle, which a slot map translates to the particle's
+ * current column index.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "Math.hpp"
+#include "Particle.hpp"
+#include "Span.hpp"
+
+/**
+ * @struct TrailView
+ * @brief Read-only view of trail history: one ring per particle that has a trail.
+ */
+struct TrailView {
+    Span<const int32_t> ringOf;  ///< Ring per particle, or TrailBuffer::NONE
+    Span<const Vec2> points;     ///< capacity points per ring, ring-major
+    Span<const int> length;      ///< Valid samples per ring
+    Span<const int> head;        ///< Next write slot per ring
+    int capacity = 0;            ///< Ring size
+
+    size_t size() const { return ringOf.size(); }
+
+    /// Valid samples of particle i (0 without a trail)
+    int lengthOf(size_t i) const {
+        return ringOf[i] < 0 ? 0 : length[(size_t)ringOf[i]];
+    }
+
+    /// k-th sample of particle i, oldest first (k < lengthOf(i))
+    Vec2 point(size_t i, int k) const {
+        const size_t r = (size_t)ringOf[i];
+        int idx = (head[r] - length[r] + k + capacity) % capacity;
+        return points[r * (size_t)capacity + idx];
+    }
+};
+
+/**
+ * @struct TrailBuffer
+ * @brief Position history for the particles that have a trail, in a shared ring arena.
+ *
+ * A particle only holds the index of its ring (NONE without one), so a
+ * particle without a trail costs 4 bytes here, and removal and reordering
+ * move that index rather than the history. Rings are capacity samples long
+ * and recycled through a free list. record() keeps a new sample only once
+ * the particle is spacing away from its previous one, so slow or resting
+ * particles do not fill their ring with the same point.
+ *
+ * Rings dominate a particle's memory when every particle has one: at the
+ * defaults orb_bench measures about 256 B/p with trails against 56 B/p
+ * without (another 288 B/p with the former 60 samples).
+ */
+struct TrailBuffer {
+    /// 24 samples 2.5 px apart: as long a trail as 60 at 1 px, for 192 B per ring instead of 480
+    static constexpr int DEFAULT_LENGTH = 24;
+    static constexpr float DEFAULT_SPACING = 2.5f;
+    static constexpr int32_t NONE = -1;
+
+    std::vector<int32_t> ringOf;     ///< Ring per particle, or NONE
+    std::vector<Vec2> points;        ///< capacity samples per ring
+    std::vector<int> length;         ///< Valid samples per ring
+    std::vector<int> head;           ///< Next write slot per ring
+    std::vector<int32_t> freeRings;  ///< Rings no particle owns
+    std::vector<int32_t> spare;      ///< permute() target; empty outside permute()
+    int capacity = DEFAULT_LENGTH;   ///< Samples per ring (change with setCapacity())
+    float spacing = DEFAULT_SPACING; ///< Minimum distance between kept samples (0 = keep every one)
+    bool enabled = true;             ///< New particles get a ring (change with setEnabled())
+    bool deferred = false;           ///< assign() left particles without the ring they are due
+
+    bool hasTrail(size_t i) const { return ringOf[i] != NONE; }
+
+    void add(Vec2 pos) {
+        ringOf.push_back(NONE);
+        if (enabled) attach(ringOf.size() - 1, pos);
+    }
+
+    /// add() for each of n positions
+    void addBatch(const Particle* p, size_t n) {
+        const size_t first = ringOf.size();
+        ringOf.resize(first + n, NONE);
+        if (!enabled) return;
+        for (size_t i = 0; i < n; ++i)
+            attach(first + i, p[i].pos);
+    }
+
+    /// Give particle i a ring starting at pos (no-op if it has one)
+    void attach(size_t i, Vec2 pos) {
+        if (ringOf[i] != NONE) return;
+        int32_t r;
+        if (freeRings.empty()) {
+            r = (int32_t)length.size();
+            points.resize(points.size() + (size_t)capacity);
+            length.push_back(0);
+            head.push_back(0);
+        } else {
+            r = freeRings.back();
+            freeRings.pop_back();
+        }
+        points[(size_t)r * capacity] = pos;
+        length[r] = 1;
+        head[r] = 1 % capacity;
+        ringOf[i] = r;
+    }
+
+    /// Return particle i's ring to the free list (no-op without one)
+    void detach(size_t i) {
+        if (ringOf[i] == NONE) return;
+        freeRings.push_back(ringOf[i]);
+        ringOf[i] = NONE;
+    }
+
+    /// Record the current position of particles [begin, end) that have a ring
+    void record(const float* x, const float* y, size_t begin, size_t end) {
+        const float minSq = spacing * spacing;
+        for (size_t i = begin; i < end; ++i) {
+            const int32_t r = ringOf[i];
+            if (r == NONE) continue;
+            Vec2* ring = points.data() + (size_t)r * capacity;
+            const Vec2 last = ring[(head[r] + capacity - 1) % capacity];
+            const float dx = x[i] - last.x, dy = y[i] - last.y;
+            if (dx * dx + dy * dy < minSq) continue;
+            ring[head[r]] = Vec2(x[i], y[i]);
+            head[r] = (head[r] + 1) % capacity;
+            if (length[r] < capacity) length[r]++;
+        }
+    }
+
+    /**
+     * @brief Replace every trail with n particles that have no ring yet.
+     *
+     * Unlike add(), rings are not attached here: deferred is set and the
+     * owner attaches them later (Simulation does on its next step, and only
+     * inside the trail region), so a bulk load into a narrow view or with
+     * trails about to be turned off never fills a ring per particle.
+     */
+    void assign(size_t n) {
+        clear();
+        ringOf.assign(n, NONE);
+        deferred = enabled && n > 0;
+    }
+
+    /**
+     * @brief Turn trails on (every particle gets a ring at its position) or off (all memory released).
+     */
+    void setEnabled(bool on, const float* x, const float* y) {
+        enabled = on;
+        deferred = false;
+        if (on) {
+            for (size_t i = 0; i < ringOf.size(); ++i)
+                attach(i, Vec2(x[i], y[i]));
+            return;
+        }
+        std::fill(ringOf.begin(), ringOf.end(), NONE);
+        std::vector<Vec2>().swap(points);
+        std::vector<int>().swap(length);
+        std::vector<int>().swap(head);
+        std::vector<int32_t>().swap(freeRings);
+    }
+
+    /// Change the ring length; every trail restarts from its newest sample
+    void setCapacity(int samples) {
+        samples = std::max(samples, 2);
+        std::vector<Vec2> resized((size_t)length.size() * samples);
+        for (size_t r = 0; r < length.size(); ++r) {
+            resized[r * samples] = points[r * capacity + (head[r] + capacity - 1) % capacity];
+            length[r] = 1;
+            head[r] = 1;
+        }
+        points.swap(resized);
+        capacity = samples;
+    }
+
+    /// Drop particles from n on, returning their rings
+    void truncate(size_t n) {
+        for (size_t i = n; i < ringOf.size(); ++i)
+            detach(i);
+        ringOf.resize(std::min(n, ringOf.size()));
+    }
+
+    /// Move the last particle's ring into slot i and drop the last
+    void swapRemove(size_t i) {
+        detach(i);
+        ringOf[i] = ringOf.back();
+        ringOf.pop_back();
+    }
+
+    /// Reorder particles so slot i receives the old slot order[i] (rings stay where they are)
+    void permute(const uint32_t* order) {
+        const size_t n = ringOf.size();
+        spare.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            spare[i] = ringOf[order[i]];
+        ringOf.swap(spare);
+        std::vector<int32_t>().swap(spare);  // Reorders are rare: not worth 4 B/p between them
+    }
+
+    void clear() {
+        ringOf.clear();
+        points.clear();
+        length.clear();
+        head.clear();
+        freeRings.clear();
+        deferred = false;
+    }
+
+    void reserve(size_t n) {
+        ringOf.reserve(n);
+        if (!enabled) return;
+        points.reserve(n * (size_t)capacity);
+        length.reserve(n);
+        head.reserve(n);
+    }
+
+    /// Bytes held, including reserved capacity
+    size_t memoryBytes() const {
+        return ringOf.capacity() * sizeof(int32_t) + points.capacity() * sizeof(Vec2)
+             + (length.capacity() + head.capacity()) * sizeof(int)
+             + (freeRings.capacity() + spare.capacity()) * sizeof(int32_t);
+    }
+
+    TrailView view() const {
+        TrailView v;
+        v.ringOf = ringOf;
+        v.points = points;
+        v.length = length;
+        v.head = head;
+        v.capacity = capacity;
+        return v;
+    }
+};
+
+/**
+ * @struct ParticleView
+ * @brief Read-only view of the columns the renderer needs.
+ */
+struct ParticleView {
+    Span<const float> x;
+    Span<const float> y;
+    Span<const float> radius;
+    Span<const Color> color;
+
+    size_t size() const { return x.size(); }
+};
+
+/**
+ * @struct ParticleHandle
+ * @brief Stable reference to one particle; goes stale once that particle is removed.
+ */
+struct ParticleHandle {
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+    uint32_t slot = INVALID;   ///< Slot-map entry
+    uint32_t generation = 0;   ///< Must match the slot's generation to be valid
+
+    bool operator==(const ParticleHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const ParticleHandle& o) const { return !(*this == o); }
+};
+
+/**
+ * @struct ParticleStore
+ * @brief Particles stored column-wise (structure of arrays).
+ *
+ * Column i of every array belongs to the same particle. All columns always
+ * have the same length; add(), remove() and clear() keep them in step.
+ * reserve() preallocates every column, so spawning up to that count never
+ * reallocates (and never copies trail history) mid-frame.
+ */
+struct ParticleStore {
+    static constexpr size_t NPOS = (size_t)-1;
+
+    /** Slot-map entry: where a handle's particle currently lives */
+    struct Slot {
+        uint32_t index;       ///< Column index, or ParticleHandle::INVALID while free
+        uint32_t generation;  ///< Bumped each time the slot is freed
+    };
+
+    std::vector<float> x;       ///< Position X
+    std::vector<float> y;       ///< Position Y
+    std::vector<float> vx;      ///< Velocity X
+    std::vector<float> vy;      ///< Velocity Y
+    std::vector<float> radius;  ///< Circle radius
+    std::vector<Color> color;   ///< Render color
+    TrailBuffer trails;         ///< Trail history (not touched by physics passes)
+    uint32_t layoutVersion = 0; ///< Bumped whenever an index may stop referring to the same particle
+    std::vector<uint32_t> slotOf;   ///< Column index -> slot
+    std::vector<Slot> slots;        ///< Slot -> column index and generation
+    std::vector<uint32_t> freeSlots;///< Free list (stack) of unused slots
+    std::vector<float> spareFloats;     ///< permute() targets, one per element type: each is
+    std::vector<Color> spareColors;     ///< swapped with the column it was filled for, so it
+    std::vector<uint32_t> spareSlots;   ///< takes the old column's storage into the next gather;
+                                        ///< all three are freed again when permute() returns
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    ParticleHandle add(const Particle& p) {
+        const uint32_t slot = acquireSlot();
+        slots[slot].index = (uint32_t)x.size();
+        slotOf.push_back(slot);
+
+        x.push_back(p.pos.x);
+        y.push_back(p.pos.y);
+        vx.push_back(p.vel.x);
+        vy.push_back(p.vel.y);
+        radius.push_back(p.radius);
+        color.push_back(p.color);
+        trails.add(p.pos);
+        return ParticleHandle{ slot, slots[slot].generation };
+    }
+
+    /**
+     * @brief Append a whole batch, growing every column at most once.
+     *
+     * Same result as add() per particle (handles are issued in order) but
+     * each column is written in one pass. Capacity grows geometrically, so
+     * a steady stream of batches reallocates only O(log n) times.
+     */
+    void addBatch(Span<const Particle> batch) {
+        const size_t first = x.size(), n = batch.size();
+        if (first + n > capacity())
+            reserve(std::max(first + n, 2 * capacity()));
+        x.resize(first + n);
+        y.resize(first + n);
+        vx.resize(first + n);
+        vy.resize(first + n);
+        radius.resize(first + n);
+        color.resize(first + n);
+        slotOf.resize(first + n);
+        for (size_t i = 0; i < n; ++i) {
+            const Particle& p = batch[i];
+            x[first + i] = p.pos.x;
+            y[first + i] = p.pos.y;
+            vx[first + i] = p.vel.x;
+            vy[first + i] = p.vel.y;
+            radius[first + i] = p.radius;
+            color[first + i] = p.color;
+        }
+        for (size_t i = first; i < first + n; ++i) {
+            slotOf[i] = acquireSlot();
+            slots[slotOf[i]].index = (uint32_t)i;
+        }
+        trails.addBatch(batch.data(), n);
+    }
+
+    /// Column index of h, or NPOS if the particle has been removed
+    size_t indexOf(ParticleHandle h) const {
+        if (h.slot >= slots.size() || slots[h.slot].generation != h.generation) return NPOS;
+        const uint32_t index = slots[h.slot].index;
+        return index == ParticleHandle::INVALID ? NPOS : index;
+    }
+
+    bool contains(ParticleHandle h) const { return indexOf(h) != NPOS; }
+
+    /// Handle for the particle currently at column i
+    ParticleHandle handleAt(size_t i) const {
+        const uint32_t slot = slotOf[i];
+        return ParticleHandle{ slot, slots[slot].generation };
+    }
+
+    /**
+     * @brief Remove the particle at column i in O(1).
+     *
+     * The last particle moves into column i; its handle stays valid.
+     */
+    void removeAt(size_t i) {
+        const size_t last = x.size() - 1;
+        const uint32_t slot = slotOf[i];
+        if (i != last) {
+            x[i] = x[last];
+            y[i] = y[last];
+            vx[i] = vx[last];
+            vy[i] = vy[last];
+            radius[i] = radius[last];
+            color[i] = color[last];
+            slotOf[i] = slotOf[last];
+            slots[slotOf[i]].index = (uint32_t)i;
+        }
+        x.pop_back();
+        y.pop_back();
+        vx.pop_back();
+        vy.pop_back();
+        radius.pop_back();
+        color.pop_back();
+        slotOf.pop_back();
+        trails.swapRemove(i);
+        releaseSlot(slot);
+        ++layoutVersion;
+    }
+
+    /**
+     * @brief Remove every particle from column n on.
+     *
+     * No remaining particle moves, so unlike removal this keeps
+     * layoutVersion: indices and per-index state of the rest stay valid.
+     */
+    void truncate(size_t n) {
+        if (n >= x.size()) return;
+        for (size_t i = n; i < x.size(); ++i)
+            releaseSlot(slotOf[i]);
+        x.resize(n);
+        y.resize(n);
+        vx.resize(n);
+        vy.resize(n);
+        radius.resize(n);
+        color.resize(n);
+        slotOf.resize(n);
+        trails.truncate(n);
+    }
+
+    /// Remove the particle h refers to; false if it is already gone
+    bool remove(ParticleHandle h) {
+        const size_t i = indexOf(h);
+        if (i == NPOS) return false;
+        removeAt(i);
+        return true;
+    }
+
+    /**
+     * @brief Reorder every column so column i receives the old column order[i].
+     *
+     * order must be a permutation of 0..size()-1. Handles follow their
+     * particles; bare column indices do not, so layoutVersion is bumped.
+     * The scratch columns are allocated here and freed before returning, so
+     * a store that is reordered now and then does not carry 24 B/p for it.
+     */
+    void permute(const uint32_t* order) {
+        gather(x, spareFloats, order);
+        gather(y, spareFloats, order);
+        gather(vx, spareFloats, order);
+        gather(vy, spareFloats, order);
+        gather(radius, spareFloats, order);
+        gather(color, spareColors, order);
+        gather(slotOf, spareSlots, order);
+        std::vector<float>().swap(spareFloats);
+        std::vector<Color>().swap(spareColors);
+        std::vector<uint32_t>().swap(spareSlots);
+        trails.permute(order);
+        for (size_t i = 0; i < slotOf.size(); ++i)
+            slots[slotOf[i]].index = (uint32_t)i;
+        ++layoutVersion;
+    }
+
+    /// Gather particle i back into a value (not for hot loops)
+    Particle get(size_t i) const {
+        return Particle(Vec2(x[i], y[i]), Vec2(vx[i], vy[i]), radius[i], color[i]);
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        vx.clear();
+        vy.clear();
+        radius.clear();
+        color.clear();
+        trails.clear();
+        // Free every live slot so outstanding handles go stale; storage is kept
+        for (uint32_t slot : slotOf)
+            releaseSlot(slot);
+        slotOf.clear();
+        ++layoutVersion;
+    }
+
+    /**
+     * @brief Replace every particle with n particles copied column-wise.
+     *
+     * Bulk equivalent of clear() followed by n add() calls; handles are
+     * reissued and any old handle goes stale. Trails are the exception:
+     * the particles start without rings (see TrailBuffer::assign()).
+     */
+    void assign(size_t n, const float* px, const float* py, const float* pvx, const float* pvy,
+                const float* pr, const Color* pcolor) {
+        clear();
+        x.assign(px, px + n);
+        y.assign(py, py + n);
+        vx.assign(pvx, pvx + n);
+        vy.assign(pvy, pvy + n);
+        radius.assign(pr, pr + n);
+        color.assign(pcolor, pcolor + n);
+        trails.assign(n);  // Rings follow on the owner's next trail pass
+
+        slotOf.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            slotOf[i] = acquireSlot();
+            slots[slotOf[i]].index = (uint32_t)i;
+        }
+    }
+
+    void reserve(size_t n) {
+        x.reserve(n);
+        y.reserve(n);
+        vx.reserve(n);
+        vy.reserve(n);
+        radius.reserve(n);
+        color.reserve(n);
+        trails.reserve(n);
+        slotOf.reserve(n);
+        slots.reserve(n);
+        freeSlots.reserve(n);
+    }
+
+    /// Number of particles that fit without reallocating
+    size_t capacity() const { return x.capacity(); }
+
+    /// Bytes held by every column, the slot map and the trails, including reserved capacity
+    size_t memoryBytes() const {
+        return (x.capacity() + y.capacity() + vx.capacity() + vy.capacity() + radius.capacity()
+                + spareFloats.capacity()) * sizeof(float)
+             + (color.capacity() + spareColors.capacity()) * sizeof(Color) + trails.memoryBytes()
+             + (slotOf.capacity() + freeSlots.capacity() + spareSlots.capacity()) * sizeof(uint32_t)
+             + slots.capacity() * sizeof(Slot);
+    }
+
+    ParticleView view() const {
+        ParticleView v;
+        v.x = x;
+        v.y = y;
+        v.radius = radius;
+        v.color = color;
+        return v;
+    }
+
+private:
+    /// column = column[order[i]] for each i, built in spare and swapped in (spare gets the old column)
+    template <typename T>
+    static void gather(std::vector<T>& column, std::vector<T>& spare, const uint32_t* order) {
+        const size_t n = column.size();
+        spare.reserve(column.capacity());  // Keeps the reserved capacity; a no-op after the first reorder
+        spare.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            spare[i] = column[order[i]];
+        column.swap(spare);
+    }
+
+    uint32_t acquireSlot() {
+        if (freeSlots.empty()) {
+            slots.push_back(Slot{ 0, 0 });
+            return (uint32_t)slots.size() - 1;
+        }
+        const uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    void releaseSlot(uint32_t slot) {
+        slots[slot].index = ParticleHandle::INVALID;
+        ++slots[slot].generation;
+        freeSlots.push_back(slot);
+    }
+};
@@ -0,0 +1,259 @@
+/**
+ * @file Player.cpp
+ * @brief Implementation of trajectory indexing, decoding and the decode-ahead worker.
+ */
+
+#include "Player.hpp"
+#include "Trajectory.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    /// Read a POD from the mapping (blocks are not aligned)
+    template <typename T>
+    T readAt(const unsigned char* p) {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        return v;
+    }
+}
+
+Player::~Player() {
+    close();
+}
+
+bool Player::open(const char* path) {
+    close();
+    if (!file_.open(path)) {
+        std::fprintf(stderr, "Could not open trajectory %s\n", path);
+        return false;
+    }
+    if (!buildIndex()) {
+        file_.close();
+        return false;
+    }
+    std::fill(slotFrame_, slotFrame_ + SLOTS, NONE);
+    shown_ = -1;
+    target_ = 0;
+    targetHint_.store(0, std::memory_order_relaxed);
+    cursor_ = NONE;
+    cursorKey_ = NONE;
+    decodable_ = frames_.size();
+    stop_ = false;
+    worker_ = std::thread(&Player::workerLoop, this);
+    return true;
+}
+
+void Player::close() {
+    if (worker_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+    frames_.clear();
+    file_.close();
+}
+
+bool Player::buildIndex() {
+    const unsigned char* data = file_.data();
+    const size_t size = file_.size();
+    if (size < sizeof(TrajectoryHeader)) {
+        std::fprintf(stderr, "Trajectory is truncated\n");
+        return false;
+    }
+    const TrajectoryHeader header = readAt<TrajectoryHeader>(data);
+    if (std::memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic)) != 0
+        || header.version != TRAJECTORY_VERSION || header.byteOrder != 0x01020304u) {
+        std::fprintf(stderr, "Not a version %u trajectory file\n", TRAJECTORY_VERSION);
+        return false;
+    }
+
+    // Blocks end where the index starts; without a valid footer (recording
+    // was cut off) scan until the first block that does not fit
+    size_t end = size;
+    if (size >= sizeof(TrajectoryHeader) + sizeof(TrajectoryFooter)) {
+        const TrajectoryFooter footer = readAt<TrajectoryFooter>(data + size - sizeof(TrajectoryFooter));
+        if (std::memcmp(footer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(footer.magic)) == 0
+            && footer.indexOffset <= size)
+            end = (size_t)footer.indexOffset;
+    }
+
+    // One pass over block headers only; payloads are not touched
+    frames_.clear();
+    size_t offset = sizeof(TrajectoryHeader);
+    size_t keyframe = NONE;
+    double time = 0.0;
+    while (offset + sizeof(TrajectoryBlock) <= end) {
+        const TrajectoryBlock block = readAt<TrajectoryBlock>(data + offset);
+        if (block.tag != TRAJECTORY_BLOCK_TAG || block.payloadBytes > end - offset - sizeof(TrajectoryBlock))
+            break;
+        if (block.flags & TRAJECTORY_KEYFRAME)
+            keyframe = frames_.size();
+        if (keyframe != NONE) {  // Blocks before the first keyframe cannot be decoded
+            if (!frames_.empty()) time += block.dt;
+            frames_.push_back(FrameInfo{ offset, keyframe, time });
+        }
+        offset += sizeof(TrajectoryBlock) + block.payloadBytes;
+    }
+    if (frames_.empty()) {
+        std::fprintf(stderr, "Trajectory has no decodable frames\n");
+        return false;
+    }
+    return true;
+}
+
+size_t Player::frameAtTime(double t) const {
+    auto it = std::upper_bound(frames_.begin(), frames_.end(), t,
+                               [](double v, const FrameInfo& f) { return v < f.time; });
+    return it == frames_.begin() ? 0 : (size_t)(it - frames_.begin()) - 1;
+}
+
+void Player::request(size_t frame) {
+    frame = std::min(frame, frames_.size() - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (frame == target_) return;
+        target_ = frame;
+        targetHint_.store(frame, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+}
+
+const PlaybackFrame* Player::current() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t s = 0; s < SLOTS; ++s) {
+        if (slotFrame_[s] == target_) {
+            shown_ = (int)s;
+            break;
+        }
+    }
+    return shown_ >= 0 ? &slots_[shown_] : nullptr;
+}
+
+size_t Player::nextFrameToDecode() const {
+    // Window the reader may ask for next: the playhead and SLOTS - 2 frames after it
+    const size_t last = std::min(decodable_, target_ + SLOTS - 1);
+    for (size_t f = target_; f < last; ++f) {
+        bool have = false;
+        for (size_t s = 0; s < SLOTS && !have; ++s)
+            have = slotFrame_[s] == f;
+        if (!have) return f;
+    }
+    return NONE;
+}
+
+void Player::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        size_t f;
+        wake_.wait(lock, [&] { return stop_ || (f = nextFrameToDecode()) != NONE; });
+        if (stop_) return;
+
+        // Free slot: not held by the reader and not in the look-ahead window
+        int slot = -1;
+        for (size_t s = 0; s < SLOTS && slot < 0; ++s) {
+            const size_t sf = slotFrame_[s];
+            if ((int)s != shown_ && sf != BUSY && (sf == NONE || sf < target_ || sf >= target_ + SLOTS - 1))
+                slot = (int)s;
+        }
+        if (slot < 0) {
+            wake_.wait(lock);  // Ring full of wanted frames: wait for the playhead to move
+            continue;
+        }
+        slotFrame_[slot] = BUSY;
+        lock.unlock();
+
+        // Catch up from the cursor if it is on the way, else restart at the keyframe
+        const size_t key = frames_[f].keyframe;
+        size_t g = (cursor_ != NONE && cursor_ <= f && cursor_ >= key) ? cursor_ + 1 : key;
+        bool ok = true;
+        for (; g <= f; ++g) {
+            const size_t hint = targetHint_.load(std::memory_order_relaxed);
+            if (f < hint || f >= hint + SLOTS - 1) break;  // Playhead moved away: f is no longer wanted
+            if (!(ok = decodeBlock(g))) break;
+        }
+        const bool done = ok && cursor_ == f;
+        if (done) publishInto(slots_[slot], f);
+
+        lock.lock();
+        slotFrame_[slot] = done ? f : NONE;
+        if (!ok) {
+            decodable_ = g;  // Corrupt block: treat the recording as ending just before it
+            cursor_ = NONE;
+        }
+    }
+}
+
+bool Player::decodeBlock(size_t f) {
+    const unsigned char* base = file_.data() + frames_[f].offset;
+    const TrajectoryBlock block = readAt<TrajectoryBlock>(base);
+    const uint8_t* in = base + sizeof(TrajectoryBlock);
+    const uint8_t* end = in + block.payloadBytes;
+    const size_t n = block.particleCount;
+    const bool key = (block.flags & TRAJECTORY_KEYFRAME) != 0;
+
+    if (key) {
+        qx_.assign(n, 0);
+        qy_.assign(n, 0);
+    } else if (cursor_ + 1 != f || qx_.size() != n) {
+        std::fprintf(stderr, "Trajectory delta block %zu out of sequence\n", f);
+        return false;
+    }
+    in = decodeDeltas(in, end, n, qx_.data());
+    if (in) in = decodeDeltas(in, end, n, qy_.data());
+    if (!in) {
+        std::fprintf(stderr, "Trajectory block %zu is corrupt\n", f);
+        return false;
+    }
+
+    if (key) {
+        const size_t fixed = n * (sizeof(float) + sizeof(uint32_t)) + sizeof(uint32_t);
+        if ((size_t)(end - in) < fixed) {
+            std::fprintf(stderr, "Trajectory keyframe %zu is truncated\n", f);
+            return false;
+        }
+        radius_.resize(n);
+        std::memcpy(radius_.data(), in, n * sizeof(float));
+        in += n * sizeof(float);
+        color_.resize(n);
+        for (size_t i = 0; i < n; ++i, in += sizeof(uint32_t))
+            color_[i] = unpackColor(readAt<uint32_t>(in));
+        const uint32_t wellCount = readAt<uint32_t>(in);
+        in += sizeof(uint32_t);
+        if ((size_t)(end - in) < (size_t)wellCount * 4 * sizeof(float)) {
+            std::fprintf(stderr, "Trajectory keyframe %zu is truncated\n", f);
+            return false;
+        }
+        wells_.clear();
+        for (uint32_t w = 0; w < wellCount; ++w, in += 4 * sizeof(float)) {
+            float v[4];
+            std::memcpy(v, in, sizeof(v));
+            wells_.emplace_back(Vec2(v[0], v[1]), v[2], v[3]);
+        }
+        cursorKey_ = f;
+    }
+    cursorW_ = block.worldW;
+    cursorH_ = block.worldH;
+    cursor_ = f;
+    return true;
+}
+
+void Player::publishInto(PlaybackFrame& slot, size_t f) {
+    const size_t n = qx_.size();
+    slot.frame = f;
+    slot.step = readAt<TrajectoryBlock>(file_.data() + frames_[f].offset).step;
+    slot.x.resize(n);
+    slot.y.resize(n);
+    dequantizePositions(qx_.data(), n, cursorW_, slot.x.data());
+    dequantizePositions(qy_.data(), n, cursorH_, slot.y.data());
+    if (slot.keyframe != cursorKey_) {  // Constant between keyframes: copy once per slot
+        slot.radius = radius_;
+        slot.color = color_;
+        slot.wells = wells_;
+        slot.keyframe = cursorKey_;
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * @file Player.hpp
+ * @brief Seekable playback of a trajectory file written by Recorder.
+ *
+ * open() maps the file and scans the block headers once, so every frame's
+ * file offset and governing keyframe are known: seeking is a table lookup
+ * plus decoding at most one keyframe interval. A worker thread decodes
+ * ahead of the playhead into a small ring of frames; the render thread
+ * only picks up finished frames and never waits for decoding.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "GravityWell.hpp"
+#include "MappedFile.hpp"
+#include "ParticleStore.hpp"
+
+/**
+ * @struct PlaybackFrame
+ * @brief One decoded step, ready to draw.
+ */
+struct PlaybackFrame {
+    size_t frame = 0;                 ///< Index in the file
+    uint64_t step = 0;                ///< Simulation step it was recorded at
+    std::vector<float> x, y;
+    std::vector<float> radius;
+    std::vector<Color> color;
+    std::vector<GravityWell> wells;
+    size_t keyframe = (size_t)-1;     ///< Keyframe radius/color/wells were taken from
+
+    ParticleView view() const {
+        ParticleView v;
+        v.x = x;
+        v.y = y;
+        v.radius = radius;
+        v.color = color;
+        return v;
+    }
+};
+
+/**
+ * @class Player
+ * @brief Trajectory reader with O(1) keyframe lookup and a decode-ahead worker.
+ */
+class Player {
+public:
+    static constexpr size_t NONE = (size_t)-1;
+    static constexpr size_t SLOTS = 8;  ///< Decoded frames kept (one is held by the reader)
+
+    Player() = default;
+    ~Player();
+
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+
+    /** @brief Map path, index its blocks and start the decode worker. */
+    bool open(const char* path);
+    void close();
+
+    size_t frameCount() const { return frames_.size(); }
+    /** @brief Seconds of simulated time from the start of the recording to frame f. */
+    double timeOf(size_t f) const { return frames_[f].time; }
+    /** @brief Last frame whose time is <= t (clamped to the recording). */
+    size_t frameAtTime(double t) const;
+    /** @brief Keyframe at or before f (decodes without any catch-up). */
+    size_t keyframeOf(size_t f) const { return frames_[f].keyframe; }
+
+    /** @brief Move the playhead; decoding restarts from here if needed. */
+    void request(size_t frame);
+    /**
+     * @brief Frame at the playhead if decoded, otherwise the last one returned.
+     * @return nullptr until the first frame is ready; valid until the next call
+     */
+    const PlaybackFrame* current();
+
+private:
+    /** Per-frame table built by open() */
+    struct FrameInfo {
+        size_t offset;    ///< File offset of the TrajectoryBlock
+        size_t keyframe;  ///< Frame index of the governing keyframe
+        double time;      ///< Simulated seconds since the first frame
+    };
+
+    static constexpr size_t BUSY = NONE - 1;  ///< Slot being filled by the worker
+
+    bool buildIndex();
+    void workerLoop();
+    size_t nextFrameToDecode() const;  ///< Requires mutex_
+    bool decodeBlock(size_t f);        ///< Advance the worker's cursor to frame f
+    void publishInto(PlaybackFrame& slot, size_t f);
+
+    MappedFile file_;
+    std::vector<FrameInfo> frames_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;                   ///< Guarded by mutex_
+    size_t target_ = 0;                   ///< Playhead, guarded by mutex_
+    size_t decodable_ = 0;                ///< Frames before the first corrupt block, guarded by mutex_
+    std::atomic<size_t> targetHint_{0};   ///< Lock-free copy so long catch-ups can bail out
+    PlaybackFrame slots_[SLOTS];
+    size_t slotFrame_[SLOTS];             ///< Frame in each slot, NONE or BUSY (guarded by mutex_)
+    int shown_ = -1;                      ///< Slot held by the reader
+
+    // Worker-owned decode cursor
+    size_t cursor_ = NONE;                ///< Last frame decoded into the state below
+    size_t cursorKey_ = NONE;
+    float cursorW_ = 0.0f, cursorH_ = 0.0f;
+    std::vector<uint16_t> qx_, qy_;
+    std::vector<float> radius_;
+    std::vector<Color> color_;
+    std::vector<GravityWell> wells_;
+};
@@ -0,0 +1,122 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementation of the event ring, frame history and trace export.
+ */
+
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /// All timestamps are relative to this so they fit comfortably in a trace
+    const Clock::time_point EPOCH = Clock::now();
+
+    std::atomic<uint32_t> nextThreadId{ 0 };
+
+    /// Write name as a JSON string body (names are literals, but stay safe)
+    void writeEscaped(std::FILE* f, const char* s) {
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', f);
+            if ((unsigned char)*s >= 0x20) std::fputc(*s, f);
+        }
+    }
+}
+
+std::atomic<bool> Profiler::enabled_{ false };
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : events_(EVENT_CAPACITY), frames_(FRAME_HISTORY) {
+    frameStartNs_ = now();
+}
+
+uint64_t Profiler::now() {
+    // +1 so a valid timestamp is never 0 (ProfileScope uses 0 for "not timing")
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - EPOCH).count() + 1;
+}
+
+uint32_t Profiler::threadId() {
+    thread_local uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t durationNs, uint32_t thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProfileEvent& e = events_[eventCount_ % EVENT_CAPACITY];
+    e.name = name;
+    e.startNs = startNs;
+    e.durationNs = durationNs;
+    e.thread = thread;
+    ++eventCount_;
+}
+
+void Profiler::recordGpu(const char* name, uint64_t frame, uint64_t startNs, uint64_t durationNs) {
+    record(name, startNs, durationNs, GPU_THREAD);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frame + FRAME_HISTORY > frame_ && frame <= frame_)  // Still in the history window
+        frames_[frame % FRAME_HISTORY].gpuMs += (float)((double)durationNs * 1.0e-6);
+}
+
+void Profiler::endFrame() {
+    const uint64_t t = now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameTiming& f = frames_[frame_ % FRAME_HISTORY];
+    f.cpuMs = (float)((double)(t - frameStartNs_) * 1.0e-6);
+    frameStartNs_ = t;
+    ++frame_;
+    frames_[frame_ % FRAME_HISTORY] = FrameTiming();  // Recycle the oldest slot for the new frame
+}
+
+uint64_t Profiler::frameIndex() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_;
+}
+
+void Profiler::frames(std::vector<FrameTiming>& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Completed frames only: frame_ itself is still being accumulated
+    const size_t count = (size_t)std::min<uint64_t>(frame_, FRAME_HISTORY - 1);
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = frames_[(frame_ - count + i) % FRAME_HISTORY];
+}
+
+bool Profiler::writeChromeTrace(const char* path) const {
+    std::FILE* f = std::fopen(path, "w");
+    if (!f) {
+        std::fprintf(stderr, "Could not write trace %s\n", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t count = std::min<uint64_t>(eventCount_, EVENT_CAPACITY);
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}",
+                 GPU_THREAD);
+    for (uint64_t k = eventCount_ - count; k < eventCount_; ++k) {
+        const ProfileEvent& e = events_[k % EVENT_CAPACITY];
+        std::fprintf(f, ",\n{\"name\":\"");
+        writeEscaped(f, e.name);
+        std::fprintf(f, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     e.thread == GPU_THREAD ? "gpu" : "cpu", e.thread,
+                     (double)e.startNs * 1.0e-3, (double)e.durationNs * 1.0e-3);
+    }
+    std::fprintf(f, "\n]}\n");
+    const bool ok = std::ferror(f) == 0;
+    std::fclose(f);
+    return ok;
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    eventCount_ = 0;
+    std::fill(frames_.begin(), frames_.end(), FrameTiming());
+    frame_ = 0;
+    frameStartNs_ = now();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file Profiler.hpp
+ * @brief Scoped CPU timers, GPU timings and a frame-time history.
+ *
+ * Timed regions are recorded as complete events (name, start, duration,
+ * thread) in a fixed-size ring and can be written out in Chrome trace JSON
+ * (chrome://tracing, Perfetto). While disabled a scope costs one relaxed
+ * atomic load; build with -DORB_PROFILING=0 to compile the scopes out.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifndef ORB_PROFILING
+#define ORB_PROFILING 1
+#endif
+
+/** One timed region. name must be a string literal (only the pointer is kept). */
+struct ProfileEvent {
+    const char* name = nullptr;
+    uint64_t startNs = 0;    ///< Start, ns since the profiler epoch
+    uint64_t durationNs = 0;
+    uint32_t thread = 0;     ///< Small per-thread id (GPU_THREAD for GPU passes)
+};
+
+/** Totals for one rendered frame, for the overlay graph. */
+struct FrameTiming {
+    float cpuMs = 0.0f;  ///< Wall time from the previous endFrame()
+    float gpuMs = 0.0f;  ///< Sum of the frame's GPU passes (filled in a few frames late)
+};
+
+/**
+ * @class Profiler
+ * @brief Process-wide event recorder shared by the UI and simulation threads.
+ */
+class Profiler {
+public:
+    static constexpr size_t EVENT_CAPACITY = 1 << 16;  ///< Events kept before the oldest are overwritten
+    static constexpr size_t FRAME_HISTORY = 240;       ///< Frames kept for the overlay
+    static constexpr uint32_t GPU_THREAD = 1000;       ///< Pseudo thread id for GPU passes
+
+    static Profiler& instance();
+
+    /// Cheap check used by ProfileScope before touching the clock
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+    /// Nanoseconds since the profiler epoch (steady clock)
+    static uint64_t now();
+    /// Small stable id for the calling thread (main thread is whichever asks first)
+    static uint32_t threadId();
+
+    /** @brief Record a finished CPU or GPU region. */
+    void record(const char* name, uint64_t startNs, uint64_t durationNs, uint32_t thread);
+    /**
+     * @brief Record a GPU pass and add it to the given frame's GPU total.
+     * @param frame Value of frameIndex() when the pass was issued
+     */
+    void recordGpu(const char* name, uint64_t frame, uint64_t startNs, uint64_t durationNs);
+
+    /** @brief Close the current frame: store its CPU time and advance frameIndex(). */
+    void endFrame();
+    uint64_t frameIndex() const;
+    /** @brief Copy the frame history into out, oldest first. */
+    void frames(std::vector<FrameTiming>& out) const;
+
+    /**
+     * @brief Write every buffered event as Chrome trace JSON.
+     * @return false if the file could not be written
+     */
+    bool writeChromeTrace(const char* path) const;
+    void reset();
+
+private:
+    Profiler();
+
+    static std::atomic<bool> enabled_;
+
+    mutable std::mutex mutex_;
+    std::vector<ProfileEvent> events_;   ///< Ring of EVENT_CAPACITY
+    uint64_t eventCount_ = 0;            ///< Total recorded; head = eventCount_ % capacity
+    std::vector<FrameTiming> frames_;    ///< Ring of FRAME_HISTORY
+    uint64_t frame_ = 0;
+    uint64_t frameStartNs_ = 0;
+};
+
+/**
+ * @struct ProfileScope
+ * @brief RAII timer: records [construction, destruction) when profiling is on.
+ */
+struct ProfileScope {
+    const char* name;
+    uint64_t startNs;
+
+    explicit ProfileScope(const char* n) : name(n), startNs(Profiler::enabled() ? Profiler::now() : 0) {}
+    ~ProfileScope() {
+        if (startNs != 0)
+            Profiler::instance().record(name, startNs, Profiler::now() - startNs, Profiler::threadId());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define ORB_PROFILE_CONCAT2(a, b) a##b
+#define ORB_PROFILE_CONCAT(a, b) ORB_PROFILE_CONCAT2(a, b)
+#if ORB_PROFILING
+/// Time the rest of the enclosing block under name (a string literal)
+#define ORB_PROFILE_SCOPE(name) ProfileScope ORB_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define ORB_PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file Random.hpp
+ * @brief Small, seedable pseudo-random generator (no global state).
+ *
+ * std::rand is shared process-wide and its sequence differs between C
+ * libraries. This generator gives the same stream everywhere for the same
+ * seed, which scene generators and replays depend on. counterRandom() is
+ * the stateless form for batch loops: value k depends only on (key, k), so
+ * iterations carry no dependency and the compiler is free to vectorize.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @struct Random
+ * @brief xorshift64* generator seeded through SplitMix64.
+ */
+struct Random {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    Random() = default;
+    explicit Random(uint64_t seed) { reseed(seed); }
+
+    /// Restart the stream; any seed (including 0) is valid
+    void reseed(uint64_t seed) {
+        // SplitMix64 scramble so nearby seeds give unrelated streams
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state = (z ^ (z >> 31)) | 1ull;
+    }
+
+    /// Next 64 random bits
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    /// Uniform float in [0, 1)
+    float uniform() { return (float)(next() >> 40) * (1.0f / 16777216.0f); }
+    /// Uniform float in [lo, hi)
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+};
+
+/// 64 random bits for (key, counter): SplitMix64's finalizer over a Weyl sequence
+inline uint64_t counterRandom(uint64_t key, uint64_t counter) {
+    uint64_t z = key + counter * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// Uniform float in [0, 1) for (key, counter)
+inline float counterUniform(uint64_t key, uint64_t counter) {
+    return (float)(counterRandom(key, counter) >> 40) * (1.0f / 16777216.0f);
+}
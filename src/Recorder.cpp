@@ -0,0 +1,195 @@
+/**
+ * @file Recorder.cpp
+ * @brief Implementation of the SPSC ring and the trajectory writer thread.
+ */
+
+#include "Recorder.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace {
+    /// Writer nap while the ring is empty (also bounds a missed wake-up)
+    const auto WRITER_IDLE = std::chrono::milliseconds(2);
+    /// stdio buffer: blocks for large scenes are written in a few big chunks
+    const size_t FILE_BUFFER_BYTES = 1 << 20;
+}
+
+Recorder::~Recorder() {
+    close();
+}
+
+bool Recorder::open(const char* path, uint32_t keyframeInterval) {
+    close();
+    file_ = std::fopen(path, "wb");
+    if (!file_) {
+        std::fprintf(stderr, "Could not create trajectory %s\n", path);
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, FILE_BUFFER_BYTES);
+
+    keyframeInterval_ = keyframeInterval > 0 ? keyframeInterval : 1;
+    forceKeyframe_ = true;
+    offset_ = 0;
+    writeFailed_ = false;
+    bytesWritten_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    index_.clear();
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+
+    TrajectoryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = TRAJECTORY_VERSION;
+    header.keyframeInterval = keyframeInterval_;
+    header.byteOrder = 0x01020304u;
+    write(&header, sizeof(header));
+
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread(&Recorder::writerLoop, this);
+    return true;
+}
+
+void Recorder::close() {
+    if (!file_) return;
+    running_.store(false, std::memory_order_release);
+    wake_.notify_one();
+    writer_.join();  // Drains whatever is still queued
+
+    TrajectoryFooter footer;
+    footer.indexOffset = offset_;
+    footer.keyframeCount = index_.size();
+    std::memcpy(footer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(footer.magic));
+    if (!index_.empty())
+        write(index_.data(), index_.size() * sizeof(TrajectoryIndexEntry));
+    write(&footer, sizeof(footer));
+
+    if (std::fclose(file_) != 0) writeFailed_ = true;
+    file_ = nullptr;
+    if (writeFailed_)
+        std::fprintf(stderr, "Trajectory write failed; the file is incomplete\n");
+    if (dropped_.load(std::memory_order_relaxed) > 0)
+        std::fprintf(stderr, "Trajectory recorder dropped %llu steps (writer fell behind)\n",
+                     (unsigned long long)dropped_.load(std::memory_order_relaxed));
+}
+
+bool Recorder::push(const Simulation& sim, uint64_t step, float dt) {
+    if (!file_) return false;
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= RING_SIZE) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        forceKeyframe_ = true;  // The next block cannot delta against a frame the writer never saw
+        return false;
+    }
+
+    const ParticleStore& ps = sim.particles;
+    const bool keyframe = forceKeyframe_ || step - lastKeyStep_ >= keyframeInterval_
+        || ps.size() != lastCount_ || ps.layoutVersion != lastLayout_ || sim.gravityWells.size() != lastWells_
+        || sim.worldW != lastW_ || sim.worldH != lastH_;
+
+    Frame& f = ring_[head % RING_SIZE];
+    f.step = step;
+    f.dt = dt;
+    f.worldW = sim.worldW;
+    f.worldH = sim.worldH;
+    f.keyframe = keyframe;
+    f.x.assign(ps.x.begin(), ps.x.end());
+    f.y.assign(ps.y.begin(), ps.y.end());
+    if (keyframe) {
+        f.radius.assign(ps.radius.begin(), ps.radius.end());
+        f.color.assign(ps.color.begin(), ps.color.end());
+        f.wells.assign(sim.gravityWells.begin(), sim.gravityWells.end());
+        lastKeyStep_ = step;
+        forceKeyframe_ = false;
+    }
+    lastCount_ = ps.size();
+    lastLayout_ = ps.layoutVersion;
+    lastWells_ = sim.gravityWells.size();
+    lastW_ = sim.worldW;
+    lastH_ = sim.worldH;
+
+    head_.store(head + 1, std::memory_order_release);
+    wake_.notify_one();
+    return true;
+}
+
+void Recorder::writerLoop() {
+    for (;;) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            if (!running_.load(std::memory_order_acquire)) {
+                // Re-check: the producer may have pushed just before stopping
+                if (tail == head_.load(std::memory_order_acquire)) break;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait_for(lock, WRITER_IDLE);
+            continue;
+        }
+        encode(ring_[tail % RING_SIZE]);
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+    std::fflush(file_);
+}
+
+void Recorder::encode(const Frame& frame) {
+    const size_t n = frame.x.size();
+    qx_.resize(n);
+    qy_.resize(n);
+    quantizePositions(frame.x.data(), n, frame.worldW, qx_.data());
+    quantizePositions(frame.y.data(), n, frame.worldH, qy_.data());
+
+    payload_.clear();
+    const bool delta = !frame.keyframe;  // push() keyframes every count or layout change
+    encodeDeltas(qx_.data(), delta ? prevQx_.data() : nullptr, n, payload_);
+    encodeDeltas(qy_.data(), delta ? prevQy_.data() : nullptr, n, payload_);
+    if (!delta) {
+        // Keyframe: everything needed to start decoding here
+        const size_t base = payload_.size();
+        payload_.resize(base + n * (sizeof(float) + sizeof(uint32_t)));
+        std::memcpy(payload_.data() + base, frame.radius.data(), n * sizeof(float));
+        uint8_t* colors = payload_.data() + base + n * sizeof(float);
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t rgba = packColor(frame.color[i]);
+            std::memcpy(colors + i * sizeof(uint32_t), &rgba, sizeof(rgba));
+        }
+        const uint32_t wellCount = (uint32_t)frame.wells.size();
+        const size_t wellBase = payload_.size();
+        payload_.resize(wellBase + sizeof(uint32_t) + wellCount * 4 * sizeof(float));
+        std::memcpy(payload_.data() + wellBase, &wellCount, sizeof(wellCount));
+        for (uint32_t w = 0; w < wellCount; ++w) {
+            const GravityWell& g = frame.wells[w];
+            const float v[4] = { g.pos.x, g.pos.y, g.strength, g.minRadius };
+            std::memcpy(payload_.data() + wellBase + sizeof(uint32_t) + w * sizeof(v), v, sizeof(v));
+        }
+        index_.push_back(TrajectoryIndexEntry{ frame.step, offset_ });
+    }
+
+    TrajectoryBlock block;
+    block.tag = TRAJECTORY_BLOCK_TAG;
+    block.flags = delta ? 0u : TRAJECTORY_KEYFRAME;
+    block.step = frame.step;
+    block.particleCount = (uint32_t)n;
+    block.payloadBytes = (uint32_t)payload_.size();
+    block.worldW = frame.worldW;
+    block.worldH = frame.worldH;
+    block.dt = frame.dt;
+    block.reserved = 0;
+    write(&block, sizeof(block));
+    write(payload_.data(), payload_.size());
+
+    qx_.swap(prevQx_);
+    qy_.swap(prevQy_);
+}
+
+bool Recorder::write(const void* data, size_t bytes) {
+    if (bytes == 0 || writeFailed_) return !writeFailed_;
+    if (std::fwrite(data, 1, bytes, file_) != bytes) {
+        writeFailed_ = true;
+        return false;
+    }
+    offset_ += bytes;
+    bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Recorder.hpp
+ * @brief Streams per-step particle positions to a trajectory file (see Trajectory.hpp).
+ *
+ * The stepping thread calls push() once per step. push() copies the
+ * columns into a slot of a fixed single-producer / single-consumer ring
+ * and returns; quantizing, delta coding and file I/O happen on the
+ * recorder's own writer thread. If the writer falls behind and the ring is
+ * full the step is dropped (counted in droppedFrames()) and the next pushed
+ * step becomes a keyframe, so the file stays decodable.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Math.hpp"
+#include "GravityWell.hpp"
+#include "Trajectory.hpp"
+
+struct Simulation;
+
+/**
+ * @class Recorder
+ * @brief Background trajectory writer fed through a lock-free SPSC ring.
+ */
+class Recorder {
+public:
+    static constexpr size_t RING_SIZE = 16;  ///< Steps buffered between producer and writer
+
+    Recorder() = default;
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    /**
+     * @brief Create path, write the header and start the writer thread.
+     * @param keyframeInterval Steps between scheduled keyframes
+     * @return false if the file could not be created
+     */
+    bool open(const char* path, uint32_t keyframeInterval = 60);
+    /** @brief Drain the ring, write the keyframe index and close the file. */
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Producer: queue the state after one step. Never blocks.
+     * @param step Step number recorded in the block
+     * @param dt Seconds simulated by the step
+     * @return false if the ring was full and the step was dropped
+     */
+    bool push(const Simulation& sim, uint64_t step, float dt);
+
+    uint64_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+
+private:
+    /** One queued step; vectors keep their capacity so steady state does not allocate */
+    struct Frame {
+        uint64_t step = 0;
+        float dt = 0.0f;
+        float worldW = 0.0f;
+        float worldH = 0.0f;
+        bool keyframe = false;
+        std::vector<float> x, y;
+        std::vector<float> radius;  ///< Keyframes only
+        std::vector<Color> color;   ///< Keyframes only
+        std::vector<GravityWell> wells;  ///< Keyframes only
+    };
+
+    void writerLoop();
+    void encode(const Frame& frame);
+    bool write(const void* data, size_t bytes);
+
+    Frame ring_[RING_SIZE];
+    std::atomic<size_t> head_{0};  ///< Next slot the producer fills (producer-owned)
+    std::atomic<size_t> tail_{0};  ///< Next slot the writer encodes (writer-owned)
+    std::atomic<bool> running_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_; ///< Writer naps here when the ring is empty
+    std::thread writer_;
+
+    // Producer-side keyframe decisions
+    uint32_t keyframeInterval_ = 60;
+    uint64_t lastKeyStep_ = 0;
+    size_t lastCount_ = 0;
+    uint32_t lastLayout_ = 0;
+    size_t lastWells_ = 0;
+    float lastW_ = 0.0f, lastH_ = 0.0f;
+    bool forceKeyframe_ = true;
+    std::atomic<uint64_t> dropped_{0};
+
+    // Writer-side state
+    std::FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    bool writeFailed_ = false;
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::vector<uint16_t> qx_, qy_;          ///< Current quantized frame
+    std::vector<uint16_t> prevQx_, prevQy_;  ///< Previous quantized frame (delta base)
+    std::vector<uint8_t> payload_;
+    std::vector<TrajectoryIndexEntry> index_;
+};
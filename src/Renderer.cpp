@@ -4,8 +4,10 @@
  */
 
 #include "Renderer.hpp"
+#include "GpuSimulation.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_video.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -14,6 +16,7 @@
 #define GL_SILENCE_DEPRECATION 1  // Silence macOS OpenGL deprecation warnings
 #include <OpenGL/gl3.h>
 #else
+#define GL_GLEXT_PROTOTYPES 1  // Declare GL 3.x entry points (exported by libGL on Linux)
 #include <GL/gl.h>
 #endif
 
@@ -49,6 +52,180 @@ void main() {
 }
 )";
 
+/** Glow radius as a multiple of the particle radius */
+const float GLOW_SCALE = 3.5f;
+/** On-screen core radius (px) below which the glow starts to shrink, and where it is gone */
+const float GLOW_FULL_PX = 4.0f;
+const float GLOW_NONE_PX = 1.5f;
+/** Smallest core drawn (px); smaller particles are grown to this and dimmed by the area ratio */
+const float MIN_CORE_PX = 0.75f;
+/** Floats per particle instance: x, y, radius, r, g, b */
+const int INSTANCE_FLOATS = 6;
+
+/**
+ * Instanced particle vertex shader.
+ * Expands a unit quad around each instance to cover the glow, and passes
+ * the fragment's offset from the centre in units of the particle radius.
+ * The glow is scaled down with the on-screen radius (a 1 px particle gets
+ * a bare core on a 2 px quad instead of a 7 px halo), and sub-pixel cores
+ * are held at MIN_CORE_PX with their brightness reduced to match.
+ */
+const char* PARTICLE_VERT_SRC = R"(
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec2 aCenter;
+layout(location = 2) in float aRadius;
+layout(location = 3) in vec3 aColor;
+out vec2 vLocal;
+out vec3 vColor;
+flat out float vGlow;       // Glow extent in core radii (1 = no glow)
+flat out float vGlowAlpha;
+flat out float vDim;
+uniform mat4 uProj;
+uniform float uGlowScale;
+uniform vec2 uGlowPx;       // (none, full)
+uniform float uMinCorePx;
+uniform float uPixelScale;  // Pixels per world unit
+void main() {
+    float px = aRadius * uPixelScale;
+    float shown = max(px, uMinCorePx);
+    float lod = smoothstep(uGlowPx.x, uGlowPx.y, px);
+    vGlow = mix(1.0, uGlowScale, lod);
+    vGlowAlpha = 0.4 * lod;
+    vDim = (px * px) / (shown * shown);
+    vLocal = aCorner * vGlow;
+    vColor = aColor;
+    gl_Position = uProj * vec4(aCenter + vLocal * (shown / uPixelScale), 0.0, 1.0);
+}
+)";
+
+/**
+ * Instanced particle fragment shader (signed-distance circle).
+ * Sums the radial glow and the bright core in one pass; with additive
+ * blending this matches drawing the two as separate layers.
+ */
+const char* PARTICLE_FRAG_SRC = R"(
+#version 330 core
+in vec2 vLocal;
+in vec3 vColor;
+flat in float vGlow;
+flat in float vGlowAlpha;
+flat in float vDim;
+out vec4 fragColor;
+void main() {
+    float d = length(vLocal);
+    if (d > vGlow) discard;
+    float glowA = vGlowAlpha * (1.0 - d / vGlow);
+    float aa = fwidth(d);
+    float coreCover = 1.0 - smoothstep(1.0 - aa, 1.0 + aa, d);
+    float coreA = mix(1.0, 0.9, clamp(d, 0.0, 1.0)) * coreCover;
+    vec3 core = min(vec3(1.0), vColor * 1.5);
+    fragColor = vec4((vColor * glowA + core * coreA) * vDim, 1.0);
+}
+)";
+
+/** Floats per trail segment instance: a.xy, b.xy, segment index, trail length, r, g, b */
+const int SEGMENT_FLOATS = 9;
+/** Trail points closer than this (px) to the last kept point are skipped */
+const float TRAIL_SPACING_PX = 2.0f;
+/** Widest trail half-width in world units (see TRAIL_VERT_SRC), for culling */
+const float TRAIL_MAX_WIDTH = 8.0f;
+
+/** Gravity well glow layers, outermost first: radius, centre RGBA, rim RGBA */
+struct WellLayer { float radius; float centre[4]; float rim[4]; };
+const WellLayer WELL_LAYERS[] = {
+    { 60.0f, { 0.2f, 0.4f, 1.0f, 0.15f }, { 0.2f, 0.4f, 1.0f, 0.0f } },  // Outer glow
+    { 35.0f, { 0.3f, 0.5f, 1.0f, 0.4f },  { 0.3f, 0.5f, 1.0f, 0.0f } },  // Middle glow
+    { 18.0f, { 0.4f, 0.7f, 1.0f, 1.0f },  { 0.4f, 0.7f, 1.0f, 0.8f } },  // Bright core
+};
+/** Segments per well disc: one per WELL_PX_PER_SEGMENT px of outer radius, within these bounds */
+const int WELL_MIN_SEGMENTS = 8;
+const int WELL_MAX_SEGMENTS = 32;
+const float WELL_PX_PER_SEGMENT = 4.0f;
+
+/**
+ * Instanced trail-segment vertex shader.
+ * Each instance is one segment; gl_VertexID picks the strip corner. Width,
+ * brightness and alpha fall off with the segment's position in its trail,
+ * so the CPU only has to copy raw trail points.
+ */
+const char* TRAIL_VERT_SRC = R"(
+#version 330 core
+layout(location = 0) in vec4 aSegment;   // a.xy, b.xy
+layout(location = 1) in vec2 aIndex;     // segment index, trail length
+layout(location = 2) in vec3 aColor;
+out vec4 vColor;
+uniform mat4 uProj;
+void main() {
+    vec2 a = aSegment.xy;
+    vec2 b = aSegment.zw;
+    vec2 dir = b - a;
+    float len = length(dir);
+    float t = aIndex.x / aIndex.y;
+    float width = 3.0 + t * 5.0;
+    int corner = gl_VertexID;               // strip order: a+, a-, b+, b-
+    bool atB = corner >= 2;
+    float side = (corner == 0 || corner == 2) ? 1.0 : -1.0;
+    vec2 perp = len < 0.1 ? vec2(0.0) : vec2(-dir.y, dir.x) * (width / len);
+    vec2 p = (atB ? b : a) + perp * side;
+    float fade = t * 0.7 * (atB ? 0.5 : 1.0);
+    vColor = vec4(aColor * (0.5 + 0.5 * t), len < 0.1 ? 0.0 : fade);
+    gl_Position = uProj * vec4(p, 0.0, 1.0);
+}
+)";
+
+/** Names of the GPU passes in the trace, indexed by Renderer::GpuPass */
+const char* const GPU_PASS_NAMES[] = { "gpu.trails", "gpu.wells", "gpu.particles" };
+
+/** Profiler graph layout: pixels per frame bar, pixels per millisecond */
+const float OVERLAY_BAR_WIDTH = 2.0f;
+const float OVERLAY_PX_PER_MS = 4.0f;
+const float OVERLAY_MARGIN = 10.0f;
+
+/**
+ * @brief Column-major orthographic projection for a y-down view.
+ * @param out 16 floats
+ * @param width, height Viewport size in pixels
+ * @param origin World point at the top-left corner
+ * @param scale Pixels per world unit
+ */
+void orthoProjection(float* out, int width, int height, Vec2 origin, float scale) {
+    const float sx = 2.0f * scale / (float)width;
+    const float sy = -2.0f * scale / (float)height;
+    const float m[16] = {
+        sx, 0, 0, 0,
+        0, sy, 0, 0,
+        0, 0, -1, 0,
+        -1.0f - sx * origin.x, 1.0f - sy * origin.y, 0, 1
+    };
+    std::copy(m, m + 16, out);
+}
+
+/** Initial size of each StreamBuffer frame region (grows on demand) */
+const size_t STREAM_FRAME_BYTES = 4u << 20;
+
+/** @brief Point particle instance attributes 1-3 at instances starting at offset in the bound buffer. */
+void pointParticleInstances(size_t offset) {
+    const GLsizei stride = INSTANCE_FLOATS * sizeof(float);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 2 * sizeof(float)));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 3 * sizeof(float)));
+}
+
+/** @brief Point trail segment attributes 0-2 at segments starting at offset in the bound buffer. */
+void pointTrailSegments(size_t offset) {
+    const GLsizei stride = SEGMENT_FLOATS * sizeof(float);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 4 * sizeof(float)));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + 6 * sizeof(float)));
+}
+
+/** @brief Point program_ vertex attributes (pos.xy, rgba) at vertices starting at offset in the bound buffer. */
+void pointColorVertices(size_t offset) {
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 2 * sizeof(float)));
+}
+
 /**
  * @brief Compile a GLSL shader from source code.
  * @param type Shader type (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)
@@ -73,11 +250,13 @@ unsigned int compileShader(unsigned int type, const char* src) {
 
 /**
  * @brief Create and link a complete shader program from vertex and fragment shaders.
+ * @param vertSrc Vertex shader source
+ * @param fragSrc Fragment shader source
  * @return Program ID on success, 0 on failure (prints error to stderr)
  */
-unsigned int createProgram() {
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, VERT_SRC);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, FRAG_SRC);
+unsigned int createProgram(const char* vertSrc, const char* fragSrc) {
+    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertSrc);
+    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragSrc);
     if (!vs || !fs) return 0;
     unsigned int prog = glCreateProgram();
     glAttachShader(prog, vs);
@@ -101,23 +280,48 @@ unsigned int createProgram() {
 
 Renderer::~Renderer() {
     if (glContext_ && window_) {
+        for (int f = 0; f < GPU_QUERY_FRAMES; ++f)
+            for (int p = 0; p < GpuPassCount; ++p)
+                glDeleteQueries(1, &gpuQueries_[f][p].id);
+        glDeleteVertexArrays(1, &colorVao_);
+        glDeleteVertexArrays(1, &trailVao_);
+        glDeleteProgram(trailProgram_);
+        stream_.release();
+        glDeleteVertexArrays(1, &gpuParticleVao_);
+        glDeleteBuffers(1, &quadVbo_);
+        glDeleteVertexArrays(1, &particleVao_);
+        glDeleteProgram(particleProgram_);
+        glDeleteProgram(program_);
         SDL_GL_MakeCurrent(window_, nullptr);
         SDL_GL_DeleteContext(static_cast<SDL_GLContext>(glContext_));
     }
 }
 
-bool Renderer::init(SDL_Window* window, int width, int height) {
+bool Renderer::init(SDL_Window* window, int width, int height, bool wantCompute) {
     window_ = window;
     width_ = width;
     height_ = height;
 
-    // Request OpenGL 3.2 Core Profile (required on macOS)
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);  // Enable double buffering
 
-    SDL_GLContext ctx = SDL_GL_CreateContext(window_);
+    // GL 4.3 Core for compute shaders when asked (macOS stops at 4.1, so never there)
+    SDL_GLContext ctx = nullptr;
+#if !defined(__APPLE__)
+    if (wantCompute) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        ctx = SDL_GL_CreateContext(window_);
+    }
+#else
+    (void)wantCompute;
+#endif
+    // Otherwise OpenGL 3.3 Core Profile (core profile required on macOS; 3.3 for instanced attributes)
+    if (!ctx) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        ctx = SDL_GL_CreateContext(window_);
+    }
     if (!ctx) {
         std::fprintf(stderr, "SDL_GL_CreateContext failed: %s\n", SDL_GetError());
         return false;
@@ -129,8 +333,29 @@ bool Renderer::init(SDL_Window* window, int width, int height) {
         return false;
     }
 
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    hasCompute_ = major * 10 + minor >= 43;
+
     initShaders();
-    if (!program_) return false;
+    if (!program_ || !particleProgram_ || !trailProgram_) return false;
+    stream_.init(STREAM_FRAME_BYTES);
+    initParticleBuffers();
+    initTrailBuffers();
+
+    // Wells, drag preview and the profiler graph: program_ layout (pos.xy, rgba)
+    glGenVertexArrays(1, &colorVao_);
+    glBindVertexArray(colorVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, stream_.buffer());
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    pointColorVertices(0);
+    glBindVertexArray(0);
+
+    for (int f = 0; f < GPU_QUERY_FRAMES; ++f)
+        for (int p = 0; p < GpuPassCount; ++p)
+            glGenQueries(1, &gpuQueries_[f][p].id);
 
     // Enable alpha blending for glow effect
     glEnable(GL_BLEND);
@@ -140,13 +365,110 @@ bool Renderer::init(SDL_Window* window, int width, int height) {
 }
 
 void Renderer::initShaders() {
-    program_ = createProgram();
+    program_ = createProgram(VERT_SRC, FRAG_SRC);
+    if (program_)
+        programProjLoc_ = glGetUniformLocation(program_, "uProj");
+    particleProgram_ = createProgram(PARTICLE_VERT_SRC, PARTICLE_FRAG_SRC);
+    if (particleProgram_) {
+        particleProjLoc_ = glGetUniformLocation(particleProgram_, "uProj");
+        particlePixelScaleLoc_ = glGetUniformLocation(particleProgram_, "uPixelScale");
+        glUseProgram(particleProgram_);
+        glUniform1f(glGetUniformLocation(particleProgram_, "uGlowScale"), GLOW_SCALE);
+        glUniform2f(glGetUniformLocation(particleProgram_, "uGlowPx"), GLOW_NONE_PX, GLOW_FULL_PX);
+        glUniform1f(glGetUniformLocation(particleProgram_, "uMinCorePx"), MIN_CORE_PX);
+    }
+    trailProgram_ = createProgram(TRAIL_VERT_SRC, FRAG_SRC);
+    if (trailProgram_)
+        trailProjLoc_ = glGetUniformLocation(trailProgram_, "uProj");
+}
+
+void Renderer::initParticleBuffers() {
+    // Persistent unit quad, drawn as a 4-vertex triangle strip per instance
+    const float quad[8] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+    glGenVertexArrays(1, &particleVao_);
+    glGenBuffers(1, &quadVbo_);
+    glBindVertexArray(particleVao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    // Per-instance attributes: centre, radius, color (re-pointed at each frame's stream offset)
+    glBindBuffer(GL_ARRAY_BUFFER, stream_.buffer());
+    for (GLuint loc = 1; loc <= 3; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    pointParticleInstances(0);
+
+    // Same quad; instance attributes are pointed at the GPU simulation's buffers per draw
+    glGenVertexArrays(1, &gpuParticleVao_);
+    glBindVertexArray(gpuParticleVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVbo_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    for (GLuint loc = 1; loc <= 3; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+void Renderer::initTrailBuffers() {
+    // Segment instances only; strip corners come from gl_VertexID
+    glGenVertexArrays(1, &trailVao_);
+    glBindVertexArray(trailVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, stream_.buffer());
+    for (GLuint loc = 0; loc <= 2; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    pointTrailSegments(0);
+    glBindVertexArray(0);
 }
 
 void Renderer::resize(int width, int height) {
     width_ = width;
     height_ = height;
     glViewport(0, 0, width_, height_);
+    orthoProjection(viewProj_, width_, height_, viewOrigin_, viewScale_);
+}
+
+void Renderer::beginFrame() {
+    stream_.nextFrame();
+    gpuFrame_ = Profiler::instance().frameIndex();
+    for (int f = 0; f < GPU_QUERY_FRAMES; ++f) {
+        for (int p = 0; p < GpuPassCount; ++p) {
+            GpuQuery& q = gpuQueries_[f][p];
+            if (!q.pending) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;  // Never stall: try again next frame
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(q.id, GL_QUERY_RESULT, &elapsedNs);
+            q.pending = false;
+            Profiler::instance().recordGpu(GPU_PASS_NAMES[p], q.frame, q.cpuStartNs, (uint64_t)elapsedNs);
+        }
+    }
+}
+
+void Renderer::beginGpuPass(GpuPass pass) {
+    if (!Profiler::enabled()) return;
+    GpuQuery& q = gpuQueries_[gpuFrame_ % GPU_QUERY_FRAMES][pass];
+    if (q.pending) return;  // GPU is more than GPU_QUERY_FRAMES behind; skip this sample
+    q.frame = gpuFrame_;
+    q.cpuStartNs = Profiler::now();
+    glBeginQuery(GL_TIME_ELAPSED, q.id);
+    activeQuery_ = &q;
+}
+
+void Renderer::endGpuPass() {
+    if (!activeQuery_) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    activeQuery_->pending = true;
+    activeQuery_ = nullptr;
 }
 
 void Renderer::clear() {
@@ -154,268 +476,183 @@ void Renderer::clear() {
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
-void Renderer::drawParticles(const std::vector<Particle>& particles) {
-    glUseProgram(program_);
-    for (const Particle& p : particles) {
-        drawCircle(p);
-    }
+void Renderer::setView(Vec2 origin, float scale) {
+    if (origin.x == viewOrigin_.x && origin.y == viewOrigin_.y && scale == viewScale_) return;
+    viewOrigin_ = origin;
+    viewScale_ = scale;
+    orthoProjection(viewProj_, width_, height_, viewOrigin_, viewScale_);
 }
 
-void Renderer::drawParticleTrails(const std::vector<Particle>& particles) {
-    float proj[16] = {
-        2.0f / (float)width_, 0, 0, 0,
-        0, -2.0f / (float)height_, 0, 0,
-        0, 0, -1, 0,
-        -1, 1, 0, 1
-    };
-    glUseProgram(program_);
-    glUniformMatrix4fv(glGetUniformLocation(program_, "uProj"), 1, GL_FALSE, proj);
-    
-    for (const Particle& p : particles) {
-        if (p.trailLength < 2) continue;
-        
-        // Draw trail as connected segments with fading alpha
-        for (int i = 0; i < p.trailLength - 1; ++i) {
-            int idx1 = (p.trailIndex - p.trailLength + i + Particle::MAX_TRAIL_LENGTH) % Particle::MAX_TRAIL_LENGTH;
-            int idx2 = (p.trailIndex - p.trailLength + i + 1 + Particle::MAX_TRAIL_LENGTH) % Particle::MAX_TRAIL_LENGTH;
-            Vec2 a = p.trail[idx1];
-            Vec2 b = p.trail[idx2];
-            
-            float alpha = (float)i / (float)p.trailLength;
-            float trailWidth = 3.0f + alpha * 5.0f;  // Thicker trails
-            float r = p.color.r * (0.5f + 0.5f * alpha);
-            float g = p.color.g * (0.5f + 0.5f * alpha);
-            float bl = p.color.b * (0.5f + 0.5f * alpha);
-            
-            // Draw segment as a quad (two triangles)
-            Vec2 dir = b - a;
-            float len = dir.length();
-            if (len < 0.1f) continue;
-            Vec2 perp = Vec2(-dir.y, dir.x) * (trailWidth / len);
-            
-            float fadeAlpha = alpha * 0.7f;  // More visible trails
-            float quadVerts[6 * 6] = {
-                a.x + perp.x, a.y + perp.y, r, g, bl, fadeAlpha,
-                a.x - perp.x, a.y - perp.y, r, g, bl, fadeAlpha,
-                b.x + perp.x, b.y + perp.y, r, g, bl, fadeAlpha * 0.5f,
-                b.x + perp.x, b.y + perp.y, r, g, bl, fadeAlpha * 0.5f,
-                a.x - perp.x, a.y - perp.y, r, g, bl, fadeAlpha,
-                b.x - perp.x, b.y - perp.y, r, g, bl, fadeAlpha * 0.5f
-            };
-            
-            unsigned int vao, vbo;
-            glGenVertexArrays(1, &vao);
-            glGenBuffers(1, &vbo);
-            glBindVertexArray(vao);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(quadVerts), quadVerts, GL_STREAM_DRAW);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glDeleteBuffers(1, &vbo);
-            glDeleteVertexArrays(1, &vao);
-        }
+void Renderer::drawParticles(const ParticleView& particles) {
+    ORB_PROFILE_SCOPE("render.particles");
+    const size_t n = particles.size();
+    if (n == 0) return;
+
+    // Visible world rectangle; a particle is kept if its (grown) glow quad touches it
+    const float minX = viewOrigin_.x;
+    const float minY = viewOrigin_.y;
+    const float maxX = minX + (float)width_ / viewScale_;
+    const float maxY = minY + (float)height_ / viewScale_;
+    const float minRadius = MIN_CORE_PX / viewScale_;
+
+    instanceData_.resize(n * INSTANCE_FLOATS);
+    float* out = instanceData_.data();
+    for (size_t i = 0; i < n; ++i) {
+        const float x = particles.x[i];
+        const float y = particles.y[i];
+        const float reach = std::max(particles.radius[i], minRadius) * GLOW_SCALE;
+        if (x + reach < minX || x - reach > maxX || y + reach < minY || y - reach > maxY) continue;
+        const Color& c = particles.color[i];
+        out[0] = x;
+        out[1] = y;
+        out[2] = particles.radius[i];
+        out[3] = c.r;
+        out[4] = c.g;
+        out[5] = c.b;
+        out += INSTANCE_FLOATS;
     }
+    const size_t drawn = (size_t)(out - instanceData_.data()) / INSTANCE_FLOATS;
+    if (drawn == 0) return;
+
+    glUseProgram(particleProgram_);
+    glUniformMatrix4fv(particleProjLoc_, 1, GL_FALSE, viewProj_);
+    glUniform1f(particlePixelScaleLoc_, viewScale_);
+
+    // Glow and core for every visible particle in a single draw call
+    glBindVertexArray(particleVao_);
+    pointParticleInstances(stream_.upload(instanceData_.data(), drawn * INSTANCE_FLOATS * sizeof(float)));
+    beginGpuPass(GpuParticles);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)drawn);
+    glBindVertexArray(0);
+    endGpuPass();
 }
 
-void Renderer::drawGravityWells(const std::vector<GravityWell>& wells) {
-    const int SEGMENTS = 32;
-    float proj[16] = {
-        2.0f / (float)width_, 0, 0, 0,
-        0, -2.0f / (float)height_, 0, 0,
-        0, 0, -1, 0,
-        -1, 1, 0, 1
-    };
-    glUseProgram(program_);
-    glUniformMatrix4fv(glGetUniformLocation(program_, "uProj"), 1, GL_FALSE, proj);
+void Renderer::drawParticles(const GpuParticleBuffers& particles) {
+    ORB_PROFILE_SCOPE("render.particles");
+    if (particles.count == 0) return;
 
-    for (const GravityWell& well : wells) {
-        // Outer glow (large, very transparent)
-        float outerRadius = 60.0f;
-        float outerVerts[(SEGMENTS + 2) * 6];
-        int i = 0;
-        outerVerts[i++] = well.pos.x;
-        outerVerts[i++] = well.pos.y;
-        outerVerts[i++] = 0.2f;
-        outerVerts[i++] = 0.4f;
-        outerVerts[i++] = 1.0f;
-        outerVerts[i++] = 0.15f;
-        for (int s = 0; s <= SEGMENTS; ++s) {
-            float a = (float)s / (float)SEGMENTS * 6.283185307f;
-            outerVerts[i++] = well.pos.x + outerRadius * std::cos(a);
-            outerVerts[i++] = well.pos.y + outerRadius * std::sin(a);
-            outerVerts[i++] = 0.2f;
-            outerVerts[i++] = 0.4f;
-            outerVerts[i++] = 1.0f;
-            outerVerts[i++] = 0.0f;
-        }
-        unsigned int vao, vbo;
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(float) * i), outerVerts, GL_STREAM_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-        glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
-        
-        // Middle glow
-        float midRadius = 35.0f;
-        i = 0;
-        float midVerts[(SEGMENTS + 2) * 6];
-        midVerts[i++] = well.pos.x;
-        midVerts[i++] = well.pos.y;
-        midVerts[i++] = 0.3f;
-        midVerts[i++] = 0.5f;
-        midVerts[i++] = 1.0f;
-        midVerts[i++] = 0.4f;
-        for (int s = 0; s <= SEGMENTS; ++s) {
-            float a = (float)s / (float)SEGMENTS * 6.283185307f;
-            midVerts[i++] = well.pos.x + midRadius * std::cos(a);
-            midVerts[i++] = well.pos.y + midRadius * std::sin(a);
-            midVerts[i++] = 0.3f;
-            midVerts[i++] = 0.5f;
-            midVerts[i++] = 1.0f;
-            midVerts[i++] = 0.0f;
-        }
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(float) * i), midVerts, GL_STREAM_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-        glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
-        
-        // Bright core
-        float coreRadius = 18.0f;
-        i = 0;
-        float coreVerts[(SEGMENTS + 2) * 6];
-        coreVerts[i++] = well.pos.x;
-        coreVerts[i++] = well.pos.y;
-        coreVerts[i++] = 0.4f;
-        coreVerts[i++] = 0.7f;
-        coreVerts[i++] = 1.0f;
-        coreVerts[i++] = 1.0f;
-        for (int s = 0; s <= SEGMENTS; ++s) {
-            float a = (float)s / (float)SEGMENTS * 6.283185307f;
-            coreVerts[i++] = well.pos.x + coreRadius * std::cos(a);
-            coreVerts[i++] = well.pos.y + coreRadius * std::sin(a);
-            coreVerts[i++] = 0.4f;
-            coreVerts[i++] = 0.7f;
-            coreVerts[i++] = 1.0f;
-            coreVerts[i++] = 0.8f;
+    // No CPU culling here (positions never leave the GPU): off-screen quads are
+    // clipped before rasterization, and the LOD in the shader still applies
+    glUseProgram(particleProgram_);
+    glUniformMatrix4fv(particleProjLoc_, 1, GL_FALSE, viewProj_);
+    glUniform1f(particlePixelScaleLoc_, viewScale_);
+
+    // The position buffer alternates every step, so re-point the attributes each draw
+    glBindVertexArray(gpuParticleVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, particles.position);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, particles.radius);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, particles.color);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+    beginGpuPass(GpuParticles);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)particles.count);
+    glBindVertexArray(0);
+    endGpuPass();
+}
+
+void Renderer::drawParticleTrails(const ParticleView& particles, const TrailView& trails) {
+    ORB_PROFILE_SCOPE("render.trails");
+    const float minX = viewOrigin_.x - TRAIL_MAX_WIDTH;
+    const float minY = viewOrigin_.y - TRAIL_MAX_WIDTH;
+    const float maxX = viewOrigin_.x + (float)width_ / viewScale_ + TRAIL_MAX_WIDTH;
+    const float maxY = viewOrigin_.y + (float)height_ / viewScale_ + TRAIL_MAX_WIDTH;
+    const float spacing = TRAIL_SPACING_PX / viewScale_;
+    const float spacingSq = spacing * spacing;
+
+    // Gather the visible segments of every trail into one buffer. Points
+    // closer than the spacing to the last kept point are dropped (a resting
+    // particle's trail collapses to nothing); each segment keeps the index of
+    // its start point so the width and fade along the trail are unchanged.
+    trailData_.clear();
+    for (size_t pi = 0; pi < trails.size(); ++pi) {
+        const int trailLength = trails.lengthOf(pi);
+        if (trailLength < 2) continue;
+        const Color& color = particles.color[pi];
+
+        Vec2 a = trails.point(pi, 0);
+        int ai = 0;
+        for (int i = 1; i < trailLength; ++i) {
+            const Vec2 b = trails.point(pi, i);
+            const float dx = b.x - a.x, dy = b.y - a.y;
+            const float distSq = dx * dx + dy * dy;
+            // Always reach the newest point so the trail meets its particle
+            if (distSq < spacingSq && (i < trailLength - 1 || distSq < 0.01f)) continue;
+            const bool visible = std::max(a.x, b.x) >= minX && std::min(a.x, b.x) <= maxX &&
+                                 std::max(a.y, b.y) >= minY && std::min(a.y, b.y) <= maxY;
+            if (visible) {
+                const float seg[SEGMENT_FLOATS] = {
+                    a.x, a.y, b.x, b.y, (float)ai, (float)trailLength, color.r, color.g, color.b
+                };
+                trailData_.insert(trailData_.end(), seg, seg + SEGMENT_FLOATS);
+            }
+            a = b;
+            ai = i;
         }
-        glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &vbo);
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(float) * i), coreVerts, GL_STREAM_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-        glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
     }
+    const size_t segments = trailData_.size() / SEGMENT_FLOATS;
+    if (segments == 0) return;
+
+    glUseProgram(trailProgram_);
+    glUniformMatrix4fv(trailProjLoc_, 1, GL_FALSE, viewProj_);
+
+    // All segments at once
+    glBindVertexArray(trailVao_);
+    pointTrailSegments(stream_.upload(trailData_.data(), trailData_.size() * sizeof(float)));
+    beginGpuPass(GpuTrails);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)segments);
+    glBindVertexArray(0);
+    endGpuPass();
 }
 
-void Renderer::drawCircle(const Particle& p) {
-    const int SEGMENTS = 32;  // Number of segments to approximate circle
-    
-    // Set up projection matrix once (shared for glow and core)
-    float W = (float)width_;
-    float H = (float)height_;
-    float proj[16] = {
-        2.0f/W, 0, 0, 0,
-        0, -2.0f/H, 0, 0,
-        0, 0, -1, 0,
-        -1, 1, 0, 1
-    };
-    int projLoc = glGetUniformLocation(program_, "uProj");
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, proj);
-
-    // --- Render outer glow (larger, semi-transparent) ---
-    float glowRadius = p.radius * 3.5f;  // Larger glow for more intensity
-    float glowAlpha = 0.4f;  // More visible glow
-    
-    float glowVerts[(SEGMENTS + 2) * 6];
-    int i = 0;
-    glowVerts[i++] = p.pos.x;
-    glowVerts[i++] = p.pos.y;
-    glowVerts[i++] = p.color.r;
-    glowVerts[i++] = p.color.g;
-    glowVerts[i++] = p.color.b;
-    glowVerts[i++] = glowAlpha;
-    
-    for (int s = 0; s <= SEGMENTS; ++s) {
-        float a = (float)s / (float)SEGMENTS * 6.283185307f;
-        glowVerts[i++] = p.pos.x + glowRadius * std::cos(a);
-        glowVerts[i++] = p.pos.y + glowRadius * std::sin(a);
-        glowVerts[i++] = p.color.r;
-        glowVerts[i++] = p.color.g;
-        glowVerts[i++] = p.color.b;
-        glowVerts[i++] = 0.0f;  // Fade to transparent at edge
+void Renderer::drawGravityWells(const std::vector<GravityWell>& wells) {
+    if (wells.empty()) return;
+    ORB_PROFILE_SCOPE("render.wells");
+    const float outer = WELL_LAYERS[0].radius;
+    const float minX = viewOrigin_.x - outer;
+    const float minY = viewOrigin_.y - outer;
+    const float maxX = viewOrigin_.x + (float)width_ / viewScale_ + outer;
+    const float maxY = viewOrigin_.y + (float)height_ / viewScale_ + outer;
+
+    // Fewer segments when the discs are small on screen; same for every well
+    const int segments = std::max(WELL_MIN_SEGMENTS,
+        std::min(WELL_MAX_SEGMENTS, (int)(outer * viewScale_ / WELL_PX_PER_SEGMENT)));
+    float rim[WELL_MAX_SEGMENTS + 1][2];
+    for (int s = 0; s <= segments; ++s) {
+        const float a = (float)s / (float)segments * 6.283185307f;
+        rim[s][0] = std::cos(a);
+        rim[s][1] = std::sin(a);
     }
 
-    unsigned int vao, vbo;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(float) * i), glowVerts, GL_STREAM_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-    glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
-
-    // --- Render bright core (smaller, fully opaque) ---
-    float coreVerts[(SEGMENTS + 2) * 6];
-    i = 0;
-    coreVerts[i++] = p.pos.x;
-    coreVerts[i++] = p.pos.y;
-    // Brighten core color for more intensity
-    coreVerts[i++] = std::min(1.0f, p.color.r * 1.5f);
-    coreVerts[i++] = std::min(1.0f, p.color.g * 1.5f);
-    coreVerts[i++] = std::min(1.0f, p.color.b * 1.5f);
-    coreVerts[i++] = 1.0f;  // Fully opaque core
-    
-    for (int s = 0; s <= SEGMENTS; ++s) {
-        float a = (float)s / (float)SEGMENTS * 6.283185307f;
-        coreVerts[i++] = p.pos.x + p.radius * std::cos(a);
-        coreVerts[i++] = p.pos.y + p.radius * std::sin(a);
-        coreVerts[i++] = std::min(1.0f, p.color.r * 1.5f);
-        coreVerts[i++] = std::min(1.0f, p.color.g * 1.5f);
-        coreVerts[i++] = std::min(1.0f, p.color.b * 1.5f);
-        coreVerts[i++] = 0.9f;  // Less fade for brighter edge
+    // Every layer of every visible well as triangles in one buffer
+    wellData_.clear();
+    for (const GravityWell& well : wells) {
+        if (well.pos.x < minX || well.pos.x > maxX || well.pos.y < minY || well.pos.y > maxY) continue;
+        for (const WellLayer& layer : WELL_LAYERS) {
+            const float c[6] = { well.pos.x, well.pos.y,
+                                 layer.centre[0], layer.centre[1], layer.centre[2], layer.centre[3] };
+            for (int s = 0; s < segments; ++s) {
+                wellData_.insert(wellData_.end(), c, c + 6);
+                for (int k = s; k <= s + 1; ++k) {
+                    const float v[6] = { well.pos.x + layer.radius * rim[k][0], well.pos.y + layer.radius * rim[k][1],
+                                         layer.rim[0], layer.rim[1], layer.rim[2], layer.rim[3] };
+                    wellData_.insert(wellData_.end(), v, v + 6);
+                }
+            }
+        }
     }
+    if (wellData_.empty()) return;
 
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(float) * i), coreVerts, GL_STREAM_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
-    glDrawArrays(GL_TRIANGLE_FAN, 0, SEGMENTS + 2);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    glUseProgram(program_);
+    glUniformMatrix4fv(programProjLoc_, 1, GL_FALSE, viewProj_);
+
+    glBindVertexArray(colorVao_);
+    pointColorVertices(stream_.upload(wellData_.data(), wellData_.size() * sizeof(float)));
+    beginGpuPass(GpuWells);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(wellData_.size() / 6));
+    glBindVertexArray(0);
+    endGpuPass();
 }
 
 void Renderer::drawDragPreview(Vec2 from, Vec2 to) {
@@ -423,29 +660,61 @@ void Renderer::drawDragPreview(Vec2 from, Vec2 to) {
         from.x, from.y, 1.0f, 1.0f, 0.6f, 0.8f,
         to.x,   to.y,   1.0f, 1.0f, 0.6f, 0.8f
     };
-    unsigned int vao, vbo;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STREAM_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindVertexArray(colorVao_);
+    pointColorVertices(stream_.upload(verts, sizeof(verts)));
 
     glUseProgram(program_);
-    float W = (float)width_;
-    float H = (float)height_;
-    float proj[16] = {
-        2.0f/W, 0, 0, 0,
-        0, -2.0f/H, 0, 0,
-        0, 0, -1, 0,
-        -1, 1, 0, 1
-    };
-    glUniformMatrix4fv(glGetUniformLocation(program_, "uProj"), 1, GL_FALSE, proj);
+    glUniformMatrix4fv(programProjLoc_, 1, GL_FALSE, viewProj_);
     glDrawArrays(GL_LINES, 0, 2);
+}
+
+void Renderer::drawProfilerOverlay(const std::vector<FrameTiming>& frames) {
+    ORB_PROFILE_SCOPE("render.overlay");
+    const float baseY = (float)height_ - OVERLAY_MARGIN;
+    overlayData_.clear();
+    auto quad = [&](float x0, float y0, float x1, float y1, float r, float g, float b, float a) {
+        const float v[6][6] = {
+            { x0, y0, r, g, b, a }, { x1, y0, r, g, b, a }, { x0, y1, r, g, b, a },
+            { x1, y0, r, g, b, a }, { x1, y1, r, g, b, a }, { x0, y1, r, g, b, a }
+        };
+        overlayData_.insert(overlayData_.end(), &v[0][0], &v[0][0] + 36);
+    };
+
+    // Backdrop spanning the history, with 16.7 ms and 33.3 ms reference lines
+    const float graphW = OVERLAY_BAR_WIDTH * (float)Profiler::FRAME_HISTORY;
+    const float graphH = 40.0f * OVERLAY_PX_PER_MS;
+    const float left = OVERLAY_MARGIN;
+    quad(left, baseY - graphH, left + graphW, baseY, 0.05f, 0.05f, 0.08f, 0.6f);
+    const float refMs[2] = { 1000.0f / 60.0f, 1000.0f / 30.0f };
+    for (float ms : refMs) {
+        float y = baseY - ms * OVERLAY_PX_PER_MS;
+        quad(left, y - 0.5f, left + graphW, y + 0.5f, 0.6f, 0.6f, 0.6f, 0.5f);
+    }
+
+    // One bar per frame: CPU frame time, with the GPU time drawn over it
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const float x0 = left + OVERLAY_BAR_WIDTH * (float)i;
+        const float x1 = x0 + OVERLAY_BAR_WIDTH - 0.5f;
+        const float cpuH = std::min(frames[i].cpuMs * OVERLAY_PX_PER_MS, graphH);
+        const float gpuH = std::min(frames[i].gpuMs * OVERLAY_PX_PER_MS, graphH);
+        const bool slow = frames[i].cpuMs > refMs[0] + 1.0f;
+        quad(x0, baseY - cpuH, x1, baseY, slow ? 0.9f : 0.2f, slow ? 0.3f : 0.8f, 0.3f, 0.7f);
+        if (gpuH > 0.0f)
+            quad(x0, baseY - gpuH, x1, baseY, 1.0f, 0.6f, 0.1f, 0.8f);
+    }
+
+    // Screen space, independent of the view
+    float proj[16];
+    orthoProjection(proj, width_, height_, Vec2(0.0f, 0.0f), 1.0f);
+    glUseProgram(program_);
+    glUniformMatrix4fv(programProjLoc_, 1, GL_FALSE, proj);
+
+    glBindVertexArray(colorVao_);
+    pointColorVertices(stream_.upload(overlayData_.data(), overlayData_.size() * sizeof(float)));
 
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    // Normal blending so the backdrop actually darkens what is behind it
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(overlayData_.size() / 6));
+    glBindVertexArray(0);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 }
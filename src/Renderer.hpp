@@ -5,25 +5,42 @@
  * Handles:
  * - OpenGL context creation and management
  * - Shader compilation and management
- * - Drawing particles as circles
+ * - Drawing particles as instanced glowing circles
+ * - Viewport culling and screen-space level of detail
  * - Drawing drag preview line
+ * - GPU pass timing and the profiler frame-time overlay
+ *
+ * All per-frame vertex data (particle instances, trail segments, wells, the
+ * drag preview and the overlay) goes through one StreamBuffer; each draw
+ * re-points its VAO's attributes at the offset its upload landed on.
  */
 
 #pragma once
 
 #include "Math.hpp"
-#include "Particle.hpp"
+#include "ParticleStore.hpp"
 #include "GravityWell.hpp"
+#include "Profiler.hpp"
+#include "StreamBuffer.hpp"
+#include <cstdint>
 #include <vector>
 
 struct SDL_Window;
+struct GpuParticleBuffers;
 
 /**
  * @class Renderer
  * @brief Manages all OpenGL rendering operations.
  * 
- * Uses OpenGL 3.2 Core Profile with simple shaders to draw particles
- * as filled circles. Handles viewport setup and coordinate transformation.
+ * Uses OpenGL 3.3 Core Profile. Particles are drawn with one instanced
+ * call per frame; the rest uses a simple color shader. Handles viewport
+ * setup and coordinate transformation.
+ *
+ * Everything but the profiler overlay is drawn through the view set with
+ * setView(). Particles, trail segments and wells outside it are skipped
+ * before upload, and detail follows the on-screen size: the particle glow
+ * shrinks away below a few pixels, trail points closer than a couple of
+ * pixels are merged, and well discs use fewer segments when small.
  */
 class Renderer {
 public:
@@ -35,9 +52,12 @@ public:
      * @param window SDL window to create OpenGL context for
      * @param width Initial viewport width
      * @param height Initial viewport height
+     * @param wantCompute Try for a GL 4.3 context first (GPU simulation); falls back to 3.3
      * @return true if initialization succeeded, false on error
      */
-    bool init(SDL_Window* window, int width, int height);
+    bool init(SDL_Window* window, int width, int height, bool wantCompute = false);
+    /** @brief True if the context supports compute shaders (GL 4.3+). */
+    bool hasCompute() const { return hasCompute_; }
     
     /**
      * @brief Update viewport size when window is resized.
@@ -46,17 +66,43 @@ public:
      */
     void resize(int width, int height);
 
+    /**
+     * @brief Set the world-to-screen mapping used by every world-space pass (usually from a Camera).
+     * @param origin World point shown at the top-left corner of the window
+     * @param scale Pixels per world unit (1 = world units are pixels)
+     */
+    void setView(Vec2 origin, float scale);
+
+    /**
+     * @brief Start a frame: collect finished GPU timer queries into the profiler.
+     */
+    void beginFrame();
+
     /**
      * @brief Clear the screen with dark background color.
      */
     void clear();
     
     /**
-     * @brief Draw all particles as circles.
-     * @param particles Vector of particles to render
+     * @brief Draw all particles as glowing circles in a single instanced draw call.
+     * @param particles Position/radius/color columns to render
+     */
+    void drawParticles(const ParticleView& particles);
+    /**
+     * @brief Draw particles resident on the GPU, reading the simulation's buffers directly (no upload).
+     * @param particles Buffers from GpuSimulation::buffers()
+     */
+    void drawParticles(const GpuParticleBuffers& particles);
+    /**
+     * @brief Draw fading trails behind particles (one instanced draw call for all segments).
+     * @param particles Particle columns (colors are taken from here)
+     * @param trails Trail history, one ring per particle
+     */
+    void drawParticleTrails(const ParticleView& particles, const TrailView& trails);
+    /**
+     * @brief Draw the glow discs of the visible gravity wells in one draw call.
+     * @param wells Wells to draw
      */
-    void drawParticles(const std::vector<Particle>& particles);
-    void drawParticleTrails(const std::vector<Particle>& particles);
     void drawGravityWells(const std::vector<GravityWell>& wells);
 
     /**
@@ -66,21 +112,71 @@ public:
      */
     void drawDragPreview(Vec2 from, Vec2 to);
 
+    /**
+     * @brief Draw the frame-time graph (CPU and GPU ms per frame) in the bottom-left corner.
+     * @param frames Frame history, oldest first
+     */
+    void drawProfilerOverlay(const std::vector<FrameTiming>& frames);
+
 private:
+    /** Draw passes timed with GL_TIME_ELAPSED queries */
+    enum GpuPass { GpuTrails, GpuWells, GpuParticles, GpuPassCount };
+    /** Frames of queries in flight before a result must be ready */
+    static constexpr int GPU_QUERY_FRAMES = 4;
+
+    /** One timer query slot */
+    struct GpuQuery {
+        unsigned int id = 0;
+        uint64_t frame = 0;       ///< Profiler frame the pass belongs to
+        uint64_t cpuStartNs = 0;  ///< CPU time the pass was issued (trace placement)
+        bool pending = false;     ///< Ended, result not read yet
+    };
+
+    /** @brief Begin timing pass if profiling is on and its slot is free. */
+    void beginGpuPass(GpuPass pass);
+    /** @brief End the pass started by beginGpuPass, if any. */
+    void endGpuPass();
+
     /**
      * @brief Compile and link shaders, store program ID.
      */
     void initShaders();
     
     /**
-     * @brief Draw a single particle as a filled circle using triangle fan.
-     * @param p Particle to draw
+     * @brief Create the persistent quad mesh, instance buffer and VAO for particles.
+     */
+    void initParticleBuffers();
+    /**
+     * @brief Create the VAO and streaming buffer for trail segment instances.
      */
-    void drawCircle(const Particle& p);
+    void initTrailBuffers();
 
     SDL_Window* window_ = nullptr;      ///< SDL window handle
     void* glContext_ = nullptr;          ///< OpenGL context handle
     int width_ = 0;                      ///< Current viewport width
     int height_ = 0;                     ///< Current viewport height
+    Vec2 viewOrigin_ = Vec2(0.0f, 0.0f); ///< World point at the top-left corner
+    float viewScale_ = 1.0f;             ///< Pixels per world unit
+    float viewProj_[16] = {};            ///< World-to-clip matrix, rebuilt only by setView() and resize()
     unsigned int program_ = 0;           ///< Compiled shader program ID
+    int programProjLoc_ = -1;            ///< uProj location in program_
+    unsigned int particleProgram_ = 0;   ///< Instanced SDF particle program
+    int particleProjLoc_ = -1;           ///< uProj location in particleProgram_
+    int particlePixelScaleLoc_ = -1;     ///< uPixelScale location in particleProgram_
+    unsigned int particleVao_ = 0;       ///< VAO binding quad mesh + instance attributes
+    unsigned int quadVbo_ = 0;           ///< Unit quad corners (static)
+    unsigned int gpuParticleVao_ = 0;    ///< Quad mesh + attributes sourced from GpuSimulation buffers
+    bool hasCompute_ = false;            ///< Context is GL 4.3 or newer
+    std::vector<float> instanceData_;    ///< CPU staging for instance upload
+    unsigned int trailProgram_ = 0;      ///< Instanced trail segment program
+    int trailProjLoc_ = -1;              ///< uProj location in trailProgram_
+    unsigned int trailVao_ = 0;          ///< VAO for trail segment instances
+    std::vector<float> trailData_;       ///< CPU staging for trail upload
+    unsigned int colorVao_ = 0;          ///< program_ layout (pos.xy, rgba): wells, drag preview, overlay
+    std::vector<float> wellData_;        ///< CPU staging for the wells
+    std::vector<float> overlayData_;     ///< CPU staging for the profiler graph
+    StreamBuffer stream_;                ///< Fenced frame ring all per-frame uploads go through
+    GpuQuery gpuQueries_[GPU_QUERY_FRAMES][GpuPassCount];  ///< Timer query ring
+    GpuQuery* activeQuery_ = nullptr;    ///< Query between beginGpuPass and endGpuPass
+    uint64_t gpuFrame_ = 0;              ///< Profiler frame index captured in beginFrame()
 };
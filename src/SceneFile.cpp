@@ -0,0 +1,158 @@
+/**
+ * @file SceneFile.cpp
+ * @brief Binary snapshot writer and memory-mapped reader.
+ */
+
+#include "SceneFile.hpp"
+#include "Simulation.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+    const char MAGIC[8] = { 'O', 'R', 'B', 'S', 'C', 'E', 'N', 'E' };
+    const uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+    static_assert(sizeof(Color) == 4 * sizeof(float), "Color is stored as raw RGBA floats");
+
+    /** Byte offset of each block; all derived from the two counts */
+    struct Layout {
+        size_t x, y, vx, vy, radius, color, wells, end;
+    };
+
+    size_t alignUp(size_t v) {
+        return (v + SCENE_FILE_ALIGN - 1) / SCENE_FILE_ALIGN * SCENE_FILE_ALIGN;
+    }
+
+    Layout layoutFor(uint64_t particles, uint64_t wells) {
+        const size_t column = (size_t)particles * sizeof(float);
+        Layout l;
+        l.x = alignUp(sizeof(SceneFileHeader));
+        l.y = alignUp(l.x + column);
+        l.vx = alignUp(l.y + column);
+        l.vy = alignUp(l.vx + column);
+        l.radius = alignUp(l.vy + column);
+        l.color = alignUp(l.radius + column);
+        l.wells = alignUp(l.color + (size_t)particles * sizeof(Color));
+        l.end = l.wells + (size_t)wells * 4 * sizeof(float);
+        return l;
+    }
+
+    /** Write n bytes at offset, zero-padding from the current position */
+    bool writeBlock(std::FILE* f, size_t& pos, size_t offset, const void* data, size_t n) {
+        static const char zeros[SCENE_FILE_ALIGN] = {};
+        while (pos < offset) {
+            size_t pad = std::min(offset - pos, sizeof(zeros));
+            if (std::fwrite(zeros, 1, pad, f) != pad) return false;
+            pos += pad;
+        }
+        if (n > 0 && std::fwrite(data, 1, n, f) != n) return false;
+        pos += n;
+        return true;
+    }
+
+    template <typename T>
+    const T* blockAt(const MappedFile& file, size_t offset) {
+        return reinterpret_cast<const T*>(file.data() + offset);  // Offsets are 64-aligned, the mapping page-aligned
+    }
+}
+
+bool saveScene(const Simulation& sim, const char* path) {
+    const ParticleStore& ps = sim.particles;
+    const uint64_t n = ps.size();
+    const uint64_t w = sim.gravityWells.size();
+    const Layout l = layoutFor(n, w);
+
+    SceneFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = SCENE_FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.particleCount = n;
+    header.wellCount = w;
+    header.worldW = sim.worldW;
+    header.worldH = sim.worldH;
+    header.restitution = sim.restitution;
+    header.drag = sim.drag;
+    header.fileSize = l.end;
+
+    std::vector<float> wells(w * 4);
+    for (size_t i = 0; i < w; ++i) {
+        const GravityWell& g = sim.gravityWells[i];
+        wells[i * 4 + 0] = g.pos.x;
+        wells[i * 4 + 1] = g.pos.y;
+        wells[i * 4 + 2] = g.strength;
+        wells[i * 4 + 3] = g.minRadius;
+    }
+
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        std::fprintf(stderr, "Could not write scene %s\n", path);
+        return false;
+    }
+    const size_t column = (size_t)n * sizeof(float);
+    size_t pos = 0;
+    bool ok = writeBlock(f, pos, 0, &header, sizeof(header))
+        && writeBlock(f, pos, l.x, ps.x.data(), column)
+        && writeBlock(f, pos, l.y, ps.y.data(), column)
+        && writeBlock(f, pos, l.vx, ps.vx.data(), column)
+        && writeBlock(f, pos, l.vy, ps.vy.data(), column)
+        && writeBlock(f, pos, l.radius, ps.radius.data(), column)
+        && writeBlock(f, pos, l.color, ps.color.data(), (size_t)n * sizeof(Color))
+        && writeBlock(f, pos, l.wells, wells.data(), wells.size() * sizeof(float));
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) std::fprintf(stderr, "Error while writing scene %s\n", path);
+    return ok;
+}
+
+bool loadScene(Simulation& sim, const char* path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::fprintf(stderr, "Could not open scene %s\n", path);
+        return false;
+    }
+    if (file.size() < sizeof(SceneFileHeader)) {
+        std::fprintf(stderr, "Scene %s is truncated\n", path);
+        return false;
+    }
+    SceneFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        std::fprintf(stderr, "%s is not an Orb scene file\n", path);
+        return false;
+    }
+    if (header.version != SCENE_FILE_VERSION || header.byteOrder != BYTE_ORDER_MARK) {
+        std::fprintf(stderr, "Scene %s has version %u (expected %u) or foreign byte order\n",
+                     path, header.version, SCENE_FILE_VERSION);
+        return false;
+    }
+    // Counts bounded by the file size first, so the layout arithmetic cannot overflow
+    if (header.particleCount > file.size() || header.wellCount > file.size()) {
+        std::fprintf(stderr, "Scene %s has a corrupt header\n", path);
+        return false;
+    }
+    const Layout l = layoutFor(header.particleCount, header.wellCount);
+    if (header.fileSize != file.size() || l.end > file.size()) {
+        std::fprintf(stderr, "Scene %s is truncated\n", path);
+        return false;
+    }
+
+    // Copied rather than borrowed, as the header explains; no trail rings yet
+    const size_t n = (size_t)header.particleCount;
+    sim.particles.assign(n, blockAt<float>(file, l.x), blockAt<float>(file, l.y),
+                         blockAt<float>(file, l.vx), blockAt<float>(file, l.vy),
+                         blockAt<float>(file, l.radius), blockAt<Color>(file, l.color));
+
+    const float* wells = blockAt<float>(file, l.wells);
+    sim.gravityWells.clear();
+    for (size_t i = 0; i < header.wellCount; ++i)
+        sim.gravityWells.emplace_back(Vec2(wells[i * 4 + 0], wells[i * 4 + 1]), wells[i * 4 + 2], wells[i * 4 + 3]);
+
+    sim.worldW = header.worldW;
+    sim.worldH = header.worldH;
+    sim.restitution = header.restitution;
+    sim.drag = header.drag;
+    return true;
+}
@@ -5,125 +5,726 @@
 
 #include "Simulation.hpp"
 #include "Math.hpp"
+#include "GravityKernel.hpp"
+#include "SimulationStep.hpp"
+#include "Collision.hpp"
+#include "Profiler.hpp"
 #include <cmath>
 #include <algorithm>
 
 namespace {
     const float MAX_DT = 1.0f / 30.0f;
     const float TINY_SPEED = 0.5f;
-    const float MIN_SEPARATION = 1.0e-6f;
-    /// Constant pull (px/s²) toward well when within this distance (so gravity is obvious)
-    const float GRAVITY_PULL = 400.0f;
-    const float GRAVITY_RANGE = 2000.0f;  // apply pull within this distance
+
+    inline ParticleColumns columnsOf(ParticleStore& ps, uint8_t* rest = nullptr) {
+        return ParticleColumns{ ps.x.data(), ps.y.data(), ps.vx.data(), ps.vy.data(), ps.radius.data(), rest };
+    }
+
+    /**
+     * @brief Earliest time of impact in [0, 1) of two circles whose offset changes by (dx, dy).
+     * @param mx, my Offset between the centres at the start of the move
+     * @param sumR Sum of the radii
+     * @return Fraction of the move at first contact, or a value >= 1 if they do not meet
+     */
+    inline float timeOfImpact(float mx, float my, float dx, float dy, float sumR) {
+        const float a = dx * dx + dy * dy;
+        const float b = 2.0f * (mx * dx + my * dy);
+        const float cc = mx * mx + my * my - sumR * sumR;
+        if (cc < 0.0f || b >= 0.0f) return 1.0f;  // Already overlapping (discrete pass) or moving apart
+        const float disc = b * b - 4.0f * a * cc;
+        if (disc < 0.0f) return 1.0f;              // Passes by
+        return (-b - std::sqrt(disc)) / (2.0f * a);
+    }
+
+    /// Forward half of the 3x3 stencil (E, SW, S, SE): each cell pair is visited once
+    const int NEIGHBOUR_OFFSETS[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+    /// Particles per parallel-for chunk in the per-particle passes
+    const size_t PARTICLE_GRAIN = 4096;
+    /// Fast particles per chunk in the sweep (each one queries a neighbourhood)
+    const size_t SWEEP_GRAIN = 256;
+    /// Below this many particles everything fits in cache and reordering is not worth it
+    const size_t MIN_REORDER_PARTICLES = 4096;
+}
+
+void Simulation::setThreadCount(int count) {
+    if (count == 1) {
+        jobs_.reset();
+        return;
+    }
+    jobs_ = std::make_unique<JobSystem>(count);
+    if (jobs_->threadCount() == 1) jobs_.reset();
+}
+
+int Simulation::threadCount() const {
+    return jobs_ ? jobs_->threadCount() : 1;
+}
+
+void Simulation::parallelFor(size_t count, size_t grain, const JobSystem::RangeFn& fn) {
+    if (jobs_)
+        jobs_->parallelFor(count, grain, fn);
+    else if (count > 0)
+        fn(0, count);
 }
 
 void Simulation::update(float dt) {
+    ORB_PROFILE_SCOPE("sim.update");
     dt = std::min(dt, MAX_DT);
+    stats_ = SimulationStats();
+    counters_.assign((size_t)threadCount(), WorkerCounters());
+
+    const size_t n = particles.size();
+    if (updateSleepState()) {
+        stats_.sleeping = std::min(asleep_, haloBegin_);  // Everything settled (halo copies too): nothing to do until a wake event
+        stats_.kineticChange = lastKinetic_ < 0.0 ? 0.0 : -lastKinetic_;
+        lastKinetic_ = 0.0;
+        return;
+    }
+    if (spatialReorder && n >= MIN_REORDER_PARTICLES && --reorderCountdown_ <= 0) {
+        ORB_PROFILE_SCOPE("sim.reorder");
+        reorderCountdown_ = REORDER_CHECK_STEPS;
+        const size_t owned = std::min(n, haloBegin_);  // Halo copies stay at the tail
+        const float gap = meanNeighbourGap(particles.x.data(), particles.y.data(), owned);
+        if (sortedLayout_ != particles.layoutVersion || gap > REORDER_DISORDER * sortedGap_) {
+            reorderParticles(owned);
+            sortedGap_ = meanNeighbourGap(particles.x.data(), particles.y.data(), owned);
+            sortedLayout_ = particles.layoutVersion;
+            stats_.reordered = 1;
+        }
+    }
+    const ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
 
-    // --- 0. Apply gravity from wells to particle velocities ---
-    for (Particle& p : particles) {
-        for (const GravityWell& well : gravityWells) {
-            float dx = well.pos.x - p.pos.x;
-            float dy = well.pos.y - p.pos.y;
-            float distSq = dx * dx + dy * dy;
-            if (distSq < 1.0e-6f) continue;
-            float dist = std::sqrt(distSq);
-            if (dist > GRAVITY_RANGE) continue;
-            float invDist = 1.0f / dist;
-            float accelMag = GRAVITY_PULL;  // constant pull so effect is unmissable
-            p.vel.x += (dx * invDist) * accelMag * dt;
-            p.vel.y += (dy * invDist) * accelMag * dt;
+    // --- 0. Apply gravity from wells (or, in N-body mode, from everything) to particle velocities ---
+    if (nbody) {
+        ORB_PROFILE_SCOPE("sim.gravity");
+        applyMutualGravity(dt);
+    } else if (!gravityWells.empty()) {
+        ORB_PROFILE_SCOPE("sim.gravity");
+        const GravityParams params{ wellPull, wellRange, 1.0e-6f };
+        const bool skipSleepers = c.rest && asleep_ > 0;
+        parallelFor(n, PARTICLE_GRAIN, [&](size_t begin, size_t end) {
+            if (!skipSleepers) {
+                applyWellGravity(c.x, c.y, c.vx, c.vy, begin, end,
+                                 gravityWells.data(), gravityWells.size(), params, dt);
+                return;
+            }
+            // The settle pass zeroes a sleeper's velocity, so pull only the
+            // runs of awake particles (sleepers cluster once sorted by position)
+            for (size_t i = begin; i < end;) {
+                while (i < end && c.rest[i] >= SLEEP_STEPS) ++i;
+                size_t run = i;
+                while (run < end && c.rest[run] < SLEEP_STEPS) ++run;
+                if (i < run)
+                    applyWellGravity(c.x, c.y, c.vx, c.vy, i, run,
+                                     gravityWells.data(), gravityWells.size(), params, dt);
+                i = run;
+            }
+        });
+    }
+
+    TrailBuffer& trailBuffer = particles.trails;
+    if (trails != trailBuffer.enabled)
+        trailBuffer.setEnabled(trails, c.x, c.y);
+    if (trails) {
+        if (trailLength != trailBuffer.capacity) trailBuffer.setCapacity(trailLength);
+        trailBuffer.spacing = trailSpacing;
+        if (--trailRegionCountdown_ <= 0 || trailBuffer.deferred) {
+            trailRegionCountdown_ = TRAIL_REGION_STEPS;
+            updateTrailRegion();
         }
     }
 
+    // One specialized kernel pair for this step's feature set
+    StepParams step;
+    step.dt = dt;
+    step.drag = drag;
+    step.restitution = restitution;
+    step.worldW = worldW;
+    step.worldH = worldH;
+    step.tinySpeed = TINY_SPEED;
+    step.sleepSpeed = SLEEP_SPEED;
+    step.sleepSteps = SLEEP_STEPS;
+    const StepKernels& kernels = stepKernels(trails, drag > 0.0f, nbody || !gravityWells.empty(), c.rest != nullptr);
+
     // --- 1. Integrate positions for all particles ---
-    for (Particle& p : particles) {
-        p.pos.x += p.vel.x * dt;
-        p.pos.y += p.vel.y * dt;
-        p.updateTrail();  // Update trail history
+    {
+        ORB_PROFILE_SCOPE("sim.integrate");
+        parallelFor(n, PARTICLE_GRAIN, [&](size_t begin, size_t end) {
+            kernels.integrate(c, trailBuffer, step, begin, end);
+        });
+    }
+
+    // Particles that moved further than their radius could have passed
+    // through a neighbour without ever overlapping it
+    fast_.clear();
+    float maxRadius = 0.0f, maxSlowStepSq = 0.0f;
+    if (continuousCollisions) {
+        for (size_t i = 0; i < n; ++i) {
+            if (collision::asleep(c, (int)i)) continue;
+            const float stepSq = (c.vx[i] * c.vx[i] + c.vy[i] * c.vy[i]) * dt * dt;
+            if (stepSq > c.r[i] * c.r[i])
+                fast_.push_back((int)i);
+            else
+                maxSlowStepSq = std::max(maxSlowStepSq, stepSq);
+            maxRadius = std::max(maxRadius, c.r[i]);
+        }
     }
 
     // --- 2. Particle-particle collisions (elastic, with restitution) ---
+    {
+        ORB_PROFILE_SCOPE("sim.collide");
+        // Sort-and-sweep has no spatial lookup, so CCD sweeps still go through the grid
+        if (n >= 2 && (collisionMode == CollisionMode::Grid
+                       || (collisionMode == CollisionMode::SweepAndPrune && !fast_.empty())))
+            buildGrid();
+        if (!fast_.empty() && collisionMode != CollisionMode::BruteForce && n >= 2)
+            dropCoherentFast(dt, maxSlowStepSq);
+        const bool sweep = !fast_.empty() && n >= 2;
+        if (sweep) {
+            ORB_PROFILE_SCOPE("sim.sweep");
+            sweepFastParticles(dt, maxRadius, std::sqrt(maxSlowStepSq));
+        }
+        if (collisionMode == CollisionMode::BruteForce)
+            collideBruteForce();
+        else if (collisionMode == CollisionMode::SweepAndPrune)
+            collideSweepAndPrune();
+        else if (n >= 2)
+            collideGrid();
+    }
+
+    // --- 3. Per-particle: drag, wall collisions, tiny-speed clamp ---
+    {
+        ORB_PROFILE_SCOPE("sim.walls");
+        parallelFor(n, PARTICLE_GRAIN, [&](size_t begin, size_t end) {
+            const size_t split = std::min(std::max(begin, haloBegin_), end);  // Halo copies from here on
+            const SettleTotals totals = kernels.settle(c, step, begin, split);
+            WorkerCounters& w = counters();
+            w.sleepers += totals.sleepers;
+            w.wallHits += totals.wallHits;
+            w.kinetic += totals.kinetic;
+            if (split < end) w.haloSleepers += kernels.settle(c, step, split, end).sleepers;
+        });
+    }
+
+    // Merge the per-worker counters
+    for (const WorkerCounters& w : counters_) {
+        stats_.pairTests += w.pairTests;
+        stats_.contacts += w.contacts;
+        stats_.wallHits += w.wallHits;
+        stats_.sleeping += w.sleepers;
+        stats_.occupiedCells += w.occupiedCells;
+        stats_.kineticEnergy += w.kinetic;
+    }
+    asleep_ = (size_t)stats_.sleeping;
+    for (const WorkerCounters& w : counters_)
+        asleep_ += (size_t)w.haloSleepers;
+    stats_.kineticChange = lastKinetic_ < 0.0 ? 0.0 : stats_.kineticEnergy - lastKinetic_;
+    lastKinetic_ = stats_.kineticEnergy;
+}
+
+void Simulation::dropCoherentFast(float dt, float& maxSlowStepSq) {
+    const ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
     const size_t n = particles.size();
+    const size_t cells = (size_t)grid_.cols * grid_.rows;
+
+    // Velocity bounds of each cell: minVx, maxVx, minVy, maxVy
+    cellVelocity_.resize(cells * 4);
+    for (size_t k = 0; k < cells; ++k) {
+        cellVelocity_[4 * k + 0] = cellVelocity_[4 * k + 2] = INFINITY;
+        cellVelocity_[4 * k + 1] = cellVelocity_[4 * k + 3] = -INFINITY;
+    }
     for (size_t i = 0; i < n; ++i) {
-        for (size_t j = i + 1; j < n; ++j) {
-            Particle& a = particles[i];
-            Particle& b = particles[j];
-            Vec2 delta = b.pos - a.pos;
-            float dist = delta.length();
-            float sumR = a.radius + b.radius;
+        float* b = &cellVelocity_[4 * (size_t)grid_.cellOf[i]];
+        b[0] = std::min(b[0], c.vx[i]);
+        b[1] = std::max(b[1], c.vx[i]);
+        b[2] = std::min(b[2], c.vy[i]);
+        b[3] = std::max(b[3], c.vy[i]);
+    }
 
-            if (dist >= sumR) continue;  // No overlap
+    // A step of at most one cell only reaches particles whose centres were
+    // within two cells (the cell edge is at least two radii), so a particle
+    // whose velocity is within r / dt of every velocity in that block cannot
+    // have passed through any of them
+    const float cellSq = grid_.cellSize * grid_.cellSize;
+    size_t kept = 0;
+    for (const int i : fast_) {
+        const float stepSq = (c.vx[i] * c.vx[i] + c.vy[i] * c.vy[i]) * dt * dt;
+        bool fast = stepSq > cellSq;
+        if (!fast) {
+            const int cell = grid_.cellOf[(size_t)i];
+            const int cx = cell % grid_.cols, cy = cell / grid_.cols;
+            const float limitSq = c.r[i] * c.r[i] / (dt * dt);
+            for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, grid_.rows - 1) && !fast; ++y) {
+                for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, grid_.cols - 1); ++x) {
+                    const float* b = &cellVelocity_[4 * (size_t)grid_.cellIndex(x, y)];
+                    if (b[0] > b[1]) continue;  // Empty
+                    const float dvx = std::max(c.vx[i] - b[0], b[1] - c.vx[i]);
+                    const float dvy = std::max(c.vy[i] - b[2], b[3] - c.vy[i]);
+                    if (dvx * dvx + dvy * dvy > limitSq) {
+                        fast = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (fast)
+            fast_[kept++] = i;
+        else
+            maxSlowStepSq = std::max(maxSlowStepSq, stepSq);  // Still a moving partner for the sweeps left
+    }
+    fast_.resize(kept);
+}
 
-            // Collision normal from a toward b (undefined if dist==0)
-            Vec2 n = (dist > MIN_SEPARATION) ? delta.normalized() : Vec2(1.0f, 0.0f);
+void Simulation::sweepFastParticles(float dt, float maxRadius, float maxSlowStep) {
+    const size_t n = particles.size();
+    const ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
+    const bool useGrid = collisionMode != CollisionMode::BruteForce && grid_.cols > 0;
+    const float invCell = useGrid ? 1.0f / grid_.cellSize : 0.0f;
+    stats_.sweptParticles = (uint64_t)std::count_if(fast_.begin(), fast_.end(),
+                                                    [&](int i) { return (size_t)i < haloBegin_; });
 
-            // Mass proportional to area (r²) so different sizes behave correctly
-            float m1 = a.radius * a.radius;
-            float m2 = b.radius * b.radius;
-            float totalMass = m1 + m2;
+    // A pair is swept from its faster member only; flags also mark who has bounced
+    enum : uint8_t { FAST = 1, BOUNCED = 2 };
+    fastMask_.assign(n, 0);
+    for (int i : fast_) fastMask_[i] = FAST;
+    uint8_t* flags = fastMask_.data();
+    auto stepSq = [&](int j) { return c.vx[j] * c.vx[j] + c.vy[j] * c.vy[j]; };
+    if (useGrid) {  // Sweep in cell order so neighbouring sweeps share cached neighbours
+        fast_.clear();
+        for (int j : grid_.items)
+            if (flags[j] & FAST) fast_.push_back(j);
+    }
 
-            // Position correction: push apart so they are exactly touching
-            float overlap = sumR - dist;
-            a.pos -= n * (overlap * (m2 / totalMass));
-            b.pos += n * (overlap * (m1 / totalMass));
+    // Detect (parallel, read-only): each fast particle's earliest contact
+    // along its relative path to every neighbour that was not already
+    // overlapping at the end of the step. Sleepers did not move.
+    sweepHits_.assign(fast_.size(), SweepHit{ 1.0f, -1, -1 });
+    parallelFor(fast_.size(), SWEEP_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const int i = fast_[f];
+            const float dix = c.vx[i] * dt, diy = c.vy[i] * dt;
+            const float speedSqI = stepSq(i);
+            SweepHit& best = sweepHits_[f];
+            auto test = [&](int j) {
+                if (j == i) return;
+                const float sumR = c.r[i] + c.r[j];
+                const float ex = c.x[i] - c.x[j], ey = c.y[i] - c.y[j];
+                if (ex * ex + ey * ey < sumR * sumR) return;  // Overlapping now: the discrete pass has it
+                const bool still = collision::asleep(c, j);
+                const float dx = dix - (still ? 0.0f : c.vx[j] * dt);
+                const float dy = diy - (still ? 0.0f : c.vy[j] * dt);
+                const float t = timeOfImpact(ex - dx, ey - dy, dx, dy, sumR);
+                if (t >= best.t) return;
+                if (flags[j] & FAST) {
+                    const float speedSqJ = stepSq(j);
+                    if (speedSqJ > speedSqI || (speedSqJ == speedSqI && j < i)) return;  // j sweeps this pair
+                }
+                best = SweepHit{ t, i, j };
+            };
+            if (!useGrid) {
+                for (size_t j = 0; j < n; ++j)
+                    test((int)j);
+                continue;
+            }
+            // The partner moved at most max(|d_i|, maxSlowStep) and touches
+            // within r_i + maxRadius, so pad the path's box by both
+            const float len = std::sqrt(dix * dix + diy * diy);
+            const float margin = c.r[i] + maxRadius + std::max(len, maxSlowStep);
+            const float x0 = std::min(c.x[i] - dix, c.x[i]) - margin, x1 = std::max(c.x[i] - dix, c.x[i]) + margin;
+            const float y0 = std::min(c.y[i] - diy, c.y[i]) - margin, y1 = std::max(c.y[i] - diy, c.y[i]) + margin;
+            const int cx0 = std::max(0, (int)std::floor((x0 - grid_.originX) * invCell));
+            const int cx1 = std::min(grid_.cols - 1, (int)std::floor((x1 - grid_.originX) * invCell));
+            const int cy0 = std::max(0, (int)std::floor((y0 - grid_.originY) * invCell));
+            const int cy1 = std::min(grid_.rows - 1, (int)std::floor((y1 - grid_.originY) * invCell));
+            // Cells are stored row-major, so each row of the box is one run of items
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                const int kEnd = grid_.cellStart[grid_.cellIndex(cx1, cy) + 1];
+                for (int k = grid_.cellStart[grid_.cellIndex(cx0, cy)]; k < kEnd; ++k) {
+                    const int j = grid_.items[k];
+                    if (c.x[j] >= x0 && c.x[j] <= x1) test(j);
+                }
+            }
+        }
+    });
 
-            // Elastic collision with restitution (1D along normal, then apply to velocity)
-            float v1n = dot(a.vel, n);
-            float v2n = dot(b.vel, n);
-            float impulse = (1.0f + restitution) * (v1n - v2n) / totalMass;
-            a.vel.x -= impulse * m2 * n.x;
-            a.vel.y -= impulse * m2 * n.y;
-            b.vel.x += impulse * m1 * n.x;
-            b.vel.y += impulse * m1 * n.y;
+    // Apply (serial, earliest first): rewind both particles to the contact,
+    // bounce, and let them travel the rest of the step with the new
+    // velocities. One swept bounce per particle per step; anything it runs
+    // into afterwards overlaps and is left to the discrete pass.
+    sweepHits_.erase(std::remove_if(sweepHits_.begin(), sweepHits_.end(),
+                                    [](const SweepHit& h) { return h.a < 0; }),
+                     sweepHits_.end());
+    std::sort(sweepHits_.begin(), sweepHits_.end(),
+              [](const SweepHit& p, const SweepHit& q) { return p.t < q.t; });
+    for (const SweepHit& h : sweepHits_) {
+        const int a = h.a, b = h.b;
+        if ((flags[a] | flags[b]) & BOUNCED) continue;
+        flags[a] |= BOUNCED;
+        flags[b] |= BOUNCED;
+        if (collision::asleep(c, b)) {  // A fast particle always wakes what it hits
+            c.vx[b] = 0;
+            c.vy[b] = 0;
+            c.rest[b] = 0;
         }
+
+        const float back = (1.0f - h.t) * dt;
+        c.x[a] -= c.vx[a] * back;
+        c.y[a] -= c.vy[a] * back;
+        c.x[b] -= c.vx[b] * back;
+        c.y[b] -= c.vy[b] * back;
+
+        const Vec2 nrm = Vec2(c.x[b] - c.x[a], c.y[b] - c.y[a]).normalized();
+        collision::applyImpulse(c, a, b, nrm, c.r[a] * c.r[a], c.r[b] * c.r[b], restitution);
+        if (countsPair((size_t)a, (size_t)b)) ++stats_.sweptContacts;
+        c.x[a] += c.vx[a] * back;
+        c.y[a] += c.vy[a] * back;
+        c.x[b] += c.vx[b] * back;
+        c.y[b] += c.vy[b] * back;
     }
+}
 
-    // --- 3. Per-particle: drag, wall collisions, tiny-speed clamp ---
-    for (Particle& p : particles) {
-        // Apply velocity damping (drag) if enabled
-        if (drag > 0.0f) {
-            float d = 1.0f - drag * dt;
-            p.vel.x *= d;
-            p.vel.y *= d;
+void Simulation::reorderParticles(size_t count) {
+    const size_t n = particles.size();
+    morton_.sort(particles.x.data(), particles.y.data(), count);
+    morton_.order.resize(n);
+    for (size_t i = count; i < n; ++i)
+        morton_.order[i] = (uint32_t)i;  // The rest keep their columns
+    const uint32_t* order = morton_.order.data();
+    newIndex_.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        newIndex_[order[i]] = (uint32_t)i;
+
+    const uint32_t oldLayout = particles.layoutVersion;
+    particles.permute(order);
+
+    // Carry the sleep state and the sort-and-sweep order across the new layout
+    if (sleepLayout_ == oldLayout && rest_.size() == n) {
+        restScratch_.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            restScratch_[i] = rest_[order[i]];
+        rest_.swap(restScratch_);
+        sleepLayout_ = particles.layoutVersion;
+    }
+    sap_.renumber(newIndex_.data(), n, oldLayout, particles.layoutVersion);
+
+    // Reorders are REORDER_CHECK_STEPS apart at least: free the scratch in between
+    morton_.release();
+    std::vector<uint32_t>().swap(newIndex_);
+    std::vector<uint8_t>().swap(restScratch_);
+}
+
+bool Simulation::updateSleepState() {
+    const size_t n = particles.size();
+    const bool layoutChanged = sleepLayout_ != particles.layoutVersion;
+    const bool resized = worldW != sleepW_ || worldH != sleepH_;
+    const size_t oldWells = sleepWells_;
+    sleepLayout_ = particles.layoutVersion;
+    sleepW_ = worldW;
+    sleepH_ = worldH;
+    sleepWells_ = gravityWells.size();
+
+    if (!sleeping || nbody) {
+        rest_.clear();  // Everyone starts awake when sleeping resumes
+        asleep_ = 0;
+        return false;
+    }
+    if (layoutChanged || resized) {
+        wakeAll();  // Indices moved or the walls did
+        rest_.resize(n, 0);
+        return false;
+    }
+    fitSleepState();
+
+    // Wake sleepers within range of newly placed wells
+    for (size_t w = oldWells; w < gravityWells.size() && asleep_ > 0; ++w) {
+        const Vec2 pos = gravityWells[w].pos;
+        for (size_t i = 0; i < n; ++i) {
+            if (rest_[i] < SLEEP_STEPS) continue;
+            const float dx = particles.x[i] - pos.x, dy = particles.y[i] - pos.y;
+            if (dx * dx + dy * dy <= wellRange * wellRange) {
+                rest_[i] = 0;
+                --asleep_;
+            }
         }
+    }
+    return n > 0 && asleep_ == n;
+}
+
+void Simulation::updateTrailRegion() {
+    const bool bounded = std::isfinite(trailMin.x) || std::isfinite(trailMin.y)
+                      || std::isfinite(trailMax.x) || std::isfinite(trailMax.y);
+    TrailBuffer& trailBuffer = particles.trails;
+    if (!bounded && !trailRegionBounded_ && !trailBuffer.deferred) return;  // New particles get a ring on their own
+    trailRegionBounded_ = bounded;
+    trailBuffer.deferred = false;
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+    for (size_t i = 0; i < particles.size(); ++i) {
+        if (x[i] >= trailMin.x && x[i] <= trailMax.x && y[i] >= trailMin.y && y[i] <= trailMax.y)
+            trailBuffer.attach(i, Vec2(x[i], y[i]));
+        else
+            trailBuffer.detach(i);
+    }
+}
 
-        float r = p.radius;
+void Simulation::fitSleepState() {
+    const size_t n = particles.size();
+    for (size_t i = n; i < rest_.size(); ++i)
+        if (rest_[i] >= SLEEP_STEPS) --asleep_;
+    rest_.resize(n, 0);
+}
 
-        // Wall collision detection and response
-        if (p.pos.x - r < 0) {
-            p.pos.x = r;
-            p.vel.x = std::abs(p.vel.x) * restitution;
+void Simulation::wakeAll() {
+    std::fill(rest_.begin(), rest_.end(), 0);
+    asleep_ = 0;
+}
+
+void Simulation::wakeNear(Vec2 pos, float range) {
+    if (sleepLayout_ != particles.layoutVersion) return;  // The next update() wakes everything anyway
+    for (size_t i = 0; i < rest_.size() && asleep_ > 0; ++i) {
+        if (rest_[i] < SLEEP_STEPS) continue;
+        const float dx = particles.x[i] - pos.x, dy = particles.y[i] - pos.y;
+        const float reach = range + particles.radius[i];
+        if (dx * dx + dy * dy <= reach * reach) {
+            rest_[i] = 0;
+            --asleep_;
         }
-        if (p.pos.x + r > worldW) {
-            p.pos.x = worldW - r;
-            p.vel.x = -std::abs(p.vel.x) * restitution;
+    }
+}
+
+void Simulation::applyMutualGravity(float dt) {
+    const size_t n = particles.size();
+    if (n == 0) return;
+
+    // Bodies: particles (mass r²) followed by wells (mass chosen so G·m = strength)
+    const size_t bodies = n + gravityWells.size();
+    bodyX_.assign(particles.x.begin(), particles.x.end());
+    bodyY_.assign(particles.y.begin(), particles.y.end());
+    bodyMass_.resize(bodies);
+    for (size_t i = 0; i < n; ++i)
+        bodyMass_[i] = particles.radius[i] * particles.radius[i];
+    for (size_t w = 0; w < gravityWells.size(); ++w) {
+        bodyX_.push_back(gravityWells[w].pos.x);
+        bodyY_.push_back(gravityWells[w].pos.y);
+        bodyMass_[n + w] = gravityWells[w].strength / gravityConstant;
+    }
+    tree_.build(bodyX_.data(), bodyY_.data(), bodyMass_.data(), bodies);
+
+    const ParticleColumns c = columnsOf(particles);
+    const float softeningSq = softening * softening;
+    parallelFor(n, PARTICLE_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            float ax, ay;
+            tree_.acceleration((int)i, c.x[i], c.y[i], theta, gravityConstant, softeningSq, ax, ay);
+            c.vx[i] += ax * dt;
+            c.vy[i] += ay * dt;
         }
-        if (p.pos.y - r < 0) {
-            p.pos.y = r;
-            p.vel.y = std::abs(p.vel.y) * restitution;
+    });
+}
+
+void Simulation::collideBruteForce() {
+    const int n = (int)particles.size();
+    ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
+    WorkerCounters& w = counters();
+    const bool halo = haloBegin_ < (size_t)n;
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            const bool hit = collision::resolveCollision(c, i, j, restitution);
+            if (!halo || countsPair((size_t)i, (size_t)j)) {
+                ++w.pairTests;
+                w.contacts += hit;
+            }
         }
-        if (p.pos.y + r > worldH) {
-            p.pos.y = worldH - r;
-            p.vel.y = -std::abs(p.vel.y) * restitution;
+    }
+}
+
+void Simulation::collideSweepAndPrune() {
+    const size_t n = particles.size();
+    sap_.update(particles.x.data(), particles.y.data(), particles.radius.data(), n, particles.layoutVersion);
+    const ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
+    WorkerCounters& w = counters();
+    const bool halo = haloBegin_ < n;
+    for (const auto& pair : sap_.pairs) {
+        const bool hit = collision::resolveCollision(c, pair.first, pair.second, restitution);
+        if (!halo || countsPair((size_t)pair.first, (size_t)pair.second)) {
+            ++w.pairTests;
+            w.contacts += hit;
         }
+    }
+}
 
-        // Stop particles that are moving too slowly (prevents jitter)
-        // Skip clamp when any gravity wells exist so gravity can pull stationary particles
-        float speedSq = p.vel.x * p.vel.x + p.vel.y * p.vel.y;
-        bool skipClamp = !gravityWells.empty();
-        if (!skipClamp && speedSq < TINY_SPEED * TINY_SPEED) {
-            p.vel.x = 0;
-            p.vel.y = 0;
+void Simulation::buildGrid() {
+    float maxRadius = 0.0f;
+    for (float r : particles.radius)
+        maxRadius = std::max(maxRadius, r);
+    grid_.build(particles.x.data(), particles.y.data(), particles.size(), 2.0f * maxRadius);
+}
+
+void Simulation::collideGrid() {
+    const size_t n = particles.size();
+    const ParticleColumns c = columnsOf(particles, rest_.empty() ? nullptr : rest_.data());
+    const std::vector<int>& start = grid_.cellStart;
+
+    // Cells holding only sleepers have nothing to resolve among themselves.
+    // A sleeper woken mid-pass marks its cell awake again (see resolve).
+    if (c.rest) {
+        cellAwake_.assign((size_t)grid_.cols * grid_.rows, 0);
+        for (size_t i = 0; i < n; ++i)
+            if (c.rest[i] < SLEEP_STEPS) cellAwake_[grid_.cellOf[i]] = 1;
+    }
+    auto awakeCell = [&](int cell) { return !c.rest || cellAwake_[cell] != 0; };
+    const std::vector<int>& items = grid_.items;
+    const bool halo = haloBegin_ < n;
+
+    // Pairs of cell (cx, cy) with itself and its forward neighbours, counted into w
+    auto collideCell = [&](int cx, int cy, WorkerCounters& w) {
+        const int cell = grid_.cellIndex(cx, cy);
+        const int begin = start[cell], end = start[cell + 1];
+        if (begin == end) return;
+        const uint64_t count = (uint64_t)(end - begin);
+        uint64_t tested = 0, contacts = 0;
+        uint64_t skipped = 0, skippedContacts = 0;  // Pairs left to another tile's counters (halo only)
+        auto resolve = [&](int a, int b) {
+            const bool hit = collision::resolveCollision(c, a, b, restitution);
+            contacts += hit;
+            // A contact may have woken a sleeper: mark its cell so the pairs
+            // it still has this pass are not skipped. Both cells are in this
+            // cell's neighbourhood, which no other cell of the colour reads.
+            if (hit && c.rest) cellAwake_[grid_.cellOf[a]] = cellAwake_[grid_.cellOf[b]] = 1;
+            if (halo && !countsPair((size_t)a, (size_t)b)) {
+                ++skipped;
+                skippedContacts += hit;
+            }
+        };
+        if (!halo) {
+            ++w.occupiedCells;
+        } else {
+            for (int i = begin; i < end; ++i) {
+                if ((size_t)items[i] < haloBegin_) {
+                    ++w.occupiedCells;
+                    break;
+                }
+            }
+        }
+
+        // Pairs inside the cell
+        if (awakeCell(cell)) {
+            tested = count * (count - 1) / 2;
+            for (int i = begin; i < end; ++i)
+                for (int j = i + 1; j < end; ++j)
+                    resolve(items[i], items[j]);
         }
+
+        // Pairs with forward neighbour cells
+        for (const auto& off : NEIGHBOUR_OFFSETS) {
+            const int nx = cx + off[0], ny = cy + off[1];
+            if (nx < 0 || nx >= grid_.cols || ny >= grid_.rows) continue;
+            const int nc = grid_.cellIndex(nx, ny);
+            if (!awakeCell(cell) && !awakeCell(nc)) continue;
+            const int nBegin = start[nc], nEnd = start[nc + 1];
+            tested += count * (uint64_t)(nEnd - nBegin);
+            for (int i = begin; i < end; ++i)
+                for (int j = nBegin; j < nEnd; ++j)
+                    resolve(items[i], items[j]);
+        }
+        w.pairTests += tested - skipped;
+        w.contacts += contacts - skippedContacts;
+    };
+
+    // Nine-colour schedule: a cell only writes particles in its own 3x3
+    // neighbourhood, so cells whose column and row agree mod 3 never touch
+    // the same particle and can run concurrently. The result does not
+    // depend on the thread count.
+    const int workers = threadCount();
+    for (int colour = 0; colour < 9; ++colour) {
+        const int ox = colour % 3, oy = colour / 3;
+        const int bands = (grid_.rows - oy + 2) / 3;
+        if (bands <= 0) continue;
+        const size_t grain = std::max(1, bands / (workers * 4));
+        parallelFor((size_t)bands, grain, [&](size_t begin, size_t end) {
+            WorkerCounters& w = counters();
+            for (size_t band = begin; band < end; ++band) {
+                const int cy = oy + 3 * (int)band;
+                for (int cx = ox; cx < grid_.cols; cx += 3)
+                    collideCell(cx, cy, w);
+            }
+        });
     }
+    stats_.cellParticles = std::min(n, haloBegin_);
 }
 
 void Simulation::clear() {
     particles.clear();
     gravityWells.clear();
+    lastKinetic_ = -1.0;
 }
 
 void Simulation::addGravityWell(float x, float y) {
     gravityWells.emplace_back(Vec2(x, y));
 }
+
+void Simulation::spawnBatch(Span<const Particle> batch) {
+    if (batch.empty()) return;
+    ORB_PROFILE_SCOPE("sim.spawn");
+    if (sleepLayout_ == particles.layoutVersion && !rest_.empty())
+        fitSleepState();  // Counters left past the end by a truncation must not pass to the batch
+    particles.addBatch(batch);
+}
+
+void Simulation::spawnBatch(Span<const Particle> batch, Span<const uint8_t> asleep) {
+    const size_t first = particles.size();
+    spawnBatch(batch);
+    if (!sleeping || nbody || rest_.size() != first || sleepLayout_ != particles.layoutVersion) return;
+    rest_.resize(particles.size(), 0);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!asleep[i]) continue;
+        rest_[first + i] = SLEEP_STEPS;
+        ++asleep_;
+    }
+}
+
+void Simulation::sample(ParticleSample& out, size_t maxParticles) const {
+    out.clear();
+    out.total = particles.size();
+    out.take(particles, 0, particles.size(), sampleStride(particles.size(), maxParticles));
+}
+
+void Simulation::removeParticles(Span<const ParticleHandle> handles) {
+    // The sleep state can only follow the particles if it matches the current layout
+    const bool carry = sleepLayout_ == particles.layoutVersion && !rest_.empty();
+    if (carry) fitSleepState();
+    const bool sorted = sortedLayout_ == particles.layoutVersion;
+    for (const ParticleHandle& h : handles) {
+        const size_t i = particles.indexOf(h);
+        if (i == ParticleStore::NPOS) continue;
+        if (carry) {
+            if (rest_[i] >= SLEEP_STEPS) --asleep_;
+            rest_[i] = rest_.back();
+            rest_.pop_back();
+        }
+        particles.removeAt(i);
+    }
+    if (carry) sleepLayout_ = particles.layoutVersion;
+    if (sorted) sortedLayout_ = particles.layoutVersion;  // Filling a few gaps from the tail barely disturbs the order
+}
+
+void Simulation::truncateParticles(size_t n) {
+    if (n >= particles.size()) return;
+    particles.truncate(n);
+    if (sleepLayout_ == particles.layoutVersion && !rest_.empty()) fitSleepState();
+}
+
+size_t Simulation::particleAt(float px, float py) const {
+    size_t best = ParticleStore::NPOS;
+    float bestDistSq = 0.0f;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        const float dx = particles.x[i] - px, dy = particles.y[i] - py;
+        const float distSq = dx * dx + dy * dy;
+        const float r = particles.radius[i];
+        if (distSq <= r * r && (best == ParticleStore::NPOS || distSq < bestDistSq)) {
+            best = i;
+            bestDistSq = distSq;
+        }
+    }
+    return best;
+}
@@ -11,9 +11,69 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include "Particle.hpp"
+#include "ParticleStore.hpp"
 #include "GravityWell.hpp"
+#include "UniformGrid.hpp"
+#include "SweepAndPrune.hpp"
+#include "MortonOrder.hpp"
+#include "JobSystem.hpp"
+#include "BarnesHut.hpp"
+#include "SimulationBackend.hpp"
+
+/** Broadphase used to find candidate pairs for particle-particle collisions. */
+enum class CollisionMode {
+    Grid,          ///< Uniform grid rebuilt every step (default)
+    BruteForce,    ///< All-pairs O(n²) reference path, kept for diffing results
+    SweepAndPrune  ///< x-sorted boxes kept across steps; for widely mixed radii
+};
+
+/**
+ * Counters gathered during the most recent update().
+ *
+ * Pair tests against contacts separates algorithmic blow-up (a dense pile
+ * where the broadphase hands out many more candidates per particle) from
+ * plain throughput (the same candidates per particle, just slower).
+ * Workers count into their own padded slots; the slots are merged once at
+ * the end of the step.
+ */
+struct SimulationStats {
+    uint64_t pairTests = 0;   ///< Narrow-phase pair tests (candidate pairs from the broadphase)
+    uint64_t contacts = 0;    ///< Overlapping pairs resolved by the discrete pass
+    uint64_t sweptContacts = 0;  ///< Bounces applied by the continuous sweep
+    uint64_t wallHits = 0;    ///< Wall bounces
+    uint64_t sleeping = 0;    ///< Particles asleep after the step
+    uint64_t sweptParticles = 0; ///< Fast particles moved by continuous collision detection
+    uint64_t reordered = 0;   ///< 1 if the particles were re-sorted along the Z-order curve this step
+    uint64_t occupiedCells = 0;  ///< Grid cells holding at least one particle (grid broadphase only)
+    uint64_t cellParticles = 0;  ///< Particles binned into those cells
+    double kineticEnergy = 0.0;  ///< Sum of r²·|v|²/2 after the step (the collision mass, m = r²)
+    double kineticChange = 0.0;  ///< kineticEnergy minus the previous step's (restitution < 1 drains it; 0 on the first step)
+
+    /** @brief Mean particles per occupied grid cell (0 without the grid). */
+    double particlesPerCell() const {
+        return occupiedCells ? (double)cellParticles / (double)occupiedCells : 0.0;
+    }
+
+    /** @brief Add another domain's counters (e.g. the tiles of one world). */
+    void add(const SimulationStats& o) {
+        pairTests += o.pairTests;
+        contacts += o.contacts;
+        sweptContacts += o.sweptContacts;
+        wallHits += o.wallHits;
+        sleeping += o.sleeping;
+        sweptParticles += o.sweptParticles;
+        reordered += o.reordered;
+        occupiedCells += o.occupiedCells;
+        cellParticles += o.cellParticles;
+        kineticEnergy += o.kineticEnergy;
+        kineticChange += o.kineticChange;
+    }
+};
 
 /**
  * @struct Simulation
@@ -21,17 +81,277 @@
  * 
  * Contains particles, gravity wells, and simulation parameters. update() does:
  * gravity forces, integrate, particle-particle collisions, drag, walls.
+ * Gravity is either the fixed well pull or, with nbody set, mutual
+ * attraction between all particles and wells through a Barnes–Hut tree.
+ * Each pass is split into chunks on a work-stealing pool when more than
+ * one thread is configured (see setThreadCount()). The per-particle
+ * integrate and settle passes run kernels specialized on trails, drag,
+ * gravity and sleeping (SimulationStep.hpp), picked once per step.
+ *
+ * A particle that moves further than its own radius in one step can pass
+ * through a neighbour without the two ever overlapping at a step boundary.
+ * With continuousCollisions, each such fast particle is swept before the
+ * discrete pass: its path relative to each nearby particle is tested for
+ * the earliest time of impact, and the pair is rewound to the contact,
+ * bounced, and moved on for the rest of the step. Detection runs in
+ * parallel; only the fast particles' neighbourhoods are searched. What
+ * counts is speed relative to the neighbours: a particle moving with the
+ * particles around it (a coherent stream, a rigid cluster) is not swept.
+ * The sweep is off by default: where relative speeds genuinely exceed a
+ * radius per step nearly every particle is swept, and a step costs several
+ * times as much (the ring scene, whose orbit speeds spread by 20%, goes
+ * from about 2.6 to 14 ms per step at N=20000).
+ *
+ * With sleeping on, a particle that stays slower than SLEEP_SPEED for
+ * SLEEP_STEPS steps is put to sleep: its velocity is zeroed and gravity,
+ * integration, walls and trails skip it, as do collisions unless a moving
+ * particle hits it. Sleepers wake when a moving particle touches them, a
+ * well is added within range, or the world is resized. Any layout change
+ * (removal, clear, load) wakes everything, as does N-body mode, which
+ * does not sleep. Once every particle is asleep, update() returns without
+ * doing any work.
+ *
+ * Particles are stored in spawn order, so neighbours in space drift apart
+ * in memory. With spatialReorder, every REORDER_CHECK_STEPS steps the mean
+ * distance between particles adjacent in memory is measured, and once it
+ * has grown REORDER_DISORDER times past its value after the last sort
+ * (or the layout changed some other way), the particles are re-sorted
+ * along a Z-order curve. Handles and colours move with their particles;
+ * bare column indices do not.
+ *
+ * Trails are optional and kept only where they are wanted: with trails
+ * off no history is stored at all, and with a finite trail region (the
+ * app sets it to the view) particles outside it give their ring back every
+ * TRAIL_REGION_STEPS steps. Samples are spaced trailSpacing apart, so a
+ * trail covers a distance rather than a fixed number of steps. A ring of
+ * trailLength samples is 8 * trailLength bytes per particle that has one,
+ * which at the defaults is most of a particle's memory.
+ *
+ * As a SimulationBackend, a Simulation is the whole world in one domain;
+ * TiledSimulation runs one Simulation per tile of a larger world.
  */
-struct Simulation {
+struct Simulation : SimulationBackend {
     float worldW = 1280.0f;
     float worldH = 720.0f;
     float restitution = 0.9f;
     float drag = 0.0f;
+    CollisionMode collisionMode = CollisionMode::Grid;
+    bool sleeping = true;            ///< Let particles at rest sleep until something disturbs them
+    bool continuousCollisions = false;///< Sweep particles that move further than their radius in a step (costly, see above)
+    bool spatialReorder = true;      ///< Keep particles that are close in space close in memory
+    bool trails = true;              ///< Record trail history (off frees it; skip when nothing draws it)
+    int trailLength = TrailBuffer::DEFAULT_LENGTH;      ///< Samples per trail
+    float trailSpacing = TrailBuffer::DEFAULT_SPACING;  ///< Minimum distance between trail samples (px)
+    Vec2 trailMin = Vec2(-INFINITY, -INFINITY);         ///< Only particles inside [trailMin, trailMax] keep a trail
+    Vec2 trailMax = Vec2(INFINITY, INFINITY);
+    float wellPull = 400.0f;         ///< Constant pull (px/s²) toward each well within wellRange (so gravity is obvious)
+    float wellRange = 2000.0f;       ///< Wells further away than this have no effect (px)
+
+    // N-body gravity (particles attract each other; mass = radius², as in collisions)
+    bool nbody = false;              ///< Use Barnes–Hut mutual gravity instead of the fixed well pull
+    float theta = 0.5f;              ///< Barnes–Hut opening angle (0 = exact direct sum)
+    float gravityConstant = 500.0f;  ///< G in a = G·m / r² (px³ / (mass·s²))
+    float softening = 4.0f;          ///< Plummer softening length (px)
 
-    std::vector<Particle> particles;
+    ParticleStore particles;
     std::vector<GravityWell> gravityWells;
 
+    /// Particles slower than this (px/s) count as resting
+    static constexpr float SLEEP_SPEED = 0.5f;
+    /// Consecutive resting steps before a particle falls asleep
+    static constexpr uint8_t SLEEP_STEPS = 60;
+    /// Steps between checks of the memory-layout disorder
+    static constexpr int REORDER_CHECK_STEPS = 32;
+    /// Growth of the neighbour gap since the last sort that triggers a re-sort
+    static constexpr float REORDER_DISORDER = 2.0f;
+    /// Steps between passes that hand out and take back trails by region
+    static constexpr int TRAIL_REGION_STEPS = 8;
+
     void update(float dt);
     void clear();
     void addGravityWell(float x, float y);
+    /**
+     * @brief Append a batch of particles in one go (see ParticleStore::addBatch()).
+     *
+     * The new particles start awake and are picked up by the next update().
+     */
+    void spawnBatch(Span<const Particle> batch) override;
+    /**
+     * @brief spawnBatch(), but particles whose asleep flag is set start asleep.
+     *
+     * For halo copies of a neighbour's sleepers, so a tile whose own
+     * particles and copies have all settled still takes the all-asleep
+     * shortcut. The flags only apply while the sleep state is current
+     * (after an update() with sleeping on); otherwise the batch starts awake.
+     */
+    void spawnBatch(Span<const Particle> batch, Span<const uint8_t> asleep);
+    /**
+     * @brief Remove particles by handle without waking the rest.
+     *
+     * ParticleStore::remove() changes the layout, which wakes everything at
+     * the next update(); here the sleep state moves along with the particles
+     * that fill the gaps. Stale handles are skipped.
+     */
+    void removeParticles(Span<const ParticleHandle> handles);
+    /**
+     * @brief Remove every particle from column n on, with its sleep state.
+     *
+     * Unlike a bare ParticleStore::truncate(), the sleep counters of the
+     * removed tail go too, so particles appended afterwards start awake
+     * rather than inheriting them.
+     */
+    void truncateParticles(size_t n);
+    /**
+     * @brief Treat the particles from column owned on as halo copies of a neighbour's particles.
+     *
+     * Halo copies take part in the step as usual, but stats() only counts
+     * the owned particles: their sleepers, wall hits, kinetic energy and
+     * grid cells, and the pairs they form. A pair of an owned particle and
+     * a copy is counted only when the copy is at or after countedFrom, so
+     * the tile that owns the other particle can count it instead (copies in
+     * [owned, countedFrom) come from tiles that do). Pairs of two copies are
+     * not counted. The Z-order reorder leaves the copies at the tail, so
+     * truncateParticles(owned) still drops them after the step. Stays in
+     * effect until clearHalo().
+     */
+    void setHalo(size_t owned, size_t countedFrom) {
+        haloBegin_ = owned;
+        haloCounted_ = countedFrom;
+    }
+    /** @brief Count every particle again (see setHalo()). */
+    void clearHalo() { setHalo(ParticleStore::NPOS, ParticleStore::NPOS); }
+    /**
+     * @brief Column index of the particle covering (x, y), or ParticleStore::NPOS.
+     *
+     * Linear scan; meant for UI picking, not per-frame use.
+     */
+    size_t particleAt(float x, float y) const;
+
+    /** @brief Wake every particle (call after editing positions or velocities directly). */
+    void wakeAll();
+    /** @brief Wake the sleepers that come within range of pos (e.g. what rested on a removed particle). */
+    void wakeNear(Vec2 pos, float range);
+    /** @brief True if particle i is asleep. */
+    bool isAsleep(size_t i) const { return i < rest_.size() && rest_[i] >= SLEEP_STEPS; }
+
+    /**
+     * @brief Set how many threads update() uses.
+     * @param count Total threads including the caller; 0 = hardware concurrency, 1 = serial
+     */
+    void setThreadCount(int count);
+    /** @brief Threads update() currently uses (1 when running serially). */
+    int threadCount() const override;
+
+    /** @brief Counters from the most recent update(). */
+    const SimulationStats& stats() const { return stats_; }
+
+    // SimulationBackend
+    void step(float dt) override { update(dt); }
+    size_t particleCount() const override { return particles.size(); }
+    SimulationStats stepStats() const override { return stats_; }
+    void sample(ParticleSample& out, size_t maxParticles) const override;
+    size_t memoryBytes() const override { return particles.memoryBytes(); }
+
+private:
+    /** @brief Run fn over [0, count) on the pool, or inline when serial. */
+    void parallelFor(size_t count, size_t grain, const JobSystem::RangeFn& fn);
+    /** @brief Add Barnes–Hut gravity from all particles and wells (wells as bodies of mass strength / G). */
+    void applyMutualGravity(float dt);
+    /** @brief Resolve every overlapping pair found through grid_ (cells in parallel, race-free). */
+    void collideGrid();
+    /** @brief Resolve every overlapping pair by testing all i < j (reference path). */
+    void collideBruteForce();
+    /** @brief Resolve the pairs whose boxes overlap in sap_ (serial, in sweep order). */
+    void collideSweepAndPrune();
+    /** @brief Bin the particles into grid_ for this step's collision passes. */
+    void buildGrid();
+    /**
+     * @brief Take the particles out of fast_ that move with their neighbourhood (needs grid_).
+     *
+     * Only relative motion can carry one particle through another, so a
+     * particle whose velocity differs from every velocity within two grid
+     * cells by less than its radius per step is not swept, however fast it
+     * moves. Dropped particles still count as moving partners, through
+     * maxSlowStepSq.
+     */
+    void dropCoherentFast(float dt, float& maxSlowStepSq);
+    /**
+     * @brief Bounce each particle in fast_ off the first neighbour its path crossed this step.
+     * @param maxSlowStep Longest step taken by an awake particle not in fast_
+     */
+    void sweepFastParticles(float dt, float maxRadius, float maxSlowStep);
+    /** @brief Sort the first count particles (and the per-particle state kept here) along the Z-order curve. */
+    void reorderParticles(size_t count);
+    /** @brief Give particles inside the trail region a trail and take it from the rest. */
+    void updateTrailRegion();
+    /**
+     * @brief Size the sleep state to the particles and apply wake events.
+     * @return true if every particle is asleep and the step can be skipped
+     */
+    bool updateSleepState();
+    /**
+     * @brief Fit rest_ to the particle count after truncation or appends (same layout).
+     *
+     * The dropped tail takes its sleepers out of asleep_; new particles start awake.
+     */
+    void fitSleepState();
+
+    /** One worker's share of this step's counters, on its own cache line. */
+    struct alignas(64) WorkerCounters {
+        uint64_t pairTests = 0;
+        uint64_t contacts = 0;
+        uint64_t wallHits = 0;
+        uint64_t sleepers = 0;
+        uint64_t haloSleepers = 0;  ///< Sleepers among the halo copies (in asleep_, not in stats_)
+        uint64_t occupiedCells = 0;
+        double kinetic = 0.0;
+    };
+    /** @brief The calling worker's counters (slot 0 when serial). */
+    WorkerCounters& counters() { return counters_[jobs_ ? (size_t)jobs_->workerIndex() : 0]; }
+    /** @brief True if the pair (a, b) enters this step's counters (see setHalo()). */
+    bool countsPair(size_t a, size_t b) const {
+        const size_t lo = std::min(a, b), hi = std::max(a, b);
+        return hi < haloBegin_ || (lo < haloBegin_ && hi >= haloCounted_);
+    }
+
+    UniformGrid grid_;   ///< Broadphase buffers, rebuilt each step
+    SweepAndPrune sap_;  ///< Sort-and-sweep order, kept between steps
+    std::unique_ptr<JobSystem> jobs_;   ///< Worker pool; null when running serially
+    SimulationStats stats_;             ///< Filled in by update()
+    std::vector<WorkerCounters> counters_;  ///< One slot per thread, merged into stats_ at the end of update()
+    double lastKinetic_ = -1.0;         ///< stats_.kineticEnergy of the previous step (negative before the first)
+    size_t haloBegin_ = ParticleStore::NPOS;    ///< First halo copy (see setHalo())
+    size_t haloCounted_ = ParticleStore::NPOS;  ///< First halo copy whose pairs with owned particles count here
+    BarnesHutTree tree_;                ///< N-body quadtree, rebuilt each step
+    std::vector<float> bodyX_, bodyY_, bodyMass_;  ///< Tree input: particles, then wells
+
+    /** Earliest contact found by a sweep: a's path met b at fraction t of the step. */
+    struct SweepHit {
+        float t;
+        int a, b;
+    };
+    std::vector<int> fast_;             ///< Particles that moved further than their radius this step
+    std::vector<uint8_t> fastMask_;     ///< Per-particle sweep flags (only filled when fast_ is non-empty)
+    std::vector<SweepHit> sweepHits_;
+    std::vector<float> cellVelocity_;   ///< dropCoherentFast(): velocity bounds per grid cell
+
+    // Spatial reordering
+    MortonOrder morton_;                ///< All three are only allocated inside reorderParticles()
+    std::vector<uint32_t> newIndex_;    ///< Inverse of morton_.order
+    std::vector<uint8_t> restScratch_;
+    int reorderCountdown_ = 0;          ///< Steps until the next disorder check
+    float sortedGap_ = 0.0f;            ///< meanNeighbourGap() right after the last sort
+    uint32_t sortedLayout_ = ~0u;       ///< particles.layoutVersion after the last sort (other layouts are re-sorted)
+
+    // Trails
+    int trailRegionCountdown_ = 0;      ///< Steps until the next updateTrailRegion()
+    bool trailRegionBounded_ = false;   ///< The last region pass had a finite region (some trails may be missing)
+
+    // Sleep state
+    std::vector<uint8_t> rest_;         ///< Resting steps per particle, saturating at SLEEP_STEPS (= asleep)
+    std::vector<uint8_t> cellAwake_;    ///< Grid cells holding at least one awake particle
+    uint32_t sleepLayout_ = 0;          ///< particles.layoutVersion rest_ was built for
+    size_t sleepWells_ = 0;             ///< Wells seen last step (new ones wake particles in range)
+    float sleepW_ = 0.0f, sleepH_ = 0.0f;  ///< World size seen last step
+    size_t asleep_ = 0;                 ///< Particles asleep after the last step
 };
@@ -0,0 +1,93 @@
+/**
+ * @file SimulationBackend.hpp
+ * @brief Interface shared by the single-domain Simulation and the tiled decomposition.
+ *
+ * Code that only steps a world, feeds it particles and looks at the result
+ * (the benchmark, a viewer) talks to a SimulationBackend, so it does not
+ * care whether the particles live in one Simulation or are split across
+ * tiles. Viewers do not get at the particle columns: they pull a
+ * ParticleSample, a down-sampled copy of what to draw, which stays small
+ * however large the world behind it is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "ParticleStore.hpp"
+#include "Span.hpp"
+
+struct SimulationStats;
+
+/**
+ * @struct ParticleSample
+ * @brief Down-sampled particles for display: positions, radii and colours only.
+ */
+struct ParticleSample {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> radius;
+    std::vector<Color> color;
+    size_t total = 0;   ///< Particles in the backend the sample was taken from
+
+    void clear() {
+        x.clear();
+        y.clear();
+        radius.clear();
+        color.clear();
+        total = 0;
+    }
+
+    /** @brief Append columns [begin, end) of store, every stride-th one. */
+    void take(const ParticleStore& store, size_t begin, size_t end, size_t stride) {
+        for (size_t i = begin; i < end; i += stride) {
+            x.push_back(store.x[i]);
+            y.push_back(store.y[i]);
+            radius.push_back(store.radius[i]);
+            color.push_back(store.color[i]);
+        }
+    }
+
+    ParticleView view() const {
+        ParticleView v;
+        v.x = x;
+        v.y = y;
+        v.radius = radius;
+        v.color = color;
+        return v;
+    }
+};
+
+/**
+ * @class SimulationBackend
+ * @brief Something that steps a world of particles.
+ */
+class SimulationBackend {
+public:
+    virtual ~SimulationBackend() = default;
+
+    /** @brief Advance the world by dt seconds. */
+    virtual void step(float dt) = 0;
+    /** @brief Add particles; each goes wherever its position says it belongs. */
+    virtual void spawnBatch(Span<const Particle> batch) = 0;
+    /** @brief Particles in the world. */
+    virtual size_t particleCount() const = 0;
+    /** @brief Counters from the most recent step(), summed over the whole world. */
+    virtual SimulationStats stepStats() const = 0;
+    /**
+     * @brief Fill out with at most maxParticles particles (0 = all), evenly thinned.
+     *
+     * Every k-th particle is taken (k the smallest stride that fits), so a
+     * sample of a large world is a uniform subset rather than one corner.
+     */
+    virtual void sample(ParticleSample& out, size_t maxParticles) const = 0;
+    /** @brief Threads step() runs on. */
+    virtual int threadCount() const = 0;
+    /** @brief Bytes of particle storage, including reserved capacity. */
+    virtual size_t memoryBytes() const = 0;
+
+    /** @brief Smallest stride that thins count particles to at most maxParticles. */
+    static size_t sampleStride(size_t count, size_t maxParticles) {
+        return (maxParticles == 0 || count <= maxParticles) ? 1 : (count + maxParticles - 1) / maxParticles;
+    }
+};
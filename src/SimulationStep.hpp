@@ -0,0 +1,192 @@
+/**
+ * @file SimulationStep.hpp
+ * @brief Per-particle step kernels specialized at compile time on the enabled features.
+ *
+ * The integrate and settle passes of Simulation::update() used to test drag,
+ * sleeping, trails and the gravity-dependent speed clamp for every particle.
+ * Here each pass is a template over a StepPolicy, so every combination
+ * compiles to its own loop with the disabled features removed. Simulation
+ * builds a table of all combinations and picks one entry per step;
+ * header-only code that knows its configuration can call a kernel with a
+ * fixed policy directly and pay nothing for the features it leaves out.
+ *
+ * Gravity and the collision broadphase are already chosen once per step as
+ * whole passes, so they are not policy parameters beyond the clamp that
+ * gravity turns off.
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "ParticleStore.hpp"
+
+/// Raw column pointers for the hot loops
+struct ParticleColumns {
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    const float* r;
+    uint8_t* rest;   ///< Resting steps per particle; null when sleeping is off
+};
+
+/** Scalar inputs shared by the step kernels. */
+struct StepParams {
+    float dt = 0.0f;
+    float drag = 0.0f;         ///< Velocity damping per second (only read with StepPolicy::drag)
+    float restitution = 0.9f;  ///< Wall bounce
+    float worldW = 0.0f;
+    float worldH = 0.0f;
+    float tinySpeed = 0.5f;    ///< Slower particles are stopped (without StepPolicy::gravity)
+    float sleepSpeed = 0.5f;   ///< Slower particles count as resting (StepPolicy::sleep)
+    uint8_t sleepSteps = 60;   ///< Resting steps before a particle sleeps (StepPolicy::sleep)
+};
+
+/** What one settleRange() call saw; summed over the chunks of a step. */
+struct SettleTotals {
+    size_t sleepers = 0;   ///< Particles asleep after the step
+    uint64_t wallHits = 0; ///< Wall bounces
+    double kinetic = 0.0;  ///< Sum of r²·|v|²/2 after the step (collision mass units)
+};
+
+/**
+ * @struct StepPolicy
+ * @brief Compile-time feature set of one step.
+ */
+template <bool Trails, bool Drag, bool Gravity, bool Sleep>
+struct StepPolicy {
+    static constexpr bool trails = Trails;    ///< Record trail history after integrating
+    static constexpr bool drag = Drag;        ///< Damp velocities by StepParams::drag
+    static constexpr bool gravity = Gravity;  ///< A force acts on resting particles, so no tiny-speed clamp
+    static constexpr bool sleep = Sleep;      ///< ParticleColumns::rest is kept (must be non-null)
+
+    /** Position of this policy in a table indexed by feature bits. */
+    static constexpr int index = (Trails ? 1 : 0) | (Drag ? 2 : 0) | (Gravity ? 4 : 0) | (Sleep ? 8 : 0);
+};
+
+/** Number of StepPolicy combinations. */
+constexpr int STEP_POLICY_COUNT = 16;
+
+/**
+ * @brief Move particles [begin, end) by their velocity (sleepers stay put) and record trails.
+ */
+template <class Policy>
+void integrateRange(const ParticleColumns& c, TrailBuffer& trails, const StepParams& p,
+                    size_t begin, size_t end) {
+    const float dt = p.dt;
+    if (!Policy::sleep) {
+        for (size_t i = begin; i < end; ++i) {
+            c.x[i] += c.vx[i] * dt;
+            c.y[i] += c.vy[i] * dt;
+        }
+        if (Policy::trails) trails.record(c.x, c.y, begin, end);
+        return;
+    }
+    // Sleepers stay put; their trails have long since collapsed to a point
+    for (size_t i = begin; i < end; ++i) {
+        if (c.rest[i] >= p.sleepSteps) continue;
+        c.x[i] += c.vx[i] * dt;
+        c.y[i] += c.vy[i] * dt;
+        if (Policy::trails) trails.record(c.x, c.y, i, i + 1);
+    }
+}
+
+/**
+ * @brief Drag, wall bounces, the tiny-speed clamp and rest counting for particles [begin, end).
+ * @return Sleepers, wall hits and kinetic energy of the range after the step
+ */
+template <class Policy>
+SettleTotals settleRange(const ParticleColumns& c, const StepParams& p, size_t begin, size_t end) {
+    const float damping = 1.0f - p.drag * p.dt;
+    size_t sleepers = 0;
+    uint64_t wallHits = 0;
+    double kinetic = 0.0;  // One call may cover every particle (serial step), so not float
+    for (size_t i = begin; i < end; ++i) {
+        if (Policy::sleep && c.rest[i] >= p.sleepSteps) {
+            c.vx[i] = 0;  // Drop any well pull picked up while asleep
+            c.vy[i] = 0;
+            ++sleepers;
+            continue;
+        }
+
+        if (Policy::drag) {
+            c.vx[i] *= damping;
+            c.vy[i] *= damping;
+        }
+
+        const float r = c.r[i];
+
+        // Wall collision detection and response
+        if (c.x[i] - r < 0) {
+            c.x[i] = r;
+            c.vx[i] = std::abs(c.vx[i]) * p.restitution;
+            ++wallHits;
+        }
+        if (c.x[i] + r > p.worldW) {
+            c.x[i] = p.worldW - r;
+            c.vx[i] = -std::abs(c.vx[i]) * p.restitution;
+            ++wallHits;
+        }
+        if (c.y[i] - r < 0) {
+            c.y[i] = r;
+            c.vy[i] = std::abs(c.vy[i]) * p.restitution;
+            ++wallHits;
+        }
+        if (c.y[i] + r > p.worldH) {
+            c.y[i] = p.worldH - r;
+            c.vy[i] = -std::abs(c.vy[i]) * p.restitution;
+            ++wallHits;
+        }
+
+        // Stop particles that are moving too slowly (prevents jitter), unless
+        // gravity is there to pull stationary particles
+        const float speedSq = c.vx[i] * c.vx[i] + c.vy[i] * c.vy[i];
+        if (!Policy::gravity && speedSq < p.tinySpeed * p.tinySpeed) {
+            c.vx[i] = 0;
+            c.vy[i] = 0;
+        } else {
+            kinetic += 0.5 * (double)(r * r * speedSq);
+        }
+
+        // Count resting steps; after sleepSteps in a row the particle sleeps
+        if (Policy::sleep) {
+            if (speedSq >= p.sleepSpeed * p.sleepSpeed) {
+                c.rest[i] = 0;
+            } else if (++c.rest[i] >= p.sleepSteps) {
+                c.vx[i] = 0;
+                c.vy[i] = 0;
+                ++sleepers;
+            }
+        }
+    }
+    return SettleTotals{ sleepers, wallHits, kinetic };
+}
+
+/** One table entry: both kernels for one policy. */
+struct StepKernels {
+    void (*integrate)(const ParticleColumns&, TrailBuffer&, const StepParams&, size_t, size_t);
+    SettleTotals (*settle)(const ParticleColumns&, const StepParams&, size_t, size_t);
+};
+
+/** The StepPolicy whose index is Bits. */
+template <int Bits>
+using StepPolicyOf = StepPolicy<(Bits & 1) != 0, (Bits & 2) != 0, (Bits & 4) != 0, (Bits & 8) != 0>;
+
+/** @brief Kernels of every policy, in index order. */
+template <int... Bits>
+constexpr std::array<StepKernels, sizeof...(Bits)> makeStepKernelTable(std::integer_sequence<int, Bits...>) {
+    return {{ { &integrateRange<StepPolicyOf<Bits>>, &settleRange<StepPolicyOf<Bits>> }... }};
+}
+
+/**
+ * @brief Kernels for the given feature set: one lookup in a table built at compile time.
+ */
+inline const StepKernels& stepKernels(bool trails, bool drag, bool gravity, bool sleep) {
+    static constexpr std::array<StepKernels, STEP_POLICY_COUNT> table =
+        makeStepKernelTable(std::make_integer_sequence<int, STEP_POLICY_COUNT>());
+    return table[(trails ? 1 : 0) | (drag ? 2 : 0) | (gravity ? 4 : 0) | (sleep ? 8 : 0)];
+}
@@ -0,0 +1,158 @@
+/**
+ * @file SimulationThread.cpp
+ * @brief Implementation of the background fixed-timestep simulation loop.
+ */
+
+#include "SimulationThread.hpp"
+#include "Simulation.hpp"
+#include "Recorder.hpp"
+#include <algorithm>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /// Steps per loop iteration before the backlog is dropped (keeps a slow step from snowballing)
+    const int MAX_STEPS_PER_TICK = 8;
+    /// Wall time one iteration may spend catching up; fewer steps fit as they get slower
+    const float STEP_BUDGET_SECONDS = 1.0f / 30.0f;
+
+    /// Copy the parts of a TrailBuffer the renderer reads, reusing to's storage
+    void copyRings(TrailBuffer& to, const TrailBuffer& from) {
+        to.ringOf = from.ringOf;
+        to.points = from.points;
+        to.length = from.length;
+        to.head = from.head;
+        to.capacity = from.capacity;
+    }
+}
+
+SimulationThread::SimulationThread(Simulation& sim, float stepSeconds)
+    : sim_(sim), stepSeconds_(stepSeconds), scheduler_(stepSeconds, MAX_STEPS_PER_TICK) {
+    scheduler_.setFrameRate(1.0f / stepSeconds);
+    scheduler_.setStepBudget(STEP_BUDGET_SECONDS);
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running_.exchange(true)) return;
+    steppedAt_ = Clock::now();
+    publish();  // Give the renderer something to draw straight away
+    thread_ = std::thread(&SimulationThread::loop, this);
+}
+
+void SimulationThread::stop() {
+    if (!running_.exchange(false)) return;
+    thread_.join();
+    drainCommands();  // Leave the Simulation with every posted change applied
+}
+
+void SimulationThread::post(Command cmd) {
+    std::lock_guard<std::mutex> lock(commandMutex_);
+    commands_.push_back(std::move(cmd));
+}
+
+bool SimulationThread::drainCommands() {
+    {
+        std::lock_guard<std::mutex> lock(commandMutex_);
+        pending_.swap(commands_);
+    }
+    if (pending_.empty()) return false;
+    for (Command& cmd : pending_)
+        cmd(sim_);
+    pending_.clear();
+    return true;
+}
+
+void SimulationThread::rememberPositions() {
+    stepX_ = sim_.particles.x;
+    stepY_ = sim_.particles.y;
+    stepLayout_ = sim_.particles.layoutVersion;
+}
+
+void SimulationThread::publish() {
+    SimSnapshot& snap = snapshots_.back();
+    const ParticleStore& ps = sim_.particles;
+    const size_t n = ps.size();
+    snap.x = ps.x;
+    snap.y = ps.y;
+    snap.radius = ps.radius;
+    snap.color = ps.color;
+    if (sim_.trails) {
+        copyRings(snap.trails, ps.trails);
+    } else {
+        snap.trails.clear();
+    }
+
+    // The positions from before the last step while indices still refer to
+    // the same particles. Particles added since then start where they are;
+    // after a reorder or removal each one is stepped back along its velocity.
+    snap.prevX.resize(n);
+    snap.prevY.resize(n);
+    const bool sameLayout = stepLayout_ == ps.layoutVersion;
+    const size_t kept = sameLayout ? std::min(n, stepX_.size()) : 0;
+    std::copy(stepX_.begin(), stepX_.begin() + kept, snap.prevX.begin());
+    std::copy(stepY_.begin(), stepY_.begin() + kept, snap.prevY.begin());
+    const float back = sameLayout ? 0.0f : stepSeconds_;
+    for (size_t i = kept; i < n; ++i) {
+        snap.prevX[i] = ps.x[i] - ps.vx[i] * back;
+        snap.prevY[i] = ps.y[i] - ps.vy[i] * back;
+    }
+
+    snap.wells = sim_.gravityWells;
+    snap.step = steps_;
+    snap.steppedAt = steppedAt_;  // A publish for commands alone keeps the step's timing
+    snapshots_.publish();
+}
+
+void SimulationThread::loop() {
+    scheduler_.tick();
+    scheduler_.discard();  // Time spent before the thread started is not owed
+
+    while (running_.load(std::memory_order_relaxed)) {
+        bool changed = drainCommands();
+
+        scheduler_.tick();
+        if (paused_.load(std::memory_order_relaxed)) {
+            scheduler_.discard();
+        } else if (const int steps = scheduler_.stepsDue()) {
+            const Clock::time_point start = Clock::now();
+            for (int s = 0; s < steps; ++s) {
+                if (s == steps - 1) rememberPositions();  // Only the last step is blended
+                sim_.update(stepSeconds_);
+                ++steps_;
+                if (recorder_) recorder_->push(sim_, steps_, stepSeconds_);
+            }
+            steppedAt_ = Clock::now();
+            scheduler_.stepsDone(steps, std::chrono::duration<double>(steppedAt_ - start).count());
+            changed = true;
+        }
+
+        if (changed) publish();
+        scheduler_.pace();  // Wake for the next step
+    }
+}
+
+ParticleView SimulationThread::interpolatedParticles() {
+    snapshots_.acquire();
+    const SimSnapshot& snap = snapshots_.front();
+    const size_t n = snap.x.size();
+    float alpha = std::chrono::duration<float>(Clock::now() - snap.steppedAt).count() / stepSeconds_;
+    alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+
+    lerpX_.resize(n);
+    lerpY_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        lerpX_[i] = snap.prevX[i] + (snap.x[i] - snap.prevX[i]) * alpha;
+        lerpY_[i] = snap.prevY[i] + (snap.y[i] - snap.prevY[i]) * alpha;
+    }
+
+    ParticleView v;
+    v.x = lerpX_;
+    v.y = lerpY_;
+    v.radius = snap.radius;
+    v.color = snap.color;
+    return v;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file SimulationThread.hpp
+ * @brief Runs a Simulation on its own thread and hands snapshots to the renderer.
+ *
+ * The simulation thread steps at a fixed rate from a FrameScheduler and
+ * publishes each result through a lock-free triple buffer. The render
+ * thread picks up the newest snapshot whenever it draws and interpolates
+ * positions between the last two steps, so neither side waits for the
+ * other. Both steps are in the one snapshot, so publishes the renderer
+ * never saw do not change how far a frame moves.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ParticleStore.hpp"
+#include "GravityWell.hpp"
+#include "FrameScheduler.hpp"
+
+struct Simulation;
+class Recorder;
+
+/**
+ * @struct SimSnapshot
+ * @brief Everything the renderer needs from one simulation step.
+ *
+ * Only the columns that are drawn are copied, not the whole ParticleStore:
+ * no velocities or slot map, and the trail rings only while the simulation
+ * records trails.
+ */
+struct SimSnapshot {
+    std::vector<float> x, y;                ///< Positions after the newest step
+    std::vector<float> prevX, prevY;        ///< Positions of the same particles one step earlier
+    std::vector<float> radius;
+    std::vector<Color> color;
+    TrailBuffer trails;                     ///< Rings and samples only (empty with trails off)
+    std::vector<GravityWell> wells;         ///< Copy of the gravity wells
+    uint64_t step = 0;                      ///< Steps taken when the snapshot was made
+    std::chrono::steady_clock::time_point steppedAt;  ///< Wall-clock end of the newest step
+};
+
+/**
+ * @class SnapshotBuffer
+ * @brief Single-producer / single-consumer triple buffer of SimSnapshot.
+ *
+ * The writer fills back() and publish()es it; the reader acquire()s the
+ * newest published slot into front(). Neither call blocks, and slots are
+ * reused so steady-state copies do not allocate.
+ */
+class SnapshotBuffer {
+public:
+    /// Writer: slot to fill next
+    SimSnapshot& back() { return slots_[back_]; }
+    /// Writer: make back() the newest snapshot
+    void publish() { back_ = ready_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK; }
+
+    /// Reader: true if a snapshot newer than front() is waiting
+    bool hasFresh() const { return (ready_.load(std::memory_order_acquire) & FRESH) != 0; }
+    /// Reader: swap the newest snapshot into front(); false if there was none
+    bool acquire() {
+        if (!hasFresh()) return false;
+        front_ = ready_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    /// Reader: snapshot currently owned by the render side
+    const SimSnapshot& front() const { return slots_[front_]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH = 4;
+
+    SimSnapshot slots_[3];
+    std::atomic<int> ready_{1};  ///< Middle slot index, FRESH bit set once published
+    int back_ = 0;               ///< Owned by the writer
+    int front_ = 2;              ///< Owned by the reader
+};
+
+/**
+ * @class SimulationThread
+ * @brief Fixed-timestep simulation loop on a background thread.
+ *
+ * While running, the Simulation must only be touched through post(); the
+ * commands run on the simulation thread between steps.
+ */
+class SimulationThread {
+public:
+    using Command = std::function<void(Simulation&)>;
+
+    /**
+     * @param sim Simulation to drive (must outlive this object)
+     * @param stepSeconds Fixed timestep fed to Simulation::update
+     */
+    SimulationThread(Simulation& sim, float stepSeconds);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    /** @brief Queue a mutation to run on the simulation thread before its next step. */
+    void post(Command cmd);
+    /** @brief Record every step to recorder (set before start(); nullptr to stop). */
+    void setRecorder(Recorder* recorder) { recorder_ = recorder; }
+    /** @brief Pause or resume stepping (commands still apply while paused). */
+    void setPaused(bool paused) { paused_.store(paused, std::memory_order_relaxed); }
+
+    /**
+     * @brief Render thread: pick up the newest snapshot and interpolate for the current time.
+     *
+     * Positions are blended from the step before the newest snapshot's to
+     * its own over the step interval after it, so motion stays smooth
+     * whatever the display rate. The returned views stay valid until the
+     * next call.
+     */
+    ParticleView interpolatedParticles();
+    /** @brief Trails of the newest snapshot (valid until the next interpolatedParticles()). */
+    TrailView trails() const { return snapshots_.front().trails.view(); }
+    /** @brief Wells of the newest snapshot (valid until the next interpolatedParticles()). */
+    const std::vector<GravityWell>& wells() const { return snapshots_.front().wells; }
+
+private:
+    void loop();
+    bool drainCommands();
+    void publish();
+    void rememberPositions();
+
+    Simulation& sim_;
+    const float stepSeconds_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> paused_{false};
+    FrameScheduler scheduler_;          ///< Step accumulator and wake-up pacing (simulation thread only)
+    uint64_t steps_ = 0;
+    Recorder* recorder_ = nullptr;      ///< Optional trajectory sink, fed after each step
+
+    std::mutex commandMutex_;
+    std::vector<Command> commands_;     ///< Guarded by commandMutex_
+    std::vector<Command> pending_;      ///< Simulation-thread copy being executed
+
+    // Simulation-thread state for the snapshots' previous positions
+    std::vector<float> stepX_, stepY_;  ///< Positions before the newest step
+    uint32_t stepLayout_ = ~0u;         ///< particles.layoutVersion stepX_ was taken at
+    std::chrono::steady_clock::time_point steppedAt_;  ///< End of the newest step
+
+    SnapshotBuffer snapshots_;
+
+    std::vector<float> lerpX_, lerpY_;  ///< Render thread: interpolated positions handed to the renderer
+};
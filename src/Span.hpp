@@ -0,0 +1,37 @@
+/**
+ * @file Span.hpp
+ * @brief Minimal non-owning view over a contiguous array (C++17 stand-in for std::span).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct Span
+ * @brief Pointer + length pair; does not own or copy the elements.
+ *
+ * Lets hot loops and the renderer read particle columns without knowing
+ * which container holds them.
+ */
+template <typename T>
+struct Span {
+    T* ptr = nullptr;
+    size_t count = 0;
+
+    Span() = default;
+    Span(T* p, size_t n) : ptr(p), count(n) {}
+    /// View a whole vector (const or mutable, depending on T)
+    template <typename U>
+    Span(std::vector<U>& v) : ptr(v.data()), count(v.size()) {}
+    template <typename U>
+    Span(const std::vector<U>& v) : ptr(v.data()), count(v.size()) {}
+
+    T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return ptr[i]; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + count; }
+};
@@ -0,0 +1,91 @@
+/**
+ * @file StreamBuffer.cpp
+ * @brief Implementation of the fenced frame-ring upload buffer.
+ */
+
+#include "StreamBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__APPLE__)
+#define GL_SILENCE_DEPRECATION 1  // Silence macOS OpenGL deprecation warnings
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES 1  // Declare GL 3.x entry points (exported by libGL on Linux)
+#include <GL/gl.h>
+#endif
+
+namespace {
+    /** Allocations start on this boundary (vertex attribute alignment) */
+    const size_t ALIGNMENT = 16;
+    /** Longest wait for the GPU to release a region before writing anyway (ns) */
+    const GLuint64 FENCE_TIMEOUT_NS = 1000000000ull;
+}
+
+StreamBuffer::~StreamBuffer() {
+    release();
+}
+
+void StreamBuffer::release() {
+    if (!buffer_) return;
+    for (void*& fence : fences_) {
+        if (fence) glDeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+}
+
+void StreamBuffer::init(size_t bytesPerFrame) {
+    glGenBuffers(1, &buffer_);
+    grow(bytesPerFrame);
+}
+
+void StreamBuffer::grow(size_t bytesPerFrame) {
+    // New storage for the same name: draws already issued keep the old one
+    for (void*& fence : fences_) {
+        if (fence) glDeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+    regionBytes_ = (bytesPerFrame + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(regionBytes_ * FRAMES), nullptr, GL_STREAM_DRAW);
+    region_ = 0;
+    used_ = 0;
+}
+
+void StreamBuffer::nextFrame() {
+    if (used_ > 0)
+        fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region_ = (region_ + 1) % FRAMES;
+    used_ = 0;
+    if (void* fence = fences_[region_]) {
+        glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(static_cast<GLsync>(fence));
+        fences_[region_] = nullptr;
+    }
+}
+
+size_t StreamBuffer::upload(const void* data, size_t bytes) {
+    const size_t start = (used_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (start + bytes > regionBytes_) {
+        // Room for the whole frame so far plus this upload, with headroom
+        grow(std::max(2 * regionBytes_, 2 * (start + bytes)));
+        return upload(data, bytes);
+    }
+    const size_t offset = (size_t)region_ * regionBytes_ + start;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    if (bytes > 0) {
+        // The fence in nextFrame() already guarantees the GPU is done with this range
+        void* dst = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst) {
+            std::memcpy(dst, data, bytes);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes, data);
+        }
+    }
+    used_ = start + bytes;
+    return offset;
+}
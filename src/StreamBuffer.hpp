@@ -0,0 +1,62 @@
+/**
+ * @file StreamBuffer.hpp
+ * @brief Frame-ring allocator for per-frame vertex data (OpenGL).
+ *
+ * One vertex buffer is split into FRAMES regions. Each frame writes into
+ * its own region through an unsynchronized glMapBufferRange, so the driver
+ * never has to allocate or wait for the GPU on an upload. A fence placed
+ * after a frame's draws is waited on only when the ring comes back to that
+ * region FRAMES frames later, which the GPU has normally finished by then.
+ * (Persistent mapping would need GL 4.4, which macOS does not have.)
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @class StreamBuffer
+ * @brief Ring of per-frame regions in one GL_ARRAY_BUFFER, guarded by fences.
+ */
+class StreamBuffer {
+public:
+    /** Regions in the ring: frames the CPU may run ahead of the GPU */
+    static constexpr int FRAMES = 3;
+
+    StreamBuffer() = default;
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    /**
+     * @brief Create the buffer (needs a current GL context).
+     * @param bytesPerFrame Initial region size; grows when a frame needs more
+     */
+    void init(size_t bytesPerFrame);
+    /** @brief Delete the buffer and fences while the context is still current (the destructor does too). */
+    void release();
+
+    /**
+     * @brief Fence the region just used and move to the next one, waiting for the GPU if it is still reading it.
+     */
+    void nextFrame();
+
+    /**
+     * @brief Copy bytes into this frame's region.
+     * @return Byte offset of the copy in buffer(), for attribute pointers
+     */
+    size_t upload(const void* data, size_t bytes);
+
+    /** @brief The GL buffer name (bound to GL_ARRAY_BUFFER by upload()). */
+    unsigned int buffer() const { return buffer_; }
+
+private:
+    /** @brief Reallocate with regions of at least bytesPerFrame; drops the current contents. */
+    void grow(size_t bytesPerFrame);
+
+    unsigned int buffer_ = 0;
+    size_t regionBytes_ = 0;       ///< Size of each region
+    size_t used_ = 0;              ///< Bytes written into the current region this frame
+    int region_ = 0;               ///< Region the current frame writes to
+    void* fences_[FRAMES] = {};    ///< GLsync per region, set when its frame ended
+};
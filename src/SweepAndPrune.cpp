@@ -0,0 +1,82 @@
+/**
+ * @file SweepAndPrune.cpp
+ * @brief Implementation of the sort-and-sweep broadphase.
+ */
+
+#include "SweepAndPrune.hpp"
+#include <algorithm>
+
+namespace {
+    inline bool byMinX(const SweepAndPrune::Entry& a, const SweepAndPrune::Entry& b) {
+        return a.minX < b.minX;
+    }
+}
+
+void SweepAndPrune::update(const float* x, const float* y, const float* r, size_t n, uint32_t layout) {
+    // Indices moved (removals, clear, bulk assign): the old order means nothing
+    if (layout != layoutVersion || entries.size() > n) {
+        entries.clear();
+        layoutVersion = layout;
+    }
+
+    // Refresh the existing boxes in their old order
+    for (Entry& e : entries) {
+        const int i = e.index;
+        e.minX = x[i] - r[i];
+        e.maxX = x[i] + r[i];
+        e.minY = y[i] - r[i];
+        e.maxY = y[i] + r[i];
+    }
+
+    // Insertion sort: each box only moves past the few it overtook since last step
+    moves = 0;
+    for (size_t k = 1; k < entries.size(); ++k) {
+        if (entries[k - 1].minX <= entries[k].minX) continue;
+        const Entry e = entries[k];
+        size_t j = k;
+        for (; j > 0 && entries[j - 1].minX > e.minX; --j)
+            entries[j] = entries[j - 1];
+        entries[j] = e;
+        moves += k - j;
+    }
+
+    // Particles added since the last update: sort them on their own and merge
+    const size_t old = entries.size();
+    for (size_t i = old; i < n; ++i)
+        entries.push_back(Entry{ x[i] - r[i], x[i] + r[i], y[i] - r[i], y[i] + r[i], (int)i });
+    if (entries.size() > old) {
+        std::sort(entries.begin() + old, entries.end(), byMinX);
+        std::inplace_merge(entries.begin(), entries.begin() + old, entries.end(), byMinX);
+    }
+
+    // Sweep: everything starting before a box ends overlaps it in x. The
+    // inner loop runs over plain float columns copied out in sweep order.
+    const size_t count = entries.size();
+    minX.resize(count);
+    minY.resize(count);
+    maxY.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        minX[k] = entries[k].minX;
+        minY[k] = entries[k].minY;
+        maxY[k] = entries[k].maxY;
+    }
+    pairs.clear();
+    for (size_t a = 0; a < count; ++a) {
+        const float right = entries[a].maxX, top = minY[a], bottom = maxY[a];
+        for (size_t b = a + 1; b < count && minX[b] <= right; ++b) {
+            if (minY[b] <= bottom && maxY[b] >= top)
+                pairs.emplace_back(entries[a].index, entries[b].index);
+        }
+    }
+}
+
+void SweepAndPrune::renumber(const uint32_t* newIndex, size_t n, uint32_t oldLayout, uint32_t layout) {
+    const bool stale = layoutVersion != oldLayout || entries.size() != n;
+    layoutVersion = layout;
+    if (stale) {
+        entries.clear();  // Stale or missing appended particles: the next update() re-sorts
+        return;
+    }
+    for (Entry& e : entries)
+        e.index = (int)newIndex[e.index];
+}
@@ -0,0 +1,65 @@
+/**
+ * @file SweepAndPrune.hpp
+ * @brief Sort-and-sweep broadphase along x, kept sorted from step to step.
+ *
+ * Every particle's bounding box is kept in a list ordered by its left edge.
+ * Particles move little between steps, so re-sorting last step's order
+ * with insertion sort is close to O(n). The sweep then pairs each box with
+ * the boxes after it whose left edge is not past its right edge, and keeps
+ * the pairs that also overlap in y. Nothing depends on a cell size, so
+ * scenes mixing very small and very large particles do not pay for the
+ * largest radius everywhere, as the uniform grid does.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct SweepAndPrune
+ * @brief Persistent x-sorted box list and the overlapping pairs found in it.
+ *
+ * Buffers are kept between updates so steady-state steps do not allocate.
+ */
+struct SweepAndPrune {
+    /** One particle's box, in sweep order. */
+    struct Entry {
+        float minX;  ///< Left edge (x - r), the sort key
+        float maxX;
+        float minY;
+        float maxY;
+        int index;   ///< Particle index
+    };
+
+    std::vector<Entry> entries;              ///< Sorted by minX after update()
+    std::vector<std::pair<int, int>> pairs;  ///< Particle pairs whose boxes overlap
+    uint32_t layoutVersion = 0;              ///< ParticleStore::layoutVersion the order was built for
+    size_t moves = 0;                        ///< Insertion-sort shifts in the last update (0 when coherent)
+    std::vector<float> minX, minY, maxY;     ///< Sweep-order copies for the inner loop (scratch)
+
+    /**
+     * @brief Refresh the boxes, restore the order and collect overlapping pairs.
+     * @param x, y, r Particle columns
+     * @param n Number of particles
+     * @param layout The store's current layoutVersion
+     *
+     * If the layout changed (indices no longer name the same particles) the
+     * order is rebuilt with a full sort. Appended particles are sorted
+     * among themselves and merged in.
+     */
+    void update(const float* x, const float* y, const float* r, size_t n, uint32_t layout);
+
+    /**
+     * @brief Follow a reordering of the particles without losing the sort.
+     * @param newIndex newIndex[old] = column the particle moved to
+     * @param n Number of particles
+     * @param oldLayout, layout The store's layoutVersion before and after the reorder
+     *
+     * If the order did not cover exactly these n particles, it is dropped
+     * and the next update() sorts from scratch.
+     */
+    void renumber(const uint32_t* newIndex, size_t n, uint32_t oldLayout, uint32_t layout);
+};
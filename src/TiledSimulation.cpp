@@ -0,0 +1,347 @@
+/**
+ * @file TiledSimulation.cpp
+ * @brief Implementation of the tiled domain decomposition.
+ */
+
+#include "TiledSimulation.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    /// Headroom on the automatic halo for speed picked up during the step (wells, collisions)
+    const float HALO_SLACK = 1.25f;
+
+    /// Every setting of from except its particles, its threads and N-body mode
+    void copySettings(const Simulation& from, Simulation& to) {
+        to.worldW = from.worldW;
+        to.worldH = from.worldH;
+        to.restitution = from.restitution;
+        to.drag = from.drag;
+        to.collisionMode = from.collisionMode;
+        to.sleeping = from.sleeping;
+        to.continuousCollisions = from.continuousCollisions;
+        to.spatialReorder = from.spatialReorder;
+        to.trails = from.trails;
+        to.trailLength = from.trailLength;
+        to.trailSpacing = from.trailSpacing;
+        to.trailMin = from.trailMin;
+        to.trailMax = from.trailMax;
+        to.wellPull = from.wellPull;
+        to.wellRange = from.wellRange;
+        to.nbody = false;
+        to.gravityWells = from.gravityWells;
+    }
+
+    int directionOf(int dx, int dy) {
+        return (dy + 1) * 3 + (dx + 1);
+    }
+
+    const uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+    void encodeParticles(const std::vector<Particle>& ps, uint8_t* out) {
+        for (const Particle& p : ps) {
+            const float v[9] = { p.pos.x, p.pos.y, p.vel.x, p.vel.y, p.radius,
+                                 p.color.r, p.color.g, p.color.b, p.color.a };
+            std::memcpy(out, v, sizeof(v));
+            out += sizeof(v);
+        }
+    }
+
+    const uint8_t* decodeParticles(const uint8_t* in, size_t count, std::vector<Particle>& out) {
+        for (size_t i = 0; i < count; ++i) {
+            float v[9];
+            std::memcpy(v, in, sizeof(v));
+            in += sizeof(v);
+            out.emplace_back(Vec2(v[0], v[1]), Vec2(v[2], v[3]), v[4], Color(v[5], v[6], v[7], v[8]));
+        }
+        return in;
+    }
+}
+
+void encodeTileMessage(const TileMessage& msg, std::vector<uint8_t>& out) {
+    const size_t ghosts = msg.ghosts.size(), migrants = msg.migrants.size();
+    out.resize(sizeof(TileMessageHeader) + ghosts * (TILE_MESSAGE_PARTICLE_BYTES + 1)
+               + migrants * TILE_MESSAGE_PARTICLE_BYTES);
+    const TileMessageHeader header{ TILE_MESSAGE_TAG, BYTE_ORDER_MARK, (uint32_t)ghosts, (uint32_t)migrants };
+    uint8_t* p = out.data();
+    std::memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    encodeParticles(msg.ghosts, p);
+    p += ghosts * TILE_MESSAGE_PARTICLE_BYTES;
+    if (ghosts > 0) std::memcpy(p, msg.ghostAsleep.data(), ghosts);
+    p += ghosts;
+    encodeParticles(msg.migrants, p);
+}
+
+bool decodeTileMessage(const uint8_t* data, size_t size, TileMessage& out) {
+    TileMessageHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.tag != TILE_MESSAGE_TAG || header.byteOrder != BYTE_ORDER_MARK) return false;
+    const size_t ghosts = header.ghosts, migrants = header.migrants;
+    if (size != sizeof(header) + ghosts * (TILE_MESSAGE_PARTICLE_BYTES + 1) + migrants * TILE_MESSAGE_PARTICLE_BYTES)
+        return false;
+
+    const uint8_t* p = decodeParticles(data + sizeof(header), ghosts, out.ghosts);
+    out.ghostAsleep.insert(out.ghostAsleep.end(), p, p + ghosts);
+    decodeParticles(p + ghosts, migrants, out.migrants);
+    return true;
+}
+
+TiledSimulation::TiledSimulation(float worldW, float worldH, int tilesX, int tilesY)
+    : worldW_(worldW), worldH_(worldH),
+      tilesX_(std::max(tilesX, 1)), tilesY_(std::max(tilesY, 1)),
+      tileW_(worldW / (float)tilesX_), tileH_(worldH / (float)tilesY_) {
+    tiles_.reserve((size_t)tilesX_ * tilesY_);
+    for (int ty = 0; ty < tilesY_; ++ty) {
+        for (int tx = 0; tx < tilesX_; ++tx) {
+            auto t = std::make_unique<Tile>();
+            t->tx = tx;
+            t->ty = ty;
+            t->sim.worldW = worldW_;
+            t->sim.worldH = worldH_;
+            tiles_.push_back(std::move(t));
+        }
+    }
+    placeTiles();
+}
+
+void TiledSimulation::placeTiles() {
+    tileW_ = worldW_ / (float)tilesX_;
+    tileH_ = worldH_ / (float)tilesY_;
+    for (auto& t : tiles_) {
+        t->min = Vec2(t->tx * tileW_, t->ty * tileH_);
+        // The last row and column run past the world edge, whatever rounding says
+        t->max = Vec2(t->tx + 1 == tilesX_ ? INFINITY : (t->tx + 1) * tileW_,
+                      t->ty + 1 == tilesY_ ? INFINITY : (t->ty + 1) * tileH_);
+    }
+}
+
+void TiledSimulation::setThreadCount(int count) {
+    jobs_.reset();
+    if (count == 1) return;
+    jobs_ = std::make_unique<JobSystem>(count);
+    if (jobs_->threadCount() == 1) jobs_.reset();
+}
+
+template <class Fn>
+void TiledSimulation::forEachTile(const Fn& fn) {
+    const JobSystem::RangeFn body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            fn((int)(i % (size_t)tilesX_), (int)(i / (size_t)tilesX_));
+    };
+    if (jobs_)
+        jobs_->parallelFor(tiles_.size(), 1, body);
+    else
+        body(0, tiles_.size());
+}
+
+int TiledSimulation::columnOf(float x) const {
+    return std::min(std::max((int)std::floor(x / tileW_), 0), tilesX_ - 1);
+}
+
+int TiledSimulation::rowOf(float y) const {
+    return std::min(std::max((int)std::floor(y / tileH_), 0), tilesY_ - 1);
+}
+
+void TiledSimulation::load(const Simulation& source) {
+    if (source.nbody)
+        std::fprintf(stderr, "TiledSimulation: N-body gravity is not decomposed; using the well pull\n");
+    for (auto& t : tiles_) {
+        t->sim.clear();
+        copySettings(source, t->sim);
+    }
+    worldW_ = source.worldW;
+    worldH_ = source.worldH;
+    placeTiles();
+
+    std::vector<Particle> all(source.particles.size());
+    for (size_t i = 0; i < all.size(); ++i)
+        all[i] = source.particles.get(i);
+    spawnBatch(all);
+}
+
+void TiledSimulation::spawnBatch(Span<const Particle> batch) {
+    for (auto& t : tiles_)
+        t->inbox.clear();
+    for (const Particle& p : batch)
+        tiles_[indexOf(columnOf(p.pos.x), rowOf(p.pos.y))]->inbox.migrants.push_back(p);
+    for (auto& t : tiles_)
+        t->sim.spawnBatch(t->inbox.migrants);
+}
+
+float TiledSimulation::haloFor(float dt) {
+    float halo = haloWidth;
+    if (halo <= 0.0f) {
+        float maxRadius = 0.0f, maxSpeedSq = 0.0f;
+        for (const auto& t : tiles_) {
+            const ParticleStore& ps = t->sim.particles;
+            for (size_t i = 0; i < ps.size(); ++i) {
+                maxRadius = std::max(maxRadius, ps.radius[i]);
+                maxSpeedSq = std::max(maxSpeedSq, ps.vx[i] * ps.vx[i] + ps.vy[i] * ps.vy[i]);
+            }
+        }
+        // Two particles on either side of a border, both at full speed toward it
+        halo = HALO_SLACK * (2.0f * maxRadius + 2.0f * std::sqrt(maxSpeedSq) * dt);
+        const float side = std::min(tileW_, tileH_);
+        if (halo > side && !haloCapWarned_) {
+            std::fprintf(stderr, "TiledSimulation: halo %.1f cut to the tile side %.1f; "
+                                 "use fewer tiles to keep every cross-tile contact\n", halo, side);
+            haloCapWarned_ = true;
+        }
+    }
+    return std::min(halo, std::min(tileW_, tileH_));
+}
+
+void TiledSimulation::sendGhosts(Tile& t, float halo) {
+    const ParticleStore& ps = t.sim.particles;
+    const int tx = t.tx, ty = t.ty;
+    // Borders with a neighbour behind them; the band is [edge - halo, edge)
+    const bool hasW = tx > 0, hasE = tx + 1 < tilesX_, hasN = ty > 0, hasS = ty + 1 < tilesY_;
+    for (size_t i = 0; i < ps.size(); ++i) {
+        const float x = ps.x[i], y = ps.y[i];
+        // A halo wider than half the tile puts a particle in both bands of an axis
+        const bool inW = hasW && x < t.min.x + halo, inE = hasE && x >= t.max.x - halo;
+        const bool inN = hasN && y < t.min.y + halo, inS = hasS && y >= t.max.y - halo;
+        if (!inW && !inE && !inN && !inS) continue;
+        const Particle p = ps.get(i);
+        const uint8_t asleep = t.sim.isAsleep(i) ? 1 : 0;
+        // Every neighbour whose band it is in: the sides, and the corner between two of them
+        for (int dy = -1; dy <= 1; ++dy) {
+            if ((dy < 0 && !inN) || (dy > 0 && !inS)) continue;
+            for (int dx = -1; dx <= 1; ++dx) {
+                if ((dx < 0 && !inW) || (dx > 0 && !inE) || (dx == 0 && dy == 0)) continue;
+                TileMessage& msg = t.outbox[directionOf(dx, dy)];
+                msg.ghosts.push_back(p);
+                msg.ghostAsleep.push_back(asleep);
+            }
+        }
+    }
+}
+
+void TiledSimulation::sendMigrants(Tile& t) {
+    const ParticleStore& ps = t.sim.particles;
+    const int tx = t.tx, ty = t.ty;
+    t.handles.clear();
+    for (size_t i = 0; i < ps.size(); ++i) {
+        const int dx = std::min(std::max(columnOf(ps.x[i]) - tx, -1), 1);
+        const int dy = std::min(std::max(rowOf(ps.y[i]) - ty, -1), 1);
+        if (dx == 0 && dy == 0) continue;
+        // Further than one tile: the neighbour passes it on next step
+        t.outbox[directionOf(dx, dy)].migrants.push_back(ps.get(i));
+        t.handles.push_back(ps.handleAt(i));
+    }
+    t.sim.removeParticles(t.handles);
+}
+
+void TiledSimulation::encodeOutbox(Tile& t) {
+    for (int d = 0; d < DIRECTIONS; ++d)
+        encodeTileMessage(t.outbox[d], t.sent[d]);
+}
+
+size_t TiledSimulation::receive(int tx, int ty) {
+    Tile& t = *tiles_[indexOf(tx, ty)];
+    t.inbox.clear();
+    size_t fromLower = 0;
+    // Row-major over the neighbours, so every lower-index tile comes first
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dy == 0 && dx == 0) fromLower = t.inbox.ghosts.size();
+            const int nx = tx + dx, ny = ty + dy;
+            if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= tilesX_ || ny >= tilesY_) continue;
+            // The neighbour filed what it sent us under the direction pointing back at us
+            const std::vector<uint8_t>& bytes = tiles_[indexOf(nx, ny)]->sent[directionOf(-dx, -dy)];
+            if (!decodeTileMessage(bytes.data(), bytes.size(), t.inbox))
+                std::fprintf(stderr, "TiledSimulation: dropped a malformed message to tile %d,%d\n", tx, ty);
+        }
+    }
+    return fromLower;
+}
+
+void TiledSimulation::step(float dt) {
+    ORB_PROFILE_SCOPE("tiles.step");
+    const float halo = haloFor(dt);
+
+    // 1. Halo exchange
+    forEachTile([&](int tx, int ty) {
+        Tile& t = *tiles_[indexOf(tx, ty)];
+        for (TileMessage& msg : t.outbox)
+            msg.clear();
+        sendGhosts(t, halo);
+        encodeOutbox(t);
+    });
+    ghosts_ = 0;
+    for (const auto& t : tiles_)
+        for (const TileMessage& msg : t->outbox)
+            ghosts_ += msg.ghosts.size();
+
+    // 2-3. Step each tile with its ghosts appended, then drop them. A
+    // border pair is counted by the lower-index tile of the two.
+    forEachTile([&](int tx, int ty) {
+        const size_t fromLower = receive(tx, ty);
+        Tile& t = *tiles_[indexOf(tx, ty)];
+        const size_t owned = t.sim.particles.size();
+        t.sim.spawnBatch(t.inbox.ghosts, t.inbox.ghostAsleep);
+        t.sim.setHalo(owned, owned + fromLower);
+        t.sim.update(dt);
+        t.sim.clearHalo();
+        t.sim.truncateParticles(owned);  // The step keeps halo copies at the tail
+    });
+
+    // 4. Migration
+    forEachTile([&](int tx, int ty) {
+        Tile& t = *tiles_[indexOf(tx, ty)];
+        for (TileMessage& msg : t.outbox)
+            msg.clear();
+        sendMigrants(t);
+        encodeOutbox(t);
+    });
+    forEachTile([&](int tx, int ty) {
+        receive(tx, ty);
+        Tile& t = *tiles_[indexOf(tx, ty)];
+        t.sim.spawnBatch(t.inbox.migrants);
+    });
+
+    migrated_ = 0;
+    for (const auto& t : tiles_)
+        for (const TileMessage& msg : t->outbox)
+            migrated_ += msg.migrants.size();
+}
+
+size_t TiledSimulation::particleCount() const {
+    size_t n = 0;
+    for (const auto& t : tiles_)
+        n += t->sim.particles.size();
+    return n;
+}
+
+SimulationStats TiledSimulation::stepStats() const {
+    SimulationStats total;
+    for (const auto& t : tiles_) {
+        total.add(t->sim.stats());
+    }
+    return total;
+}
+
+void TiledSimulation::sample(ParticleSample& out, size_t maxParticles) const {
+    out.clear();
+    out.total = particleCount();
+    const size_t stride = sampleStride(out.total, maxParticles);
+    // One stride across tile boundaries, so the thinning is even over the whole world
+    size_t offset = 0;  // Index of the tile's first particle in the whole world
+    for (const auto& t : tiles_) {
+        const ParticleStore& ps = t->sim.particles;
+        out.take(ps, (stride - offset % stride) % stride, ps.size(), stride);
+        offset += ps.size();
+    }
+}
+
+size_t TiledSimulation::memoryBytes() const {
+    size_t bytes = 0;
+    for (const auto& t : tiles_)
+        bytes += t->sim.particles.memoryBytes();
+    return bytes;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file TiledSimulation.hpp
+ * @brief Spatial domain decomposition: one Simulation per tile, with halos and migration.
+ *
+ * The world is cut into tilesX x tilesY equal tiles. Each tile owns the
+ * particles whose centre lies inside it and steps them with its own
+ * Simulation, in world coordinates (so the outer walls stay where they
+ * are and inner tile borders are not walls). Around a step:
+ *
+ * 1. Halo exchange: every owned particle within haloWidth of a border is
+ *    copied to the neighbour(s) across it. The neighbour appends these
+ *    ghosts after its own particles, so its collision passes see
+ *    everything that can touch its particles this step. A ghost of a
+ *    sleeper arrives asleep, so settled seams stay on the all-asleep
+ *    shortcut.
+ * 2. Each tile steps (tiles run concurrently; each tile is serial).
+ * 3. Ghosts are dropped again, truncated off the tail (the tile's
+ *    Simulation keeps them there, see Simulation::setHalo()). The owned
+ *    particles' sleep state survives.
+ * 4. Migration: owned particles that ended the step outside their tile
+ *    move to the neighbour in that direction.
+ *
+ * Tiles only ever exchange TileMessage batches with their eight
+ * neighbours, and only as bytes: each outbox is encoded with
+ * encodeTileMessage() and the neighbour decodes its copy, so a tile needs
+ * nothing from the rest of the world beyond what such a buffer carries.
+ * The same buffers could be carried between processes or machines, each
+ * holding a few tiles of a world too large for one; here they are handed
+ * over in memory. Both sides of a border pair resolve their copy of the contact; the
+ * results agree up to the order pairs are resolved in. Only the tile with
+ * the lower index counts it, and a tile's counters cover its own particles
+ * only, so stepStats() counts every particle and contact once.
+ *
+ * N-body gravity is not decomposed (each tile would only feel its own
+ * neighbourhood), so load() turns it off; gravity wells are replicated to
+ * every tile.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Simulation.hpp"
+#include "SimulationBackend.hpp"
+#include "JobSystem.hpp"
+
+/** Particles sent from one tile to one neighbour in a step. */
+struct TileMessage {
+    std::vector<Particle> ghosts;        ///< Copies of border particles (dropped after the step)
+    std::vector<uint8_t> ghostAsleep;    ///< Per ghost: asleep in the tile that owns it
+    std::vector<Particle> migrants;      ///< Particles whose ownership moves to the neighbour
+
+    void clear() {
+        ghosts.clear();
+        ghostAsleep.clear();
+        migrants.clear();
+    }
+};
+
+/**
+ * @brief Wire header of an encoded TileMessage (16 bytes).
+ *
+ * Followed by the ghosts, one byte of ghostAsleep per ghost, then the
+ * migrants. A particle is 9 floats: x, y, vx, vy, radius and the RGBA
+ * colour, exact so the receiving tile steps the same values. Fields are in
+ * the sender's byte order, which byteOrder records.
+ */
+struct TileMessageHeader {
+    uint32_t tag;        ///< TILE_MESSAGE_TAG, to detect a buffer that is not a message
+    uint32_t byteOrder;  ///< 0x01020304 as written
+    uint32_t ghosts;
+    uint32_t migrants;
+};
+
+const uint32_t TILE_MESSAGE_TAG = 0x454C4954u;  // "TILE"
+/** Encoded bytes per particle. */
+const size_t TILE_MESSAGE_PARTICLE_BYTES = 9 * sizeof(float);
+
+static_assert(sizeof(TileMessageHeader) == 16, "TileMessageHeader layout");
+
+/** @brief Replace out with the wire encoding of msg. */
+void encodeTileMessage(const TileMessage& msg, std::vector<uint8_t>& out);
+/**
+ * @brief Append the particles of an encoded message to out.
+ * @return false (out unchanged) if the buffer is truncated, foreign or from a host of the other byte order
+ */
+bool decodeTileMessage(const uint8_t* data, size_t size, TileMessage& out);
+
+/**
+ * @class TiledSimulation
+ * @brief A world split into tiles that step independently and trade border particles.
+ */
+class TiledSimulation : public SimulationBackend {
+public:
+    /** Neighbour directions, indexed (dy + 1) * 3 + (dx + 1); 4 is the tile itself */
+    static constexpr int DIRECTIONS = 9;
+
+    /**
+     * @param worldW, worldH World size (shared by every tile)
+     * @param tilesX, tilesY Tile grid (at least 1 x 1)
+     */
+    TiledSimulation(float worldW, float worldH, int tilesX, int tilesY);
+
+    /**
+     * @brief Copy settings and wells from source into every tile and hand out its particles by position.
+     *
+     * Replaces whatever the tiles held before.
+     */
+    void load(const Simulation& source);
+
+    /** @brief Step tiles on count threads (0 = hardware concurrency, 1 = serial). */
+    void setThreadCount(int count);
+
+    /**
+     * @brief Border band copied to neighbours each step (0 = automatic).
+     *
+     * Automatic is the largest diameter plus the furthest any particle can
+     * move in a step, which covers every pair that can touch. It is capped
+     * at the smaller tile side, since ghosts only go to direct neighbours.
+     */
+    float haloWidth = 0.0f;
+
+    // SimulationBackend
+    void step(float dt) override;
+    void spawnBatch(Span<const Particle> batch) override;
+    size_t particleCount() const override;
+    SimulationStats stepStats() const override;
+    void sample(ParticleSample& out, size_t maxParticles) const override;
+    int threadCount() const override { return jobs_ ? jobs_->threadCount() : 1; }
+    size_t memoryBytes() const override;
+
+    int tilesX() const { return tilesX_; }
+    int tilesY() const { return tilesY_; }
+    /** @brief The Simulation of tile (tx, ty); holds only owned particles between steps. */
+    const Simulation& tile(int tx, int ty) const { return tiles_[(size_t)(ty * tilesX_ + tx)]->sim; }
+
+    /** @brief Ghost copies made in the most recent step. */
+    size_t ghostCount() const { return ghosts_; }
+    /** @brief Particles that changed tile in the most recent step. */
+    size_t migratedCount() const { return migrated_; }
+
+private:
+    struct Tile {
+        Simulation sim;
+        int tx = 0, ty = 0;                   ///< Position in the tile grid
+        Vec2 min, max;                        ///< Owned region [min, max)
+        TileMessage outbox[DIRECTIONS];       ///< Messages to each neighbour, filled by this tile
+        std::vector<uint8_t> sent[DIRECTIONS];///< outbox as encoded for the neighbour to decode
+        TileMessage inbox;                    ///< Scratch: messages received this exchange, decoded
+        std::vector<ParticleHandle> handles;  ///< Scratch: particles leaving in the migration
+    };
+
+    size_t indexOf(int tx, int ty) const { return (size_t)(ty * tilesX_ + tx); }
+    /** @brief Set every tile's bounds from the world size. */
+    void placeTiles();
+    /** @brief Tile column / row holding x / y (clamped to the grid). */
+    int columnOf(float x) const;
+    int rowOf(float y) const;
+    /**
+     * @brief Halo width for this step: haloWidth, or the automatic band.
+     *
+     * Capped at the tile side, since ghosts only reach adjacent tiles; warns
+     * the first time the automatic band is cut, as pairs further apart than
+     * a tile across a border are then missed.
+     */
+    float haloFor(float dt);
+    /** @brief Fill each tile's outbox ghosts with its particles within halo of a border. */
+    void sendGhosts(Tile& t, float halo);
+    /** @brief Move each tile's particles that left it into its outbox migrants. */
+    void sendMigrants(Tile& t);
+    /** @brief Encode every outbox message of t into its sent buffers. */
+    void encodeOutbox(Tile& t);
+    /**
+     * @brief Decode the messages addressed to tile (tx, ty) from its neighbours into its inbox.
+     * @return Leading inbox ghosts that came from lower-index tiles
+     */
+    size_t receive(int tx, int ty);
+    /** @brief Run fn(tx, ty) for every tile, on the pool when there is one. */
+    template <class Fn>
+    void forEachTile(const Fn& fn);
+
+    float worldW_, worldH_;
+    int tilesX_, tilesY_;
+    float tileW_, tileH_;
+    std::vector<std::unique_ptr<Tile>> tiles_;
+    std::unique_ptr<JobSystem> jobs_;      ///< Steps tiles concurrently; null when serial
+    size_t ghosts_ = 0;
+    size_t migrated_ = 0;
+    bool haloCapWarned_ = false;  ///< haloFor() has reported cutting the automatic halo
+};
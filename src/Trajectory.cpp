@@ -0,0 +1,105 @@
+/**
+ * @file Trajectory.cpp
+ * @brief Quantization and delta/varint/zero-run coding for trajectory blocks.
+ */
+
+#include "Trajectory.hpp"
+#include <algorithm>
+#include <cmath>
+
+const char TRAJECTORY_MAGIC[8] = { 'O', 'R', 'B', 'T', 'R', 'A', 'J', '1' };
+const char TRAJECTORY_INDEX_MAGIC[8] = { 'O', 'R', 'B', 'T', 'I', 'D', 'X', '1' };
+
+namespace {
+    /// Signed delta to unsigned with small magnitudes near zero (0, -1, 1, -2 -> 0, 1, 2, 3)
+    inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+    inline void putVarint(uint32_t v, std::vector<uint8_t>& out) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    inline const uint8_t* getVarint(const uint8_t* in, const uint8_t* end, uint32_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 35 && in < end; shift += 7) {
+            const uint8_t b = *in++;
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return in;
+        }
+        return nullptr;  // Ran off the end or more than 5 bytes
+    }
+
+    inline uint8_t toByte(float c) {
+        return (uint8_t)std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+    }
+}
+
+void quantizePositions(const float* v, size_t n, float extent, uint16_t* out) {
+    const float scale = extent > 0.0f ? TRAJECTORY_QUANT_MAX / extent : 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float q = v[i] * scale + 0.5f;
+        q = std::min(std::max(q, 0.0f), TRAJECTORY_QUANT_MAX);
+        out[i] = (uint16_t)q;
+    }
+}
+
+void dequantizePositions(const uint16_t* q, size_t n, float extent, float* out) {
+    const float scale = extent / TRAJECTORY_QUANT_MAX;
+    for (size_t i = 0; i < n; ++i)
+        out[i] = (float)q[i] * scale;
+}
+
+void encodeDeltas(const uint16_t* cur, const uint16_t* prev, size_t n, std::vector<uint8_t>& out) {
+    size_t zeroRun = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t d = (int32_t)cur[i] - (prev ? (int32_t)prev[i] : 0);
+        if (d == 0) {
+            ++zeroRun;
+            continue;
+        }
+        if (zeroRun > 0) {
+            out.push_back(0);  // Zero marker, then the run length
+            putVarint((uint32_t)zeroRun, out);
+            zeroRun = 0;
+        }
+        putVarint(zigzag(d), out);
+    }
+    if (zeroRun > 0) {
+        out.push_back(0);
+        putVarint((uint32_t)zeroRun, out);
+    }
+}
+
+const uint8_t* decodeDeltas(const uint8_t* in, const uint8_t* end, size_t n, uint16_t* values) {
+    size_t i = 0;
+    while (i < n) {
+        uint32_t code;
+        in = getVarint(in, end, code);
+        if (!in) return nullptr;
+        if (code == 0) {
+            uint32_t run;
+            in = getVarint(in, end, run);
+            if (!in || run == 0 || run > n - i) return nullptr;
+            i += run;  // Unchanged values
+        } else {
+            values[i] = (uint16_t)((int32_t)values[i] + unzigzag(code));
+            ++i;
+        }
+    }
+    return in;
+}
+
+uint32_t packColor(const Color& c) {
+    return (uint32_t)toByte(c.r) | ((uint32_t)toByte(c.g) << 8) | ((uint32_t)toByte(c.b) << 16)
+        | ((uint32_t)toByte(c.a) << 24);
+}
+
+Color unpackColor(uint32_t rgba) {
+    const float k = 1.0f / 255.0f;
+    return Color((float)(rgba & 0xFF) * k, (float)((rgba >> 8) & 0xFF) * k,
+                 (float)((rgba >> 16) & 0xFF) * k, (float)(rgba >> 24) * k);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file Trajectory.hpp
+ * @brief On-disk trajectory format shared by the recorder and the player.
+ *
+ * A trajectory file is a TrajectoryHeader, then one block per recorded
+ * step, then a keyframe index and a TrajectoryFooter:
+ *
+ * - Positions are quantized to uint16 fixed point relative to the frame's
+ *   world size (x / worldW * 65535), about 0.02 px at 1280 px.
+ * - A delta frame stores each quantized coordinate minus the previous
+ *   frame's, zigzag + varint coded, with runs of zero deltas collapsed to
+ *   a (0, run length) pair. Resting particles cost almost nothing.
+ * - A keyframe codes against zero and also carries radius (float), color
+ *   (RGBA8) and the gravity wells (uint32 count, then x, y, strength,
+ *   minRadius floats), so decoding can start at any keyframe. One is
+ *   written every keyframeInterval steps and whenever the particle count,
+ *   the layout (removals, clear), the well count or the world size changes.
+ * - The footer points at the keyframe index (step, file offset) so a
+ *   reader can seek without scanning the file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Math.hpp"
+
+/** Bump when the layout changes. */
+const uint32_t TRAJECTORY_VERSION = 2;
+/** Full-scale value of a quantized coordinate. */
+const float TRAJECTORY_QUANT_MAX = 65535.0f;
+
+/** File header (48 bytes). */
+struct TrajectoryHeader {
+    char magic[8];              ///< "ORBTRAJ1"
+    uint32_t version;           ///< TRAJECTORY_VERSION
+    uint32_t keyframeInterval;  ///< Steps between scheduled keyframes
+    uint32_t byteOrder;         ///< 0x01020304 as written
+    uint32_t reserved[7];
+};
+
+/** Per-step block header (40 bytes), followed by payloadBytes of payload. */
+struct TrajectoryBlock {
+    uint32_t tag;           ///< TRAJECTORY_BLOCK_TAG, to detect corruption
+    uint32_t flags;         ///< TRAJECTORY_KEYFRAME for keyframes
+    uint64_t step;          ///< Simulation step number
+    uint32_t particleCount;
+    uint32_t payloadBytes;
+    float worldW;           ///< Quantization scale for this block
+    float worldH;
+    float dt;               ///< Seconds simulated by this step
+    uint32_t reserved;
+};
+
+/** One keyframe index entry. */
+struct TrajectoryIndexEntry {
+    uint64_t step;
+    uint64_t offset;  ///< File offset of the keyframe's TrajectoryBlock
+};
+
+/** Last 24 bytes of the file. */
+struct TrajectoryFooter {
+    uint64_t indexOffset;    ///< File offset of the first TrajectoryIndexEntry
+    uint64_t keyframeCount;
+    char magic[8];           ///< "ORBTIDX1"
+};
+
+const uint32_t TRAJECTORY_BLOCK_TAG = 0x454D5246u;  // "FRME"
+const uint32_t TRAJECTORY_KEYFRAME = 1u;
+extern const char TRAJECTORY_MAGIC[8];
+extern const char TRAJECTORY_INDEX_MAGIC[8];
+
+static_assert(sizeof(TrajectoryHeader) == 48, "TrajectoryHeader layout");
+static_assert(sizeof(TrajectoryBlock) == 40, "TrajectoryBlock layout");
+static_assert(sizeof(TrajectoryFooter) == 24, "TrajectoryFooter layout");
+
+/** @brief Quantize n coordinates in [0, extent] to uint16. */
+void quantizePositions(const float* v, size_t n, float extent, uint16_t* out);
+/** @brief Inverse of quantizePositions. */
+void dequantizePositions(const uint16_t* q, size_t n, float extent, float* out);
+
+/**
+ * @brief Append the delta code of cur against prev (or against zero if prev is null).
+ * @param out Bytes are appended
+ */
+void encodeDeltas(const uint16_t* cur, const uint16_t* prev, size_t n, std::vector<uint8_t>& out);
+/**
+ * @brief Decode n values written by encodeDeltas, updating values in place.
+ * @param values Previous frame on entry (zeros for a keyframe), current frame on exit
+ * @return Pointer past the consumed bytes, or nullptr if the data is malformed
+ */
+const uint8_t* decodeDeltas(const uint8_t* in, const uint8_t* end, size_t n, uint16_t* values);
+
+/** @brief Pack a color as RGBA8 (keyframes only). */
+uint32_t packColor(const Color& c);
+/** @brief Inverse of packColor. */
+Color unpackColor(uint32_t rgba);
@@ -0,0 +1,67 @@
+/**
+ * @file UniformGrid.cpp
+ * @brief Implementation of the uniform-grid broadphase.
+ */
+
+#include "UniformGrid.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /// Upper bound on cells per particle; keeps sparse, spread-out scenes cheap to clear
+    const float MAX_CELLS_PER_PARTICLE = 4.0f;
+    const int MIN_CELL_BUDGET = 64;
+}
+
+void UniformGrid::build(const float* x, const float* y, size_t count, float minCellSize) {
+    const int n = (int)count;
+    cellOf.resize(n);
+    items.resize(n);
+    if (n == 0) {
+        cols = rows = 0;
+        cellStart.assign(1, 0);
+        return;
+    }
+
+    // Bounding box of all particle centres
+    float minX = x[0], maxX = minX;
+    float minY = y[0], maxY = minY;
+    for (int i = 1; i < n; ++i) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+
+    // Grow cells until the cell count fits the budget
+    cellSize = std::max(minCellSize, 1.0e-3f);
+    const float spanX = maxX - minX;
+    const float spanY = maxY - minY;
+    const float budget = std::max((float)MIN_CELL_BUDGET, MAX_CELLS_PER_PARTICLE * (float)n);
+    float cells = (spanX / cellSize + 1.0f) * (spanY / cellSize + 1.0f);
+    if (cells > budget)
+        cellSize *= std::sqrt(cells / budget);
+
+    originX = minX;
+    originY = minY;
+    cols = (int)(spanX / cellSize) + 1;
+    rows = (int)(spanY / cellSize) + 1;
+
+    // Counting sort: count per cell, prefix sum, scatter
+    const float invCell = 1.0f / cellSize;
+    cellStart.assign((size_t)cols * rows + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        int cx = std::min((int)((x[i] - originX) * invCell), cols - 1);
+        int cy = std::min((int)((y[i] - originY) * invCell), rows - 1);
+        int c = cellIndex(cx, cy);
+        cellOf[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c)
+        cellStart[c] += cellStart[c - 1];
+
+    // Scatter in particle order so each cell lists its particles ascending
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < n; ++i)
+        items[cursor[cellOf[i]]++] = i;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file UniformGrid.hpp
+ * @brief Uniform-grid broadphase for particle-particle collisions.
+ *
+ * Particles are bucketed into square cells with a counting sort, rebuilt every
+ * step. With the cell size at least twice the largest radius, any two
+ * overlapping particles are in the same or in adjacent cells, so the
+ * narrow-phase only has to look at a 3x3 neighbourhood.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct UniformGrid
+ * @brief Cell-sorted particle indices, laid out CSR-style.
+ *
+ * Particles of cell c are items[cellStart[c] .. cellStart[c + 1]).
+ * Buffers are kept between builds so steady-state rebuilds do not allocate.
+ */
+struct UniformGrid {
+    float cellSize = 1.0f;   ///< Edge length of a cell in world units
+    float originX = 0.0f;    ///< World X of the left edge of column 0
+    float originY = 0.0f;    ///< World Y of the top edge of row 0
+    int cols = 0;            ///< Number of cell columns
+    int rows = 0;            ///< Number of cell rows
+
+    std::vector<int> cellStart;  ///< Prefix offsets into items (cols * rows + 1 entries)
+    std::vector<int> items;      ///< Particle indices sorted by cell
+    std::vector<int> cellOf;     ///< Cell index of each particle
+    std::vector<int> cursor;     ///< Scatter cursors (scratch, reused between builds)
+
+    /**
+     * @brief Rebuild the grid around the current particle positions.
+     * @param x Particle centre X column
+     * @param y Particle centre Y column
+     * @param n Number of particles
+     * @param minCellSize Smallest allowed cell edge (normally 2 × max radius)
+     *
+     * The grid covers the bounding box of the particles, not the world, so
+     * particles that are briefly outside the walls are still bucketed. If the
+     * box is huge relative to the particle count, cells are grown to keep
+     * the cell array proportional to the number of particles.
+     */
+    void build(const float* x, const float* y, size_t n, float minCellSize);
+
+    /** @brief Cell index for a column/row pair (no bounds check). */
+    int cellIndex(int cx, int cy) const { return cy * cols + cx; }
+};
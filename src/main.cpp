@@ -6,19 +6,57 @@
  */
 
 #include "App.hpp"
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 /**
  * @brief Main entry point.
- * @param argc Command-line argument count (unused)
- * @param argv Command-line arguments (unused)
+ * @param argc Command-line argument count
+ * @param argv Command-line arguments:
+ *             --threads N   simulation threads (0 = all cores)
+ *             --pipelined   step the simulation on its own thread at a fixed rate
+ *             --gpu         step with OpenGL 4.3 compute shaders (falls back to the CPU)
+ *             --ccd         sweep fast particles so they cannot pass through each other
+ *             --capacity N  particles to preallocate (default 16384)
+ *             --world WxH   simulation bounds in world units (default: the window size)
+ *             --fps N       frame-rate cap (default: the display refresh rate; 0 = uncapped)
+ *             --record FILE stream every step to a trajectory file
+ *             --replay FILE play a recorded trajectory instead of simulating
  * @return 0 on success, 1 on initialization failure
  */
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
-
     App app;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            app.threadCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            app.particleCapacity = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%fx%f", &app.worldWidth, &app.worldHeight) != 2
+                || app.worldWidth <= 0.0f || app.worldHeight <= 0.0f) {
+                std::fprintf(stderr, "--world expects WxH, e.g. 8000x6000\n");
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            app.frameRate = std::max(0.0f, (float)std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            app.recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            app.replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--pipelined") == 0) {
+            app.pipelined = true;
+        } else if (std::strcmp(argv[i], "--gpu") == 0) {
+            app.useGpu = true;
+        } else if (std::strcmp(argv[i], "--ccd") == 0) {
+            app.continuousCollisions = true;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
     if (!app.init()) {
         std::fprintf(stderr, "App init failed.\n");
         return 1;